@@ -0,0 +1,340 @@
+#ifndef AutodartsBinary_h_
+#define AutodartsBinary_h_
+
+#include <array>
+#include <string.h>
+
+#include "AutodartsDefines.h"
+#include "AutodartsDetector.h"
+
+namespace autodarts {
+
+  static const uint8_t AUTODARTS_BINARY_MAGIC   = 0xAD;
+  static const uint8_t AUTODARTS_BINARY_VERSION = 1;
+
+  // Sections of a snapshot, only the parts that are selected by the change mask are encoded
+  static const ChangeMask AUTODARTS_BINARY_SECTIONS = Change::DETECTION_STATE | Change::DETECTION_EVENT |
+                                                      Change::THROWS | Change::CAMERA_STATE | Change::CAMERA_STATS;
+
+  // Header, detection, throws, camera state and the stats of all cameras
+  static const size_t AUTODARTS_BINARY_MAX_SIZE = 20 + 5 + (1 + 3*10) + 1 + (1 + 6*AUTODARTS_MAX_CAMERAS);
+
+  // Little endian writer into a caller provided buffer, ok() turns false once the buffer is too small
+  class BinaryWriter {
+  public:
+    BinaryWriter(uint8_t* buffer, size_t size) : _buffer(buffer), _size(size) {}
+
+    void writeU8(uint8_t value) {
+      if (_length + 1 > _size) {
+        _ok = false;
+        return;
+      }
+      _buffer[_length++] = value;
+    }
+
+    void writeI8(int8_t value) {
+      writeU8(static_cast<uint8_t>(value));
+    }
+
+    void writeU16(uint16_t value) {
+      writeU8(value & 0xFF);
+      writeU8(value >> 8);
+    }
+
+    void writeI16(int16_t value) {
+      writeU16(static_cast<uint16_t>(value));
+    }
+
+    void writeU32(uint32_t value) {
+      writeU16(value & 0xFFFF);
+      writeU16(value >> 16);
+    }
+
+    void writeFloat(float value) {
+      uint32_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      writeU32(bits);
+    }
+
+    void writeBytes(const uint8_t* data, size_t length) {
+      for (size_t idx = 0; idx < length; idx++) {
+        writeU8(data[idx]);
+      }
+    }
+
+    bool ok() const {
+      return _ok;
+    }
+
+    size_t length() const {
+      return _length;
+    }
+
+  private:
+    uint8_t* _buffer;
+    size_t   _size;
+    size_t   _length = 0;
+    bool     _ok = true;
+  };
+
+  // Counterpart of BinaryWriter, reads past the end return 0 and clear ok()
+  class BinaryReader {
+  public:
+    BinaryReader(const uint8_t* buffer, size_t length) : _buffer(buffer), _length(length) {}
+
+    uint8_t readU8() {
+      if (_offset + 1 > _length) {
+        _ok = false;
+        return 0;
+      }
+      return _buffer[_offset++];
+    }
+
+    int8_t readI8() {
+      return static_cast<int8_t>(readU8());
+    }
+
+    uint16_t readU16() {
+      uint16_t low = readU8();
+      return low | (static_cast<uint16_t>(readU8()) << 8);
+    }
+
+    int16_t readI16() {
+      return static_cast<int16_t>(readU16());
+    }
+
+    uint32_t readU32() {
+      uint32_t low = readU16();
+      return low | (static_cast<uint32_t>(readU16()) << 16);
+    }
+
+    float readFloat() {
+      uint32_t bits = readU32();
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+
+    void readBytes(uint8_t* data, size_t length) {
+      for (size_t idx = 0; idx < length; idx++) {
+        data[idx] = readU8();
+      }
+    }
+
+    bool ok() const {
+      return _ok;
+    }
+
+    size_t remaining() const {
+      return _length - _offset;
+    }
+
+  private:
+    const uint8_t* _buffer;
+    size_t         _length;
+    size_t         _offset = 0;
+    bool           _ok = true;
+  };
+
+  // State of a board in a fixed layout for other tasks or devices. A full snapshot
+  // selects all sections, a delta only those of the fields that changed.
+  //
+  // Version 1, all values little endian:
+  //   u8 magic 0xAD, u8 version, u16 change mask, 16 bytes board id
+  //   DETECTION_STATE|DETECTION_EVENT: u8 flags (bit 0 connected, bit 1 running),
+  //                                    i16 numThrows, i8 status, i8 event
+  //   THROWS:                          u8 count, per dart i8 number, i8 multiplier, f32 x, f32 y
+  //   CAMERA_STATE:                    u8 flags (bit 0 opened, bit 1 running)
+  //   CAMERA_STATS:                    u8 count, per camera i8 id, i8 fps, i16 width, i16 height
+  struct BoardSnapshot {
+    struct CameraSample {
+      int8_t  id = -1;
+      int8_t  fps = 0;
+      int16_t width = 0;
+      int16_t height = 0;
+    };
+
+    Uuid         board;
+    ChangeMask   changes = Change::NONE;
+
+    bool         connected = false;
+    bool         running = false;
+    int16_t      numThrows = 0;
+    Status::Code status = Status::Code::UNKNOWN;
+    Event::Code  event = Event::Code::UNKNOWN;
+
+    uint8_t              numStoredThrows = 0;
+    std::array<Throw, 3> throws;
+
+    bool         camerasOpened = false;
+    bool         camerasRunning = false;
+
+    uint8_t                                         numCameras = 0;
+    std::array<CameraSample, AUTODARTS_MAX_CAMERAS> cameras;
+
+    // Copies the sections in changes out of a detector
+    void fromDetector(const Uuid& id, const Detector& detector, ChangeMask mask = Change::ALL) {
+      board   = id;
+      changes = mask & AUTODARTS_BINARY_SECTIONS;
+
+      connected       = detector.isConnected();
+      running         = detector.isRunning();
+      numThrows       = detector.getNumThrows();
+      status          = detector.getStatus().value();
+      event           = detector.getEvent().value();
+      numStoredThrows = detector.getNumStoredThrows();
+      for (uint8_t idx = 0; idx < numStoredThrows; idx++) {
+        throws[idx] = detector.getThrow(idx);
+      }
+
+      const CameraSystem& system = detector.getCameraSystem();
+      camerasOpened  = system.isOpen();
+      camerasRunning = system.isRunning();
+      // Only cameras that have reported, every sample carries its id
+      numCameras     = 0;
+      for (uint8_t idx = 0; idx < system.getNumCameras(); idx++) {
+        if (!system.hasCamera(idx)) {
+          continue;
+        }
+        CameraSample& camera = cameras[numCameras++];
+        camera.id     = system[idx].getId();
+        camera.fps    = system[idx].getFPS();
+        camera.width  = system[idx].getWidth();
+        camera.height = system[idx].getHeight();
+      }
+    }
+
+    // Updates the detector like the matching board manager messages would, including
+    // its events, and returns the fields that changed
+    ChangeMask applyTo(Detector& detector) const {
+      ChangeMask state = Change::NONE;
+      if (changes & (Change::DETECTION_STATE | Change::DETECTION_EVENT)) {
+        state = detector.applyState(connected, running, numThrows, status, event);
+      }
+      if (changes & Change::THROWS) {
+        state |= detector.applyThrows(throws.data(), numStoredThrows);
+      }
+      detector.raiseState(state);
+
+      ChangeMask result = state;
+      CameraSystem& system = detector.getCameraSystem();
+      if (changes & Change::CAMERA_STATE) {
+        result |= system.applyState(camerasOpened, camerasRunning);
+      }
+      if (changes & Change::CAMERA_STATS) {
+        for (uint8_t idx = 0; idx < numCameras; idx++) {
+          const CameraSample& camera = cameras[idx];
+          result |= system.applyStats(camera.id, camera.fps, camera.width, camera.height);
+        }
+      }
+      return result;
+    }
+
+    // Returns the encoded length or 0 if the buffer is too small
+    size_t encode(uint8_t* buffer, size_t size) const {
+      BinaryWriter writer(buffer, size);
+      writer.writeU8(AUTODARTS_BINARY_MAGIC);
+      writer.writeU8(AUTODARTS_BINARY_VERSION);
+      writer.writeU16(changes);
+      writer.writeBytes(board.bytes.data(), board.bytes.size());
+
+      if (changes & (Change::DETECTION_STATE | Change::DETECTION_EVENT)) {
+        writer.writeU8((connected ? 1 : 0) | (running ? 2 : 0));
+        writer.writeI16(numThrows);
+        writer.writeI8(static_cast<int8_t>(status));
+        writer.writeI8(static_cast<int8_t>(event));
+      }
+      if (changes & Change::THROWS) {
+        writer.writeU8(numStoredThrows);
+        for (uint8_t idx = 0; idx < numStoredThrows; idx++) {
+          writer.writeI8(throws[idx].getNumber());
+          writer.writeI8(throws[idx].getMultiplier());
+          writer.writeFloat(throws[idx].getX());
+          writer.writeFloat(throws[idx].getY());
+        }
+      }
+      if (changes & Change::CAMERA_STATE) {
+        writer.writeU8((camerasOpened ? 1 : 0) | (camerasRunning ? 2 : 0));
+      }
+      if (changes & Change::CAMERA_STATS) {
+        writer.writeU8(numCameras);
+        for (uint8_t idx = 0; idx < numCameras; idx++) {
+          writer.writeI8(cameras[idx].id);
+          writer.writeI8(cameras[idx].fps);
+          writer.writeI16(cameras[idx].width);
+          writer.writeI16(cameras[idx].height);
+        }
+      }
+      return writer.ok() ? writer.length() : 0;
+    }
+
+    // Returns false for other versions, truncated buffers or counts beyond the limits
+    bool decode(const uint8_t* buffer, size_t length) {
+      BinaryReader reader(buffer, length);
+      if (!readHeader(reader, board, changes)) {
+        return false;
+      }
+
+      if (changes & (Change::DETECTION_STATE | Change::DETECTION_EVENT)) {
+        uint8_t flags = reader.readU8();
+        connected = flags & 1;
+        running   = flags & 2;
+        numThrows = reader.readI16();
+        status    = static_cast<Status::Code>(reader.readI8());
+        event     = static_cast<Event::Code>(reader.readI8());
+      }
+      if (changes & Change::THROWS) {
+        numStoredThrows = reader.readU8();
+        if (numStoredThrows > throws.size()) {
+          return false;
+        }
+        for (uint8_t idx = 0; idx < numStoredThrows; idx++) {
+          int8_t number     = reader.readI8();
+          int8_t multiplier = reader.readI8();
+          float  x          = reader.readFloat();
+          float  y          = reader.readFloat();
+          throws[idx] = Throw(number, multiplier, x, y);
+        }
+      }
+      if (changes & Change::CAMERA_STATE) {
+        uint8_t flags = reader.readU8();
+        camerasOpened  = flags & 1;
+        camerasRunning = flags & 2;
+      }
+      if (changes & Change::CAMERA_STATS) {
+        numCameras = reader.readU8();
+        if (numCameras > cameras.size()) {
+          return false;
+        }
+        for (uint8_t idx = 0; idx < numCameras; idx++) {
+          cameras[idx].id     = reader.readI8();
+          cameras[idx].fps    = reader.readI8();
+          cameras[idx].width  = reader.readI16();
+          cameras[idx].height = reader.readI16();
+        }
+      }
+      return reader.ok();
+    }
+
+    // Board id of an encoded snapshot without decoding it, empty if the header is invalid
+    static Uuid peekBoard(const uint8_t* buffer, size_t length) {
+      BinaryReader reader(buffer, length);
+      Uuid id;
+      ChangeMask mask;
+      return readHeader(reader, id, mask) ? id : Uuid();
+    }
+
+  private:
+    static bool readHeader(BinaryReader& reader, Uuid& id, ChangeMask& mask) {
+      if (reader.readU8() != AUTODARTS_BINARY_MAGIC || reader.readU8() != AUTODARTS_BINARY_VERSION) {
+        return false;
+      }
+      mask = reader.readU16() & AUTODARTS_BINARY_SECTIONS;
+      reader.readBytes(id.bytes.data(), id.bytes.size());
+      return reader.ok();
+    }
+  };
+
+} // autodarts
+
+#endif // AutodartsBinary_h_
@@ -1,6 +1,9 @@
 #ifndef AutodartsBoard_h_
 #define AutodartsBoard_h_
 
+#include <memory>
+#include <mutex>
+
 #include <ArduinoJson.h>
 
 #define ALTERNATE_WEBSOCKET
@@ -10,27 +13,38 @@
 #include <ArduinoWebsockets.h>
 #endif
 
+#include "AutodartsBinary.h"
 #include "AutodartsDefines.h"
 #include "AutodartsDetector.h"
+#include "AutodartsJournal.h"
+#include "AutodartsMetrics.h"
 
 namespace autodarts {
 
   class Board {
   public:
+    typedef StaticJsonDocument<AUTODARTS_MESSAGE_DOCUMENT> MessageDocument;
+
     Board() = delete;
+    Board(const Board&) = delete;
+    Board& operator=(const Board&) = delete;
 
     Board(const JsonObjectConst& json)  {
       fromJson(json);
+      attachSink();
     };
 
     Board(const String& name, const String& id, const String& version, const String& url) : 
-      _name(name), _id(id), _version(version), _url(url) {
-
+      _name(name), _version(intern(version.c_str())) {
+      setId(id);
+      setUrl(url);
+      attachSink();
     };
 
-    Board(const String& name, const String& id, const String& version, const IPAddress& address, uint16_t port = 3180) : 
-      _name(name), _id(id), _version(version) {
-      _url = String("ws://") + address.toString() + ':' + String(port);
+    Board(const String& name, const String& id, const String& version, const IPAddress& address, uint16_t port = AUTODARTS_BOARD_PORT) : 
+      _name(name), _address(address), _port(port), _version(intern(version.c_str())) {
+      setId(id);
+      attachSink();
     };
     
     String getName() const {
@@ -42,11 +56,23 @@ namespace autodarts {
     }
 
     String getId() const {
+      return _id.toString();
+    }
+
+    const Uuid& getUuid() const {
       return _id;
     }
 
     void setId(const String& id) {
-      _id = id;
+      if (!Uuid::fromString(id.c_str(), _id)) {
+        LOG_WARNING(_name.c_str(), F("Invalid board id: ") << id);
+        _id = Uuid();
+      }
+    }
+
+    bool hasId(const char* id) const {
+      Uuid uuid;
+      return Uuid::fromString(id, uuid) && uuid == _id;
     }
 
     String getVersion() const {
@@ -54,21 +80,117 @@ namespace autodarts {
     }
 
     void setVersion(const String& version) {
-      _version = version;
+      _version = intern(version.c_str());
     }
     
+    // Address of the board manager as "ip:port"
     String getUrl() const {
-      return _url;
+      if (_address == 0) {
+        return String();
+      }
+      return getAddress().toString() + ':' + String(_port);
     }
     
+    // Accepts "ip", "ip:port" and an optional scheme. Only IPv4 addresses are supported, a
+    // hostname or an empty host leaves the board without an address and it is never opened.
     void setUrl(const String& url) {
-      _url = url;
+      _address = 0;
+      _port = 0;
+
+      const char* begin = url.c_str();
+      const char* scheme = strstr(begin, "://");
+      if (scheme != nullptr) {
+        begin = scheme + 3;
+      }
+
+      const char* end = begin;
+      while (*end != '\0' && *end != ':' && *end != '/') {
+        end++;
+      }
+
+      char host[16];
+      size_t length = end - begin;
+      IPAddress address;
+      bool valid = length > 0 && length < sizeof(host);
+      if (valid) {
+        memcpy(host, begin, length);
+        host[length] = '\0';
+        valid = address.fromString(host);
+      }
+      if (!valid) {
+        LOG_WARNING(_name.c_str(), F("Unsupported board address: ") << url);
+        return;
+      }
+
+      _address = static_cast<uint32_t>(address);
+      _port = *end == ':' ? atoi(end + 1) : AUTODARTS_BOARD_PORT;
+    }
+
+    IPAddress getAddress() const {
+      return IPAddress(_address);
+    }
+
+    uint16_t getPort() const {
+      return _port;
+    }
+
+    // All events of the board are reported to listener, which has to outlive the board
+    void setListener(BoardListener* listener) {
+      _sink.listener = listener != nullptr ? listener : &defaultListener();
+    }
+
+    Detector& getDetector() {
+      return _detector;
+    }
+
+    // Match currently played on the board as reported by the cloud connection, empty if none
+    const Uuid& getMatchId() const {
+      return _matchId;
+    }
+
+    void setMatchId(const Uuid& matchId) {
+      _matchId = matchId;
+    }
+
+    const Detector& getDetector() const {
+      return _detector;
+    }
+
+    // micros() when the last message was received
+    uint32_t getReceivedAt() const {
+      return _sink.receivedAt;
+    }
+
+    // micros() when the last dart was parsed
+    uint32_t getParsedAt() const {
+      return _sink.parsedAt;
+    }
+
+    // Held by the network task while it updates the board, including the websocket I/O. Take
+    // it after the lock of the registry, the update never waits for that one.
+    std::recursive_mutex& getMutex() const {
+      return _mutex;
+    }
+
+    // Frame, error and connection counters for the metrics endpoint
+    const BoardMetrics& getMetrics() const {
+      return _metrics;
+    }
+
+    // Fields that were changed by the last received message
+    ChangeMask getChanges() const {
+      return _changes;
     }
 
     bool isOpen() const {
       return _open;
     }
 
+    // An attempt started by open() has neither succeeded nor failed yet
+    bool isConnecting() const {
+      return _connecting;
+    }
+
 #ifdef ALTERNATE_WEBSOCKET
     bool open(bool force = false) {
       // Check if already open
@@ -77,55 +199,47 @@ namespace autodarts {
       }
 
       // Check if url is valid
-      if (_url.isEmpty()) {
+      if (_address == 0) {
         return false;
       }
-
-      // Split url
-      int index = _url.indexOf(':');
-      String address = _url.substring(0, index);
-      int port = _url.substring(index+1).toInt();
+      _started = true;
+      _connecting = true;
+      _connectingSince = millis();
 
       // Open websocket
       LOG_DEBUG(_name.c_str(), F("Opening connection"));
-      _websocket.begin(address, port, "/api/events");
+      _websocket.begin(getAddress().toString(), _port, "/api/events");
 
       // Register event callback
       _websocket.onEvent([this](WStype_t type, uint8_t * payload, size_t length) {
         switch(type) {
-          case WStype_CONNECTED: {
-            LOG_DEBUG(_name.c_str(), F("Connection opened"));
-            _open = true;
-            _onConnectionChangeCallback(*this);
+          case WStype_CONNECTED:
+            record(JournalRecord::CONNECTED);
+            connectionChanged(true);
             break;
-          }
-          case WStype_DISCONNECTED: {
-            LOG_DEBUG(_name.c_str(), F("Connection closed"));
-            _open = false;
-            _onConnectionChangeCallback(*this);
+          case WStype_DISCONNECTED:
+            record(JournalRecord::DISCONNECTED);
+            connectionChanged(false);
             break;
-          }
-          case WStype_TEXT: {
-            LOG_DEBUG(_name.c_str(), F("Received data"));
-            DynamicJsonDocument json(2048);
-            deserializeJson(json, payload);
-            _detector.fromJson(json.as<JsonObjectConst>());
-            _onDataCallback(*this);
+          case WStype_TEXT:
+            record(JournalRecord::TEXT, payload, length);
+            receive(reinterpret_cast<char*>(payload), length);
             break;
-          }
           case WStype_BIN:
           case WStype_ERROR:		
           case WStype_FRAGMENT_TEXT_START:
           case WStype_FRAGMENT_BIN_START:
           case WStype_FRAGMENT:
           case WStype_FRAGMENT_FIN:
+          case WStype_PING:
+          case WStype_PONG:
             break;
         }
         resetAlive();
       });
 
-      // try ever 5000 again if connection has failed
-      _websocket.setReconnectInterval(5000);
+      // Retries are scheduled by the client, this only keeps the library from retrying within one attempt
+      _websocket.setReconnectInterval(AUTODARTS_CONNECT_TIMEOUT);
 
       return true;
     }
@@ -137,43 +251,85 @@ namespace autodarts {
       }
 
       // Check if url is valid
-      if (_url.isEmpty()) {
+      if (_address == 0) {
         return false;
       }
+      _started = true;
+      _connecting = true;
+      _connectingSince = millis();
 
       // Register message callback
       _websocket.onMessage([this](websockets::WebsocketsMessage message) {
-        LOG_DEBUG(_name.c_str(), F("Received data"));
-        DynamicJsonDocument json(2048);
-        deserializeJson(json, message.data());
-        _detector.fromJson(json.as<JsonObjectConst>());
-        _onDataCallback(*this);
+        String data = message.data();
+        record(JournalRecord::TEXT, reinterpret_cast<const uint8_t*>(data.c_str()), data.length());
+        receive(data.begin(), data.length());
         resetAlive();
       });
 
       // Register event callback
       _websocket.onEvent([this](websockets::WebsocketsEvent event, String data) {
         if(event == websockets::WebsocketsEvent::ConnectionOpened) {
-            LOG_DEBUG(_name.c_str(), F("Connection opened"));
-            _open = true;
-            _onConnectionChangeCallback(*this);
+            record(JournalRecord::CONNECTED);
+            connectionChanged(true);
         } else if(event == websockets::WebsocketsEvent::ConnectionClosed) {
-            LOG_DEBUG(_name.c_str(), F("Connection closed"));
-            _open = false;
-            _onConnectionChangeCallback(*this);
+            record(JournalRecord::DISCONNECTED);
+            connectionChanged(false);
         }
         resetAlive();
       });
 
       // Open websocket
       char websocketUrl[48];
-      sprintf(websocketUrl, AUTODARTS_WS_LOCAL_URL, _url.c_str());
-      return _websocket.connect(websocketUrl);
+      sprintf(websocketUrl, AUTODARTS_WS_LOCAL_URL, getUrl().c_str());
+      bool connected = _websocket.connect(websocketUrl);
+      _connecting = false;
+      return connected;
     }
 #endif
 
 
 
+    // Handles one message of the board manager, the payload is parsed in place and modified.
+    // Called by the websocket and by JournalReplay.
+    void receive(char* payload, size_t length) {
+      _sink.receivedAt = micros();
+      LOG_DEBUG(_name.c_str(), F("Received data"));
+      // New darts are raised before the full parse, which modifies the payload
+      ChangeMask changes = _detector.preScan(payload, length);
+      // Payload is mutable, so parse in place without copying strings. The document is kept
+      // until the board is closed, so only the first message of a connection allocates.
+      if (!_message) {
+        _message.reset(new MessageDocument());
+      }
+      JsonDocument& json = *_message;
+      DeserializationError err = deserializeJson(json, payload, length, DeserializationOption::Filter(messageFilter()));
+      if (err) {
+        LOG_ERROR(_name.c_str(), F("Could not deserialize message: ") << err.c_str());
+        _metrics.parseErrors.increment();
+        return;
+      }
+      _metrics.framesOf(Message::fromString(json["type"].as<const char*>())).increment();
+      _changes = changes | _detector.fromJson(json.as<JsonObjectConst>());
+      if (_changes) {
+        _sink.listener->onData(*this);
+      }
+    }
+
+    void connectionChanged(bool open) {
+      LOG_DEBUG(_name.c_str(), (open ? F("Connection opened") : F("Connection closed")));
+      _open = open;
+      _connecting = false;
+      if (open) {
+        _metrics.connects.increment();
+      }
+      _sink.listener->onConnectionChange(*this);
+    }
+
+    // Records the frames and connection changes of this board, nullptr stops recording
+    void setJournal(Journal* journal) {
+      _journal = journal;
+    }
+
     void close() {
 #ifdef ALTERNATE_WEBSOCKET
       _websocket.disconnect();
@@ -181,9 +337,32 @@ namespace autodarts {
       _websocket.close();
 #endif
       _open = false;
+      _connecting = false;
+      _message.reset();
+    }
+
+    // Reconnects to the current url if the board has been opened before
+    bool reopen() {
+      if (!_started) {
+        return false;
+      }
+      close();
+      return open(true);
     }
 
     bool update() {
+      // Closed boards wait until the reconnect scheduler opens them again
+      if (!_open && !_connecting) {
+        return false;
+      }
+
+      if (_connecting && millis() - _connectingSince > AUTODARTS_CONNECT_TIMEOUT) {
+        LOG_WARNING(_name.c_str(), F("Connection attempt timed out"));
+        _metrics.connectTimeouts.increment();
+        close();
+        return false;
+      }
+
 #ifdef ALTERNATE_WEBSOCKET
       _websocket.loop();
 #else
@@ -194,6 +373,7 @@ namespace autodarts {
 
       if (isOpen() && !isAlive()) {
         LOG_ERROR(_name.c_str(), F("Connection timeout!"));
+        _metrics.aliveTimeouts.increment();
         close();
       }
 
@@ -209,64 +389,101 @@ namespace autodarts {
     }
 
     void fromJson(const JsonObjectConst& root) {
-      _id      = String(root["id"].as<const char*>());
       _name    = String(root["name"].as<const char*>());
-      _url     = String(root["ip"].as<const char*>());
-      _version = String(root["version"].as<const char*>());
+      _version = intern(root["version"].as<const char*>());
+      setId(root["id"].as<const char*>());
+      setUrl(root["ip"].as<const char*>());
     }
 
     void toJson(JsonObject& root) const {
-      root["id"]      = _id.c_str();
+      root["id"]      = getId();
       root["name"]    = _name.c_str();
-      root["ip"]      = _url.c_str();
-      root["version"] = _version.c_str();
+      root["ip"]      = getUrl();
+      root["version"] = _version;
     }
 
-    void onData(BoardCallback callback) {
-      _onDataCallback = callback;
+    // Detector and camera state in the binary layout of AutodartsBinary.h, changes selects
+    // the sections of a delta. Returns the encoded length or 0 if the buffer is too small.
+    size_t toBinary(uint8_t* buffer, size_t size, ChangeMask changes = Change::ALL) const {
+      BoardSnapshot snapshot;
+      snapshot.fromDetector(_id, _detector, changes);
+      return snapshot.encode(buffer, size);
     }
 
-    void onConnectionChange(BoardCallback callback) {
-      _onConnectionChangeCallback = callback;
+    // Applies a snapshot or delta of this board with the same events as a received message
+    ChangeMask fromBinary(const uint8_t* buffer, size_t length) {
+      BoardSnapshot snapshot;
+      if (!snapshot.decode(buffer, length)) {
+        LOG_ERROR("Board", F("Could not decode binary snapshot"));
+        return Change::NONE;
+      }
+      if (snapshot.board != _id) {
+        LOG_WARNING("Board", F("Binary snapshot of another board: ") << snapshot.board.toString());
+        return Change::NONE;
+      }
+      _changes = snapshot.applyTo(_detector);
+      if (_changes) {
+        _sink.listener->onData(*this);
+      }
+      return _changes;
     }
 
-    void onCameraStats(CameraStatsCallback callback) {
-      _onCameraStatsCallback = callback;
+  private:
+    void record(JournalRecord type, const uint8_t* payload = nullptr, size_t length = 0) {
+      if (_journal != nullptr) {
+        _journal->record(_id, type, payload, length);
+      }
     }
 
-    void onCameraSystemState(CameraSystemStateCallback callback) {
-      _onCameraSystemStateCallback = callback;
+    static BoardListener& defaultListener() {
+      static BoardListener listener;
+      return listener;
     }
 
-    void onDetectionState(DetectionStateCallback callback) {
-      _onDetectionStateCallback = callback;
+    void attachSink() {
+      _sink.board    = this;
+      _sink.listener = &defaultListener();
+      _detector.setSink(&_sink);
     }
 
-    void onDetectionEvent(DetectionEventCallback callback) {
-      _onDetectionEventCallback = callback;
+    // Filter shared by all boards, only keeps the fields the detector evaluates. Built once
+    // by the initialization of the static, after that it is only read.
+    struct MessageFilter : StaticJsonDocument<JSON_OBJECT_SIZE(2)> {
+      MessageFilter() {
+        (*this)["type"] = true;
+        (*this)["data"] = true;
+      }
+    };
+
+    static const JsonDocument& messageFilter() {
+      static const MessageFilter filter;
+      return filter;
     }
 
-  private:
     String _name = "";
-    String _id = "";
-    String _url = "";
-    String _version = "";
+    Uuid _id;
+    Uuid _matchId;
+    uint32_t _address = 0;
+    uint16_t _port = 0;
+    const char* _version = "";
     bool _open = false;
+    bool _started = false;
+    bool _connecting = false;
+    uint32_t _connectingSince = 0;
+    ChangeMask _changes = Change::NONE;
     uint64_t _lastAlive = 0;
+    std::unique_ptr<MessageDocument> _message; // Only allocated while the board receives
+    EventSink _sink;
     Detector _detector;
+    Journal* _journal = nullptr;
+    BoardMetrics _metrics;
+    mutable std::recursive_mutex _mutex;
 
 #ifdef ALTERNATE_WEBSOCKET
     WebSocketsClient _websocket;
 #else
     websockets::WebsocketsClient _websocket;
 #endif
-
-    BoardCallback             _onDataCallback              = [this](const Board&){};
-    BoardCallback             _onConnectionChangeCallback  = [this](const Board&){};
-    CameraStatsCallback       _onCameraStatsCallback       = [this](int8_t, int8_t, int16_t, int16_t){};
-    CameraSystemStateCallback _onCameraSystemStateCallback = [this](State, State){};
-    DetectionStateCallback    _onDetectionStateCallback    = [this](State, State,  int16_t){};
-    DetectionEventCallback    _onDetectionEventCallback    = [this](Status::Code, Event::Code){};
   };
 } // autodarts
 
@@ -1,11 +1,88 @@
 #ifndef AutodartsCameras_h_
 #define AutodartsCameras_h_
 
+#include <algorithm>
+#include <array>
+
 #include <ArduinoJson.h>
 
 #include "AutodartsDefines.h"
 
 namespace autodarts {
+
+  // Frame rates of the last N stats messages. A histogram over the window keeps
+  // min, max and percentiles independent of N, the sum gives the mean.
+  template <uint8_t N>
+  class FpsHistory {
+  public:
+    void push(int8_t fps) {
+      if (fps < 0) {
+        return;
+      }
+      uint8_t value = std::min<uint8_t>(fps, AUTODARTS_CAMERA_MAX_FPS);
+
+      if (_size == N) {
+        uint8_t oldest = _samples[_head];
+        _counts[oldest]--;
+        _sum -= oldest;
+      }
+      else {
+        _size++;
+      }
+      _samples[_head] = value;
+      _counts[value]++;
+      _sum += value;
+      _head = (_head + 1) % N;
+    }
+
+    void clear() {
+      _counts.fill(0);
+      _sum = 0;
+      _size = 0;
+      _head = 0;
+    }
+
+    uint8_t size() const {
+      return _size;
+    }
+
+    float mean() const {
+      return _size > 0 ? static_cast<float>(_sum) / _size : 0;
+    }
+
+    int8_t min() const {
+      return percentile(0);
+    }
+
+    int8_t max() const {
+      return percentile(100);
+    }
+
+    // Nearest rank percentile, -1 without samples
+    int8_t percentile(uint8_t pct) const {
+      if (_size == 0) {
+        return -1;
+      }
+      uint16_t rank = std::max<uint16_t>(1, (static_cast<uint16_t>(pct) * _size + 99) / 100);
+      uint16_t seen = 0;
+      for (uint8_t value = 0; value <= AUTODARTS_CAMERA_MAX_FPS; value++) {
+        seen += _counts[value];
+        if (seen >= rank) {
+          return value;
+        }
+      }
+      return AUTODARTS_CAMERA_MAX_FPS;
+    }
+
+  private:
+    std::array<uint8_t, N> _samples;
+    std::array<uint8_t, AUTODARTS_CAMERA_MAX_FPS + 1> _counts{};
+    uint16_t _sum = 0;
+    uint8_t  _size = 0;
+    uint8_t  _head = 0;
+  };
+
+
   class Camera {
   public:
     int8_t getId() const {
@@ -24,43 +101,113 @@ namespace autodarts {
       return _height;
     }
 
+    CameraStats getStats() const {
+      CameraStats stats;
+      stats.id      = _id;
+      stats.fps     = _fps;
+      stats.width   = _width;
+      stats.height  = _height;
+      stats.samples = _history.size();
+      stats.minFps  = _history.min();
+      stats.maxFps  = _history.max();
+      stats.p95Fps  = _history.percentile(95);
+      stats.meanFps = _history.mean();
+      return stats;
+    }
+
+    bool isDegraded() const {
+      return _degraded;
+    }
+
+    // The camera counts as degraded while its mean FPS is below fps, 0 disables the check
+    void setDegradedThreshold(int8_t fps) {
+      _degradedFps = fps;
+      if (fps <= 0) {
+        _degraded = false;
+      }
+    }
+
     void fromJson(const JsonObjectConst& root) {
-      if (root["type"] == "cam_stats") {
-        _id     = root["data"]["id"];
-        _fps    = root["data"]["fps"];
-        _width  = root["data"]["resolution"]["width"];
-        _height = root["data"]["resolution"]["height"];
-        _onCameraStatsCallback(_id, _fps, _width, _height);
+      if (Message::fromString(root["type"]) == Message::Type::CAM_STATS) {
+        updateStats(root["data"]);
       }
       else {
-        LOG_WARNING("Camera", F("Unknown message type:") << root["type"].as<String>());
+        LOG_WARNING("Camera", F("Unknown message type:") << root["type"].as<const char*>());
       }
     }
 
+    ChangeMask updateStats(const JsonObjectConst& data) {
+      return applyStats(data["id"], data["fps"], data["resolution"]["width"], data["resolution"]["height"]);
+    }
+
+    ChangeMask applyStats(int8_t id, int8_t fps, int16_t width, int16_t height) {
+      ChangeMask changes = Change::NONE;
+      if (fps != _fps) {
+        changes |= Change::CAMERA_FPS;
+      }
+      if (width != _width || height != _height) {
+        changes |= Change::CAMERA_RESOLUTION;
+      }
+
+      _id     = id;
+      _fps    = fps;
+      _width  = width;
+      _height = height;
+      _history.push(fps);
+
+      if (changes && _sink != nullptr) {
+        _sink->listener->onCameraStats(*_sink->board, _id, _fps, _width, _height);
+      }
+      updateDegraded();
+      return changes;
+    }
+
     void toJson(JsonObject& root) const {
       JsonObject data = root.createNestedObject("data");
       data["id"] = _id;
       data["fps"] = _fps;
       data["resolution"]["width"] = _width;
       data["resolution"]["height"] = _height;
-      root["type"] = "cam_stats";
+      root["type"] = Message::toString(Message::Type::CAM_STATS);
     }
 
-    void onCameraStats(CameraStatsCallback callback) {
-      _onCameraStatsCallback = callback;
+    void setSink(const EventSink* sink) {
+      _sink = sink;
     }
 
   private:
+    // Needs a quarter of the window before judging, recovering needs one FPS above the threshold
+    void updateDegraded() {
+      if (_degradedFps <= 0 || _history.size() < AUTODARTS_CAMERA_HISTORY / 4) {
+        return;
+      }
+      float mean = _history.mean();
+      bool degraded = _degraded ? mean < _degradedFps + 1 : mean < _degradedFps;
+      if (degraded == _degraded) {
+        return;
+      }
+      _degraded = degraded;
+      LOG_WARNING("Camera", F("Camera ") << _id << (degraded ? F(" degraded, mean FPS: ") : F(" recovered, mean FPS: ")) << mean);
+      if (_sink != nullptr) {
+        _sink->listener->onCameraDegraded(*_sink->board, getStats(), degraded);
+      }
+    }
+
     int8_t  _id = -1;
     int8_t  _fps = -1;
     int16_t _width = -1;
     int16_t _height = -1;
+    int8_t  _degradedFps = 0;
+    bool    _degraded = false;
+    FpsHistory<AUTODARTS_CAMERA_HISTORY> _history;
 
-    CameraStatsCallback _onCameraStatsCallback = [](int8_t, int8_t, int16_t, int16_t){};
+    const EventSink* _sink = nullptr;
   };
 
 
   class CameraSystem {
+    static_assert(AUTODARTS_MAX_CAMERAS <= 8, "Seen cameras are kept in one byte");
+
   public:
     bool isOpen() const {
       return _isOpened;
@@ -70,17 +217,28 @@ namespace autodarts {
       return _isRunning;
     }
 
+    // One more than the highest camera id that has reported stats so far. Ids do not have
+    // to be contiguous, slots below it may be empty, see hasCamera().
     uint8_t getNumCameras() const {
-      return _cameras.size();
+      return _numCameras;
+    }
+
+    // True once the camera with this id has reported stats
+    bool hasCamera(int8_t id) const {
+      return id >= 0 && id < AUTODARTS_MAX_CAMERAS && (_seen & (1 << id));
+    }
+
+    static constexpr uint8_t getMaxCameras() {
+      return AUTODARTS_MAX_CAMERAS;
     }
 
+    // Camera ids are used as slot index
     Camera* getCameraById(int8_t id) {
-      for (auto it = _cameras.begin(); it < _cameras.end(); it++) {
-        if (it->getId() == id) {
-          return it;
-        }
-      }
-      return nullptr;
+      return hasCamera(id) ? &_cameras[id] : nullptr;
+    }
+
+    const Camera* getCameraById(int8_t id) const {
+      return hasCamera(id) ? &_cameras[id] : nullptr;
     }
 
     Camera& operator [](uint8_t idx) {
@@ -91,58 +249,111 @@ namespace autodarts {
       return _cameras[idx];
     }
 
-    void fromJson(const JsonObjectConst& root) {
-      if (root["type"] == "cam_state") {
-        LOG_DEBUG(__FUNCTION__, "Camera state changed");
-        _wasOpened  = _isOpened;
-        _wasRunning = _isRunning;
-        _isOpened   = root["data"]["isOpened"];
-        _isRunning  = root["data"]["isRunning"];
-        
+    // Copies the stats of up to size cameras that have reported into stats and returns how many were written
+    uint8_t getStats(CameraStats* stats, uint8_t size) const {
+      uint8_t count = 0;
+      for (uint8_t idx = 0; idx < _numCameras && count < size; idx++) {
+        if (hasCamera(idx)) {
+          stats[count++] = _cameras[idx].getStats();
+        }
+      }
+      return count;
+    }
+
+    void setDegradedThreshold(int8_t fps) {
+      for (Camera& camera : _cameras) {
+        camera.setDegradedThreshold(fps);
+      }
+    }
+
+    ChangeMask fromJson(const JsonObjectConst& root) {
+      return fromJson(Message::fromString(root["type"]), root);
+    }
+
+    ChangeMask fromJson(Message::Type type, const JsonObjectConst& root) {
+      switch (type) {
+        case Message::Type::CAM_STATE:
+          return updateState(root["data"]);
+        case Message::Type::CAM_STATS:
+          return updateStats(root["data"]);
+        default:
+          LOG_WARNING("CameraSystem", F("Unknown message type:") << root["type"].as<const char*>());
+          return Change::NONE;
+      }
+    }
+
+    ChangeMask updateState(const JsonObjectConst& data) {
+      LOG_DEBUG(__FUNCTION__, "Camera state changed");
+      return applyState(data["isOpened"], data["isRunning"]);
+    }
+
+    ChangeMask applyState(bool isOpened, bool isRunning) {
+      _wasOpened  = _isOpened;
+      _wasRunning = _isRunning;
+      _isOpened   = isOpened;
+      _isRunning  = isRunning;
+
+      ChangeMask changes = Change::NONE;
+      if (_isOpened != _wasOpened) {
+        changes |= Change::CAMERA_OPENED;
+      }
+      if (_isRunning != _wasRunning) {
+        changes |= Change::CAMERA_RUNNING;
+      }
+
+      if (changes && _sink != nullptr) {
         State opened  = static_cast<State>(2*_isOpened  - _wasOpened);
         State running = static_cast<State>(2*_isRunning - _wasRunning);
-        _onCameraSystemStateCallback(opened, running);
+        _sink->listener->onCameraSystemState(*_sink->board, opened, running);
       }
-      else if (root["type"] == "cam_stats") {
-        LOG_DEBUG(__FUNCTION__, "Camera stats");
-        int8_t id = root["data"]["id"];
-        if (id >= 0 && id < _cameras.size()) {
-          _cameras[id].fromJson(root);
+      return changes;
+    }
+
+    ChangeMask updateStats(const JsonObjectConst& data) {
+      LOG_DEBUG(__FUNCTION__, "Camera stats");
+      return applyStats(data["id"], data["fps"], data["resolution"]["width"], data["resolution"]["height"]);
+    }
+
+    ChangeMask applyStats(int8_t id, int8_t fps, int16_t width, int16_t height) {
+      if (id < 0 || id >= AUTODARTS_MAX_CAMERAS) {
+        // Every frame of the camera would warn, so only the first unsupported one does
+        if (!_warned) {
+          _warned = true;
+          LOG_WARNING("CameraSystem", F("Camera id ") << id << F(" exceeds AUTODARTS_MAX_CAMERAS, other ids are not reported"));
         }
+        return Change::NONE;
       }
-      else {
-        LOG_WARNING("CameraSystem", F("Unknown message type:") << root["type"].as<String>());
-      }
+      _numCameras = std::max<uint8_t>(_numCameras, id + 1);
+      _seen |= 1 << id;
+      return _cameras[id].applyStats(id, fps, width, height);
     }
 
     void toJson(JsonObject& root) const {
       JsonObject data = root.createNestedObject("data");
       data["isOpened"]  = _isOpened;
       data["isRunning"] = _isRunning;
-      root["type"]      = "cam_state";
+      root["type"]      = Message::toString(Message::Type::CAM_STATE);
     }
 
-    void onCameraStats(CameraStatsCallback callback) {
-      _onCameraStatsCallback = callback;
+    void setSink(const EventSink* sink) {
+      _sink = sink;
       for (Camera& camera : _cameras) {
-          camera.onCameraStats(_onCameraStatsCallback);
+        camera.setSink(sink);
       }
     }
 
-    void onCameraSystemState(CameraSystemStateCallback callback) {
-      _onCameraSystemStateCallback = callback;
-    }
-
   private:
-    std::array<Camera, 3> _cameras;
+    std::array<Camera, AUTODARTS_MAX_CAMERAS> _cameras;
+    uint8_t _numCameras = 0;
+    uint8_t _seen = 0;    // Bit per camera id that has reported stats
 
+    bool   _warned = false; // An unsupported camera id has been reported
     bool   _isOpened = false;
     bool   _isRunning = false;
     bool   _wasOpened = false;
     bool   _wasRunning = false;
 
-    CameraStatsCallback       _onCameraStatsCallback       = [](int8_t, int8_t, int16_t, int16_t){};
-    CameraSystemStateCallback _onCameraSystemStateCallback = [](State, State){};
+    const EventSink* _sink = nullptr;
   };
 
 } // autodarts
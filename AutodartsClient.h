@@ -1,8 +1,14 @@
-#include "HTTPClient.h"
-#include <memory>
 #ifndef AutodartsClient_h_
 #define AutodartsClient_h_
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <HTTPClient.h>
 #include <StreamUtils.h>
 
 #include <ArduinoJson.h>
@@ -10,222 +16,448 @@
 
 #include "AutodartsDefines.h"
 #include "AutodartsBoard.h"
+#include "AutodartsCloud.h"
+#include "AutodartsEvents.h"
+#include "AutodartsHttp.h"
+#include "AutodartsJournal.h"
+#include "AutodartsLatency.h"
+#include "AutodartsMetrics.h"
+#include "AutodartsQueue.h"
+#include "AutodartsReconnect.h"
+#include "AutodartsRegistry.h"
+#include "AutodartsRelay.h"
+#include "AutodartsReplay.h"
+#include "AutodartsStorage.h"
 
 namespace autodarts {
 
+  static const uint8_t AUTODARTS_CLIENT_TOPICS = 10; // Event topics of a client, ids 1 to 10
+
   class Client {
 
   public:
     typedef std::pair<String, uint64_t> Token;
-    typedef std::unique_ptr<Board> BoardPtr;
-    typedef std::vector<BoardPtr> BoardArray;
+    typedef BoardRegistry::BoardPtr BoardPtr;
+    typedef BoardRegistry::Handle BoardHandle;
+
+    Client() = default;
+
+    // The boards outlive the listeners of the client, closing their websockets raises nothing
+    ~Client() {
+#ifdef ESP32
+      stopNetworkTask();
+      cancelRequest();
+#endif
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      for (Board& board : _boards) {
+        board.setListener(nullptr);
+        board.setJournal(nullptr);
+      }
+    }
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
 
-    void addBoard(const JsonObjectConst& json)  {
+    BoardHandle addBoard(const JsonObjectConst& json)  {
       BoardPtr board(new Board(json));
-      board->onData(_onDataCallback);
-      board->onConnectionChange(_onConnectionChangeCallback);
-      board->onCameraStats(_onCameraStatsCallback);
-      board->onCameraSystemState(_onCameraSystemStateCallback);
-      board->onDetectionState(_onDetectionStateCallback);
-      board->onDetectionEvent(_onDetectionEventCallback);
-      _boards.push_back(std::move(board));
+      return addBoard(board);
     };
 
-    void addBoard(const String& name, const String& id, const String& version, const String& url) {
+    BoardHandle addBoard(const String& name, const String& id, const String& version, const String& url) {
       BoardPtr board(new Board(name, id, version, url));
-      board->onData(_onDataCallback);
-      board->onConnectionChange(_onConnectionChangeCallback);
-      board->onCameraStats(_onCameraStatsCallback);
-      board->onCameraSystemState(_onCameraSystemStateCallback);
-      board->onDetectionState(_onDetectionStateCallback);
-      board->onDetectionEvent(_onDetectionEventCallback);
-      _boards.push_back(std::move(board));
+      return addBoard(board);
     };
 
-    void addBoard(const String& name, const String& id, const String& version, const IPAddress& address, uint16_t port = 3180) {
+    BoardHandle addBoard(const String& name, const String& id, const String& version, const IPAddress& address, uint16_t port = AUTODARTS_BOARD_PORT) {
       BoardPtr board(new Board(name, id, version, address, port));
-      board->onData(_onDataCallback);
-      board->onConnectionChange(_onConnectionChangeCallback);
-      board->onCameraStats(_onCameraStatsCallback);
-      board->onCameraSystemState(_onCameraSystemStateCallback);
-      board->onDetectionState(_onDetectionStateCallback);
-      board->onDetectionEvent(_onDetectionEventCallback);
-      _boards.push_back(std::move(board));
+      return addBoard(board);
     }
 
-    void addBoard(BoardPtr& board) {
-      board->onData(_onDataCallback);
-      board->onConnectionChange(_onConnectionChangeCallback);
-      board->onCameraStats(_onCameraStatsCallback);
-      board->onCameraSystemState(_onCameraSystemStateCallback);
-      board->onDetectionState(_onDetectionStateCallback);
-      board->onDetectionEvent(_onDetectionEventCallback);
-      _boards.push_back(std::move(board));
+    // A board with the id of one the client already has is not added
+    BoardHandle addBoard(BoardPtr& board) {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      if (_boards.find(board->getUuid()) != BoardRegistry::INVALID) {
+        LOG_ERROR(__FUNCTION__, F("Board already exists: Name: ") << board->getName() << F(" Id: ") << board->getId());
+        return BoardRegistry::INVALID;
+      }
+      board->setListener(currentListener());
+      board->getDetector().getCameraSystem().setDegradedThreshold(_degradedFps);
+      board->setJournal(_journal.get());
+      BoardHandle handle = _boards.insert(std::move(board));
+      _reconnect.release(handle);
+      if (handle != BoardRegistry::INVALID) {
+        _boardsModified = true;
+        markAccountBoard(handle, false);
+        subscribeBoard(*_boards.get(handle));
+      }
+      return handle;
     }
 
-    void deleteBoard(int8_t idx) {
-      if (idx < _boards.size()) {
-        _boards.erase(_boards.begin() + idx);
+    void deleteBoard(BoardHandle handle) {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      if (_boards.get(handle) != nullptr) {
+        eraseBoard(handle);
       }
       else {
-        LOG_ERROR(__FUNCTION__, F("Index out of bounds!"));
+        LOG_ERROR(__FUNCTION__, F("Invalid board handle!"));
       }
 
     }
 
-    void printBoard(uint8_t idx) const {
-      if (idx < _boards.size()) {
-        LOG_INFO(_boards[idx]->getName().c_str(), F("Id: ") << _boards[idx]->getId() << F(" Url: ") << _boards[idx]->getUrl() << F(" Version: ") << _boards[idx]->getVersion());
+    BoardHandle findBoard(const char* id) const {
+      return _boards.find(id);
+    }
+
+    Board* getBoard(BoardHandle handle) const {
+      return _boards.get(handle);
+    }
+
+    size_t getNumBoards() const {
+      return _boards.size();
+    }
+
+    void printBoard(BoardHandle handle) const {
+      const Board* board = _boards.get(handle);
+      if (board != nullptr) {
+        LOG_INFO(board->getName().c_str(), F("Id: ") << board->getId() << F(" Url: ") << board->getUrl() << F(" Version: ") << board->getVersion());
       }
       else {
-        LOG_ERROR(__FUNCTION__, F("Index out of bounds!"));
+        LOG_ERROR(__FUNCTION__, F("Invalid board handle!"));
       }
     }
 
     void printBoards() const {
-      for (uint8_t idx = 0; idx < _boards.size(); idx++) {
-          printBoard(idx);
+      for (auto it = _boards.begin(); it != _boards.end(); ++it) {
+          printBoard(it.handle());
       }
     }
 
-    bool openBoard(uint8_t idx, bool force = false) const {
-      if (idx < _boards.size()) {
-        if (!_boards[idx]->open(force)) {
-          LOG_ERROR(__FUNCTION__, F("Could not open board: Name: ") << _boards[idx]->getName() << F(" Id: ") << _boards[idx]->getId() << F(" Url: ") << _boards[idx]->getUrl());
+    // Hands the board to the reconnect scheduler, which opens it and keeps it connected.
+    // With force an open connection is closed and the board is reconnected right away.
+    bool openBoard(BoardHandle handle, bool force = false) {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      Board* board = _boards.get(handle);
+      if (board != nullptr) {
+        if (board->getUrl().isEmpty()) {
+          LOG_ERROR(__FUNCTION__, F("Could not open board: Name: ") << board->getName() << F(" Id: ") << board->getId() << F(" Url: ") << board->getUrl());
           return false;
         }
+        if (force) {
+          closeBoard(*board);
+        }
+        _reconnect.request(handle, force);
       }
       else {
-        LOG_ERROR(__FUNCTION__, F("Index out of bounds!"));
+        LOG_ERROR(__FUNCTION__, F("Invalid board handle!"));
         return false;
       }
       return true;
     }
 
-    void openBoards(bool force = false) const {
-      for (uint8_t idx = 0; idx < _boards.size(); idx++) {
-          openBoard(idx, force);
+    void openBoards(bool force = false) {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      for (auto it = _boards.begin(); it != _boards.end(); ++it) {
+          openBoard(it.handle(), force);
       }
     }
 
-    bool updateBoard(uint8_t idx) const {
-      if (idx < _boards.size()) {
-        return _boards[idx]->update();
+    bool updateBoard(BoardHandle handle) const {
+      Board* board = _boards.get(handle);
+      if (board != nullptr) {
+        return board->update();
       }
       else {
-        LOG_ERROR(__FUNCTION__, F("Index out of bounds!"));
+        LOG_ERROR(__FUNCTION__, F("Invalid board handle!"));
         return false;
       }
       return true;
     }
 
-    void updateBoards() const {
-      for (uint8_t idx = 0; idx < _boards.size(); idx++) {
-        updateBoard(idx);
+    // Polls all boards, or only delivers the queued notifications if the network task is running
+    void updateBoards() {
+      processRequest();
+#ifdef ESP32
+      renewAccessToken();
+      updateCloud();
+#endif
+      if (_relay) {
+        _relay->update();
       }
+
+      if (isNetworkTaskRunning()) {
+        processNotifications();
+        return;
+      }
+
+      pollBoards();
+    }
+
+    void setReconnectPolicy(const ReconnectScheduler::Policy& policy) {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      _reconnect.setPolicy(policy);
+    }
+
+    const ReconnectScheduler::Policy& getReconnectPolicy() const {
+      return _reconnect.getPolicy();
+    }
+
+    // Number of connection attempts started by the reconnect scheduler
+    uint32_t getNumConnectAttempts() const {
+      return _reconnect.getNumAttempts();
+    }
+
+#ifdef ESP32
+    // Moves websocket polling and parsing to a dedicated task. Callbacks are
+    // queued and invoked from updateBoards() on the calling task.
+    bool startNetworkTask(BaseType_t core = 0, uint32_t stackSize = 8192, UBaseType_t priority = 1) {
+      if (isNetworkTaskRunning()) {
+        return true;
+      }
+
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      _networkTaskRunning = true;
+      setListener(currentListener());
+      TaskHandle_t task = nullptr;
+      if (xTaskCreatePinnedToCore(networkTask, "autodarts", stackSize, this, priority, &task, core) != pdPASS) {
+        LOG_ERROR(__FUNCTION__, F("Could not create network task"));
+        _networkTaskRunning = false;
+        setListener(currentListener());
+        return false;
+      }
+      _networkTask = task;
+      return true;
+    }
+
+    void stopNetworkTask() {
+      if (!isNetworkTaskRunning()) {
+        return;
+      }
+
+      _networkTaskRunning = false;
+      while (_networkTask != nullptr) {
+        delay(1);
+      }
+
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      processNotifications();
+      setListener(currentListener());
+    }
+#endif
+
+    bool isNetworkTaskRunning() const {
+      return _networkTaskRunning;
+    }
+
+    // Number of notifications lost because the queue was full
+    uint32_t getDroppedNotifications() const {
+      return _droppedNotifications;
     }
 
     int autoDetectBoards(const String& username, const String& password, bool forceUpdate = false) {
       // Get access token to connect to autodarts.io account
-      int ret = requestAccessToken(username, password, _accessToken, forceUpdate);
+      uint64_t expiry = _accessToken.second;
+      int ret = requestAccessToken(username, password, _accessToken, _refreshToken, forceUpdate);
       if (ret != HTTP_CODE_OK) {
         LOG_ERROR(__FUNCTION__, F("Could not get token to connect to autodarts.io"));
         return ret;
       }
 
       // Get boards from autodarts.io account
-      ret = requestBoards(_boards, _accessToken);
-      if (ret != HTTP_CODE_OK) {
+      String etag = _boardsETag;
+      ret = requestBoards(_accessToken);
+      if (ret != HTTP_CODE_OK && ret != HTTP_CODE_NOT_MODIFIED) {
         LOG_ERROR(__FUNCTION__, F("Could not get all boards from autodarts.io"));
         return ret;
       }
-      
+
+      persistChanges(_accessToken.second != expiry, !_boardsETag.equals(etag));
       return ret;
     }
 
-    int refreshBoards(const String& username, const String& password, uint64_t everyMillis) {
-      if (_lastChecked > 0 && (millis() - _lastChecked) < everyMillis) {
-        return HTTP_CODE_NOT_MODIFIED;
-      }
-      
-      _lastChecked = millis();
-      return autoDetectBoards(username, password);
+    // Storage used to keep token and boards across reboots, not owned by the client
+    void setStorage(Storage* storage) {
+      _storage = storage;
+    }
+
+    // Root certificate the servers of autodarts.io are verified against, not owned by the
+    // client. Until it or a bundle is set no connection to autodarts.io is opened.
+    void setCACert(const char* rootCA) {
+      _authSession.setCACert(rootCA);
+      _apiSession.setCACert(rootCA);
+      _cloud.setCACert(rootCA);
+    }
+
+    // Certificate bundle as made by gen_crt_bundle.py of ESP-IDF, not owned by the client
+    void setCACertBundle(const uint8_t* bundle) {
+      _authSession.setCACertBundle(bundle);
+      _apiSession.setCACertBundle(bundle);
+      _cloud.setCACertBundle(bundle);
     }
-/*
-    bool connect(const String& username, const String& password) {
-      if (requestAccessToken(username, password) != HTTP_CODE_OK) {
+
+    // Turns off the verification of autodarts.io, only for tests and trusted networks
+    void setInsecure() {
+      _authSession.setInsecure();
+      _apiSession.setInsecure();
+      _cloud.setInsecure();
+    }
+
+    // Loads token and boards from storage and optionally opens the boards right away
+    bool restore(bool open = true) {
+      if (_storage == nullptr) {
         return false;
       }
-      if (requestTicket()!= HTTP_CODE_OK) {
+
+      String value;
+      if (_storage->read(AUTODARTS_STORAGE_TOKEN, value)) {
+        DynamicJsonDocument doc(JSON_OBJECT_SIZE(4) + value.length());
+        if (!deserializeJson(doc, value)) {
+          // Expiry is kept as wall clock time, it is only valid if the clock has been set
+          time_t now = time(nullptr);
+          time_t expiresAt = doc["expires_at"];
+          time_t refreshExpiresAt = doc["refresh_expires_at"];
+          if (now > AUTODARTS_MIN_EPOCH && expiresAt > now) {
+            _accessToken.first  = String(doc["access_token"].as<const char*>());
+            _accessToken.second = millis() + static_cast<uint64_t>(expiresAt - now) * 1000;
+          }
+          // Without a clock, now or when it was stored, keycloak has to tell whether the refresh
+          // token is still valid
+          bool known = now > AUTODARTS_MIN_EPOCH && doc.containsKey("refresh_expires_at");
+          if (doc.containsKey("refresh_token") && (!known || refreshExpiresAt > now)) {
+            _refreshToken.first  = String(doc["refresh_token"].as<const char*>());
+            _refreshToken.second = known ? millis() + static_cast<uint64_t>(refreshExpiresAt - now) * 1000 : millis() + AUTODARTS_TOKEN_RENEW_MARGIN;
+          }
+        }
+      }
+
+      // Streamed one board at a time, so the document only has to hold a single board
+      bool restored = _storage->readStream(AUTODARTS_STORAGE_BOARDS, [this](Stream& in) {
+        DynamicJsonDocument doc(512);
+        if (!in.find('[')) {
+          return false;
+        }
+        while (in.peek() != ']') {
+          DeserializationError err = deserializeJson(doc, in);
+          if (err) {
+            LOG_ERROR(__FUNCTION__, F("Could not deserialize stored board: ") << err.c_str());
+            return false;
+          }
+          BoardHandle handle = mergeBoard(doc.as<JsonObjectConst>());
+          if (!(doc["account"] | true)) {
+            markAccountBoard(handle, false);
+          }
+          if (!in.findUntil(",", "]")) {
+            break;
+          }
+        }
+        return true;
+      });
+      if (!restored) {
         return false;
       }
-      
-      bool connected = _websocket.connect(AUTODARTS_WS_SECURE_URL + _ticket);
-      if (!connected) {
-        LOG_ERROR("connect", "Could not connect to websocket");
+      // The etag is only valid together with the stored list
+      String etag;
+      _storage->read(AUTODARTS_STORAGE_ETAG, etag);
+      _boardsETag = etag;
+      _boardsModified = false;
+      LOG_INFO(__FUNCTION__, F("Restored ") << _boards.size() << F(" boards"));
+
+      if (open) {
+        openBoards();
       }
+      return true;
+    }
 
-      _websocket.onMessage([this](websockets::WebsocketsMessage message) {
-        DynamicJsonDocument json(1024);
-        deserializeJson(json, message.data());
-        serializeJsonPretty(json, Serial);
-      });
+    bool persist() const {
+      if (_storage == nullptr) {
+        return false;
+      }
+      persistToken();
+      return persistBoards();
+    }
 
-      _websocket.onEvent([this](websockets::WebsocketsEvent event, String data) {
-        if(event == websockets::WebsocketsEvent::ConnectionOpened) {
-            Serial.print("Connnection Opened: ");
-        } else if(event == websockets::WebsocketsEvent::ConnectionClosed) {
-            Serial.print("Connnection Closed: ");
-        } else if(event == websockets::WebsocketsEvent::GotPing) {
-            Serial.print("Got a Ping: ");
-        } else if(event == websockets::WebsocketsEvent::GotPong) {
-            Serial.print("Got a Pong: ");
-        }
-      });
-      return connected;
+    int refreshBoards(const String& username, const String& password, uint64_t everyMillis) {
+      if (_lastChecked > 0 && (millis() - _lastChecked) < everyMillis) {
+        return HTTP_CODE_NOT_MODIFIED;
+      }
+      
+      _lastChecked = millis();
+      return autoDetectBoards(username, password);
     }
-*/
     int requestAccessToken(const String& username, const String& password, Token& accessToken, bool forceUpdate = false) const {
+      Token refreshToken;
+      return requestAccessToken(username, password, accessToken, refreshToken, forceUpdate);
+    }
+
+    // Renews the access token shortly before it expires. The refresh token grant is
+    // tried first, the password grant is only used if that is not possible or fails.
+    int requestAccessToken(const String& username, const String& password, Token& accessToken, Token& refreshToken, bool forceUpdate = false) const {
       // Check if token is still valid    
-      if (!forceUpdate && accessToken.second > millis()) {
+      if (!forceUpdate && accessToken.second > millis() + AUTODARTS_TOKEN_RENEW_MARGIN) {
         LOG_INFO(__FUNCTION__, F("Skip requesting new token"));
         return HTTP_CODE_OK;
       }
 
+      int ret = HTTP_CODE_UNAUTHORIZED;
+      if (!refreshToken.first.isEmpty() && refreshToken.second > millis()) {
+        String request = String(AUTODARTS_AUTH_KEYCLOAK_REFRESH_REQUEST) + refreshToken.first;
+        ret = requestToken(request, accessToken, refreshToken);
+        if (ret == HTTP_CODE_OK) {
+          return ret;
+        }
+        LOG_WARNING(__FUNCTION__, F("Could not refresh access token, falling back to login"));
+        refreshToken = Token();
+      }
+
+      if (username.isEmpty() || password.isEmpty()) {
+        LOG_ERROR(__FUNCTION__, F("No credentials to retrieve access token"));
+        return ret;
+      }
+
       // Assemble keycloak request
       char request[256];
       sprintf(request, AUTODARTS_AUTH_KEYCLOAK_REQUEST, username.c_str(), password.c_str());
+      return requestToken(request, accessToken, refreshToken);
+    }
 
+    int requestToken(const String& request, Token& accessToken, Token& refreshToken) const {
       // Send POST to keycloak to retrieve access token
-      HTTPClient httpClient;
-      httpClient.useHTTP10(true);
-      httpClient.begin(AUTODARTS_AUTH_KEYCLOAK_URL);
+      uint32_t start = micros();
+      HTTPClient& httpClient = _authSession.begin(AUTODARTS_AUTH_KEYCLOAK_URL);
       httpClient.addHeader(F("Content-Type"), F("application/x-www-form-urlencoded"));
-      int ret = httpClient.POST(request);
+      int ret = _authSession.send("POST", request);
       
       if (ret == HTTP_CODE_OK) {
         // Prepare filter   
-        DynamicJsonDocument filter(32);
+        DynamicJsonDocument filter(JSON_OBJECT_SIZE(4));
         filter["access_token"] = true;
         filter["expires_in"] = true;
+        filter["refresh_token"] = true;
+        filter["refresh_expires_in"] = true;
         
         // Read json from stream
         DynamicJsonDocument doc(4096);
-        DeserializationError err = deserializeJson(doc, httpClient.getStream(), DeserializationOption::Filter(filter));
+        DeserializationError err = deserializeJson(doc, _authSession.getStream(), DeserializationOption::Filter(filter));
 
         if (err) {
           LOG_ERROR(__FUNCTION__, F("Could not deserialize access token: ") << err.c_str());
+          _authSession.end();
+          recordHttp(HttpEndpoint::TOKEN, start, HTTP_CODE_INTERNAL_SERVER_ERROR);
           return HTTP_CODE_INTERNAL_SERVER_ERROR;
         }
 
         accessToken.first = String(doc["access_token"].as<const char*>());
         accessToken.second = millis() + doc["expires_in"].as<uint64_t>() * 1000;
+        if (doc.containsKey("refresh_token")) {
+          refreshToken.first = String(doc["refresh_token"].as<const char*>());
+          refreshToken.second = millis() + doc["refresh_expires_in"].as<uint64_t>() * 1000;
+        }
       }
       else {
-        LOG_ERROR(__FUNCTION__, F("Could not retrieve access token [") << ret << F("]: ") << httpClient.getString());
+        LOG_ERROR(__FUNCTION__, F("Could not retrieve access token [") << ret << F("]: ") << _authSession.getString());
       }
       
-      httpClient.end();
+      _authSession.end();
+      recordHttp(HttpEndpoint::TOKEN, start, ret);
       return ret;
     }
 
@@ -237,24 +469,44 @@ namespace autodarts {
       }
 
       // Send POST to retrieve ticket
-      HTTPClient httpClient;
-      httpClient.useHTTP10(true);
-      httpClient.begin(AUTODARTS_API_TICKET_URL);
+      uint32_t start = micros();
+      HTTPClient& httpClient = _apiSession.begin(AUTODARTS_API_TICKET_URL);
       httpClient.addHeader("Authorization", "Bearer " + accessToken.first);
-      int ret = httpClient.POST("");
+      int ret = _apiSession.send("POST");
       
       if (ret == HTTP_CODE_OK) {
-        ticket = httpClient.getString();
+        ticket = _apiSession.getString();
       }
       else {
-        LOG_ERROR(__FUNCTION__, F("Could not retrieve ticket [") << ret << F("]: ") << httpClient.getString());
+        LOG_ERROR(__FUNCTION__, F("Could not retrieve ticket [") << ret << F("]: ") << _apiSession.getString());
       }
       
-      httpClient.end();
+      _apiSession.end();
+      recordHttp(HttpEndpoint::TICKET, start, ret);
       return ret;
     }
 
-    int requestBoards(BoardArray& boards, const Token& accessToken) {
+    // Returns HTTP_CODE_NOT_MODIFIED without touching the boards if the list did not change
+    int requestBoards(const Token& accessToken) {
+      std::vector<bool> seen;
+      bool complete = false;
+      int ret = fetchBoards(accessToken, _boardsETag, [this, &seen](const JsonObjectConst& json) {
+        markSeen(seen, mergeBoard(json));
+      }, complete);
+
+      // Only a complete list tells which boards have been removed from the account
+      if (ret == HTTP_CODE_OK && complete) {
+        removeUnseenBoards(seen);
+      }
+      return ret;
+    }
+
+    // Streams the board list of the account and calls onBoard for every entry. The request
+    // is conditional on etag, which is updated once the list has been read completely.
+    // If some entries could not be read complete is false and etag is cleared, so that
+    // the next request gets the whole list again.
+    int fetchBoards(const Token& accessToken, String& etag, std::function<void(const JsonObjectConst&)> onBoard, bool& complete) const {
+      complete = false;
       // Check if input data is avialable
       if (accessToken.first.isEmpty() || accessToken.second < millis()) {
         LOG_ERROR(__FUNCTION__, F("Access token is invalid!"));
@@ -262,99 +514,1214 @@ namespace autodarts {
       }
 
       // Send POST to retrieve boards
-      HTTPClient httpClient;
-      httpClient.useHTTP10(true);
-      httpClient.begin(AUTODARTS_API_BOARDS_URL);
+      uint32_t start = micros();
+      HTTPClient& httpClient = _apiSession.begin(AUTODARTS_API_BOARDS_URL);
       httpClient.addHeader("Authorization", "Bearer " + accessToken.first);
-      int ret = httpClient.GET();
+      if (!etag.isEmpty()) {
+        httpClient.addHeader("If-None-Match", etag);
+      }
+      int ret = _apiSession.send("GET");
       
-      if (ret == HTTP_CODE_OK) {
+      if (ret == HTTP_CODE_NOT_MODIFIED) {
+        LOG_INFO(__FUNCTION__, F("Boards not modified"));
+      }
+      else if (ret == HTTP_CODE_OK) {
+        String responseETag = httpClient.header("ETag");
+
         // Prepare filter      
-        DynamicJsonDocument filter(80);
+        DynamicJsonDocument filter(JSON_OBJECT_SIZE(4));
         filter["id"] = true;
         filter["name"] = true;
         filter["ip"] = true;
         filter["version"] = true;
 
         // Read json from stream in chunks
-        httpClient.getStream().find('[');
-        do {
-          DynamicJsonDocument doc(1024);
-          DeserializationError err = deserializeJson(doc, httpClient.getStream(), DeserializationOption::Filter(filter));        
-          if (err) {
-            LOG_ERROR(__FUNCTION__, F("Could not deserialize board information: ") << err.c_str());
-            continue;
-          }
-
-          bool found = false;
-          const char* id = doc["id"];
-          // Check if board with the given id is already present
-          for (BoardPtr& board : boards) {
-            // If board already exists, only update data
-            if (board->getId().equals(id)) {
-              LOG_INFO(__FUNCTION__, F("Found an existing board [") << board->getName() << F("][") << board->getId() << F("]"));
-              board->fromJson(doc.as<JsonObject>());
-              found = true;
-              break;
-            }
-          }
-          // If no board with the given id is found add a new one
-          if (!found) {
-            BoardPtr board(new Board(doc.as<JsonObject>()));
-            if (board->getUrl().isEmpty()) {
-              LOG_WARNING(__FUNCTION__, F("Skipping board with empty url [") << board->getName() << F("][") << board->getId() << F("]"));
+        Stream& stream = _apiSession.getStream();
+        complete = stream.find('[');
+        if (complete && stream.peek() != ']') {
+          do {
+            DynamicJsonDocument doc(1024);
+            DeserializationError err = deserializeJson(doc, stream, DeserializationOption::Filter(filter));        
+            if (err) {
+              LOG_ERROR(__FUNCTION__, F("Could not deserialize board information: ") << err.c_str());
+              complete = false;
+              continue;
             }
-            else {
-              LOG_INFO(__FUNCTION__, F("Found a new board [")  << board->getName() << F("][") << board->getId() << F("]"));
-              addBoard(board);
-            }
-          }
-        } while (httpClient.getStream().findUntil(",", "]"));
+            onBoard(doc.as<JsonObjectConst>());
+          } while (stream.findUntil(",", "]"));
+        }
+
+        etag = complete ? responseETag : String();
       }
       else {
-        LOG_ERROR(__FUNCTION__, F("Could not retrieve boards [") << ret << F("]: ") << httpClient.getString());
+        LOG_ERROR(__FUNCTION__, F("Could not retrieve boards [") << ret << F("]: ") << _apiSession.getString());
       }
       
-      httpClient.end();
+      _apiSession.end();
+      recordHttp(HttpEndpoint::BOARDS, start, ret);
       return ret;
     }
 
-    void onData(BoardCallback callback) {
-      _onDataCallback = callback;
+    // Updates the board with the same id or adds a new one
+    BoardHandle mergeBoard(const JsonObjectConst& json) {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      BoardHandle handle = _boards.find(json["id"].as<const char*>());
+      Board* board = _boards.get(handle);
+      if (board != nullptr) {
+        // If board already exists, only update data
+        LOG_INFO(__FUNCTION__, F("Found an existing board [") << board->getName() << F("][") << board->getId() << F("]"));
+        std::lock_guard<std::recursive_mutex> boardLock(board->getMutex());
+        String name = board->getName();
+        String version = board->getVersion();
+        String url = board->getUrl();
+        board->fromJson(json);
+        if (!board->getName().equals(name) || !board->getVersion().equals(version) || !board->getUrl().equals(url)) {
+          _boardsModified = true;
+        }
+        // Only a board that moved has to reconnect, all other connections stay untouched
+        if (!board->getUrl().equals(url)) {
+          LOG_INFO(__FUNCTION__, F("Board moved to ") << board->getUrl() << F(" [") << board->getName() << F("][") << board->getId() << F("]"));
+          if (_reconnect.isRequested(handle)) {
+            closeBoard(*board);
+            _reconnect.request(handle, true);
+          }
+        }
+        return handle;
+      }
+
+      // If no board with the given id is found add a new one
+      BoardPtr added(new Board(json));
+      if (added->getUrl().isEmpty()) {
+        LOG_WARNING(__FUNCTION__, F("Skipping board with empty url [") << added->getName() << F("][") << added->getId() << F("]"));
+        return BoardRegistry::INVALID;
+      }
+      LOG_INFO(__FUNCTION__, F("Found a new board [")  << added->getName() << F("][") << added->getId() << F("]"));
+      handle = addBoard(added);
+      markAccountBoard(handle, true);
+      return handle;
+    }
+
+    // Closes and removes the boards of the account list that were not marked as seen,
+    // boards added by the application stay
+    void removeUnseenBoards(const std::vector<bool>& seen) {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      std::vector<BoardHandle> unseen;
+      for (auto it = _boards.begin(); it != _boards.end(); ++it) {
+        if (isAccountBoard(it.handle()) && (it.slot() >= seen.size() || !seen[it.slot()])) {
+          unseen.push_back(it.handle());
+        }
+      }
+      for (BoardHandle handle : unseen) {
+        Board* board = _boards.get(handle);
+        LOG_INFO(__FUNCTION__, F("Removing board [") << board->getName() << F("][") << board->getId() << F("]"));
+        eraseBoard(handle);
+      }
     }
 
-    void onConnectionChange(BoardCallback callback) {
-      _onConnectionChangeCallback = callback;
+#ifdef ESP32
+    // Runs autoDetectBoards on a worker task so the loop keeps serving the boards.
+    // The result is applied and callback invoked from updateBoards(). While another
+    // request runs this one waits behind it, only false if the task could not be created.
+    bool autoDetectBoardsAsync(const String& username, const String& password, HttpCallback callback, bool forceUpdate = false, uint32_t stackSize = 8192) {
+      return startRequest(username, password, callback, forceUpdate, Job::BOARDS, stackSize);
     }
 
-    void onCameraStats(CameraStatsCallback callback) {
-      _onCameraStatsCallback = callback;
+    // Renews the access token in the background, only the refresh token grant is used
+    bool renewAccessTokenAsync(HttpCallback callback = [](int){}, uint32_t stackSize = 8192) {
+      return startRequest(String(), String(), callback, true, Job::TOKEN, stackSize);
     }
 
-    void onCameraSystemState(CameraSystemStateCallback callback) {
-      _onCameraSystemStateCallback = callback;
+    int refreshBoardsAsync(const String& username, const String& password, uint64_t everyMillis, HttpCallback callback) {
+      if (isRequestPending() || (_lastChecked > 0 && (millis() - _lastChecked) < everyMillis)) {
+        return HTTP_CODE_NOT_MODIFIED;
+      }
+
+      _lastChecked = millis();
+      return autoDetectBoardsAsync(username, password, callback) ? HTTP_CODE_PROCESSING : HTTP_CODE_INTERNAL_SERVER_ERROR;
     }
+#endif
+
+#ifdef ESP32
+    // Keeps one websocket to autodarts.io open for the match events of all boards. It
+    // authenticates with a ticket, which needs a valid access token or refresh token.
+    void connectCloud() {
+      _cloud.onConnected([this]() {
+        std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+        for (const Board& board : _boards) {
+          subscribeBoard(board);
+        }
+      });
+      _cloud.onMessage([this](const JsonObjectConst& message) {
+        routeCloudMessage(message);
+      });
+      _cloud.setEnabled(true);
+    }
+
+    void disconnectCloud() {
+      _cloud.setEnabled(false);
+    }
+#endif
+
+    // Relay mode: serves the events of all boards to displays on the local network, which
+    // then do not need their own connections to the board managers
+    void startRelay(uint16_t port = AUTODARTS_RELAY_PORT) {
+      stopRelay();
+      _relay.reset(new RelayServer(_boards, _boardsMutex, port));
+      _relay->begin();
+    }
+
+    void stopRelay() {
+      if (_relay) {
+        _relay->stop();
+        _relay.reset();
+      }
+    }
+
+    const RelayServer* getRelay() const {
+      return _relay.get();
+    }
+
+    // Records the raw frames and connection changes of all boards to a file on LittleFS or SD
+    bool startJournal(fs::FS& fs, const char* path) {
+      stopJournal();
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      _journal.reset(new Journal());
+      if (!_journal->begin(fs, path)) {
+        _journal.reset();
+        return false;
+      }
+      for (Board& board : _boards) {
+        std::lock_guard<std::recursive_mutex> boardLock(board.getMutex());
+        board.setJournal(_journal.get());
+      }
+      return true;
+    }
+
+    void stopJournal() {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      for (Board& board : _boards) {
+        std::lock_guard<std::recursive_mutex> boardLock(board.getMutex());
+        board.setJournal(nullptr);
+      }
+      _journal.reset();
+    }
+
+    const Journal* getJournal() const {
+      return _journal.get();
+    }
+
+    // Feeds a recorded journal to the boards with the recorded ids, which should not be
+    // opened at the same time. Without realtime the frames are fed as fast as the updates run.
+    bool startReplay(fs::FS& fs, const char* path, bool realtime = true) {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      _replay.reset(new JournalReplay(_boards));
+      if (!_replay->begin(fs, path, realtime)) {
+        _replay.reset();
+        return false;
+      }
+      return true;
+    }
+
+    void stopReplay() {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      _replay.reset();
+    }
+
+    bool isReplaying() const {
+      return _replay != nullptr;
+    }
+
+    bool isCloudConnected() const {
+      return _cloud.isOpen();
+    }
+
+    bool isRequestPending() const {
+      return _request != nullptr || _queuedRequest != nullptr;
+    }
+
+    // Number of requests that needed a new TLS handshake
+    uint32_t getNumHandshakes() const {
+      return _authSession.getNumHandshakes() + _apiSession.getNumHandshakes();
+    }
+
+    // Number of requests that were sent over a kept alive connection
+    uint32_t getNumReusedRequests() const {
+      return _authSession.getNumReused() + _apiSession.getNumReused();
+    }
+
+    // Closes the kept alive connections, e.g. to free heap while idle
+    void closeSessions() {
+      _authSession.close();
+      _apiSession.close();
+    }
+
+    // Every call adds a listener, which applies to all boards including ones added later.
+    // Keep the returned subscription to remove the listener with unsubscribe().
+    // With the network task running, listeners that get a board are called with that
+    // board locked, so keep them short as the task waits for them to update it.
+    // Listeners capturing more than two pointers are allocated once, see Topic.
+    Subscription onData(BoardCallback callback, ChangeMask mask = Change::ALL) {
+      return _dataTopic.subscribe(std::move(callback), mask);
+    }
+
+    Subscription onConnectionChange(BoardCallback callback) {
+      return _connectionChangeTopic.subscribe(std::move(callback));
+    }
+
+    Subscription onCameraStats(CameraStatsCallback callback) {
+      return _cameraStatsTopic.subscribe(std::move(callback));
+    }
+
+    Subscription onCameraSystemState(CameraSystemStateCallback callback) {
+      return _cameraSystemStateTopic.subscribe(std::move(callback));
+    }
+
+    // Only raised after setCameraDegradedThreshold() enabled the check
+    Subscription onCameraDegraded(CameraDegradedCallback callback) {
+      return _cameraDegradedTopic.subscribe(std::move(callback));
+    }
+
+    // Cameras of all boards count as degraded while their rolling mean FPS is below fps, 0 disables the check
+    void setCameraDegradedThreshold(int8_t fps) {
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      _degradedFps = fps;
+      for (Board& board : _boards) {
+        std::lock_guard<std::recursive_mutex> boardLock(board.getMutex());
+        board.getDetector().getCameraSystem().setDegradedThreshold(fps);
+      }
+    }
+
+    Subscription onDetectionState(DetectionStateCallback callback) {
+      return _detectionStateTopic.subscribe(std::move(callback));
+    }
+
+    Subscription onDetectionEvent(DetectionEventCallback callback) {
+      return _detectionEventTopic.subscribe(std::move(callback));
+    }
+
+    Subscription onThrow(ThrowCallback callback) {
+      return _throwTopic.subscribe(std::move(callback));
+    }
+
+    // Called when a match starts or ends on a board, see Board::getMatchId()
+    Subscription onMatchChange(BoardCallback callback) {
+      return _matchChangeTopic.subscribe(std::move(callback));
+    }
+
+    // State of the match running on a board, only valid during the call
+    Subscription onMatchState(MatchStateCallback callback) {
+      return _matchStateTopic.subscribe(std::move(callback));
+    }
+
+    // Time spent by darts in each stage, recorded right before the throw listeners are called
+    const LatencyHistogram& getThrowLatency(LatencyStage stage) const {
+      return _throwLatency[static_cast<uint8_t>(stage)];
+    }
+
+    void resetThrowLatency() {
+      for (LatencyHistogram& histogram : _throwLatency) {
+        histogram.reset();
+      }
+    }
+
+    // Writes all metrics in the Prometheus text format, e.g. for a /metrics route of the
+    // web portal. Call it on the task that calls updateBoards(). The output is written one
+    // board at a time and without the boards locked, so it may go to the network directly.
+    void writeMetrics(Print& out) const {
+      static const char* topics[AUTODARTS_CLIENT_TOPICS] = {
+        "data", "connection_change", "camera_stats", "camera_system_state", "detection_state",
+        "detection_event", "throw", "camera_degraded", "match_change", "match_state"
+      };
+      static const char* endpoints[AUTODARTS_HTTP_ENDPOINTS] = { "token", "ticket", "boards" };
+      static const char* stages[AUTODARTS_LATENCY_STAGES] = { "parse", "dispatch", "total" };
+
+      PrometheusWriter writer(out);
+      writer.header("autodarts_frames_total", "counter", "Messages received from the board managers");
+      writeBoardSamples(out, [](PrometheusWriter& writer, const Board& board) {
+        for (int8_t type = -1; type <= static_cast<int8_t>(Message::Type::CAM_STATS); type++) {
+          Message::Type messageType = static_cast<Message::Type>(type);
+          String labels = boardLabels(board) + ",type=\"" + Message::toString(messageType) + "\"";
+          writer.sample("autodarts_frames_total", labels, board.getMetrics().frames[type + 1].get());
+        }
+      });
+      writer.header("autodarts_parse_errors_total", "counter", "Messages that could not be deserialized");
+      writeBoardSamples(out, [](PrometheusWriter& writer, const Board& board) {
+        writer.sample("autodarts_parse_errors_total", boardLabels(board), board.getMetrics().parseErrors.get());
+      });
+      writer.header("autodarts_connects_total", "counter", "Established connections to a board manager");
+      writeBoardSamples(out, [](PrometheusWriter& writer, const Board& board) {
+        writer.sample("autodarts_connects_total", boardLabels(board), board.getMetrics().connects.get());
+      });
+      writer.header("autodarts_timeouts_total", "counter", "Connections closed by a timeout");
+      writeBoardSamples(out, [](PrometheusWriter& writer, const Board& board) {
+        const BoardMetrics& metrics = board.getMetrics();
+        writer.sample("autodarts_timeouts_total", boardLabels(board) + ",reason=\"connect\"", metrics.connectTimeouts.get());
+        writer.sample("autodarts_timeouts_total", boardLabels(board) + ",reason=\"alive\"", metrics.aliveTimeouts.get());
+      });
+
+      uint32_t attempts;
+      uint32_t droppedRelay;
+      uint32_t droppedJournal;
+      {
+        std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+        attempts       = _reconnect.getNumAttempts();
+        droppedRelay   = _relay ? _relay->getDroppedMessages() : 0;
+        droppedJournal = _journal ? _journal->getDroppedRecords() : 0;
+      }
+      writer.header("autodarts_connect_attempts_total", "counter", "Connection attempts started by the reconnect scheduler");
+      writer.sample("autodarts_connect_attempts_total", "", attempts);
+
+      writer.header("autodarts_dropped_total", "counter", "Events and frames that were dropped");
+      writer.sample("autodarts_dropped_total", "queue=\"notifications\"", _droppedNotifications);
+      writer.sample("autodarts_dropped_total", "queue=\"relay\"", droppedRelay);
+      writer.sample("autodarts_dropped_total", "queue=\"journal\"", droppedJournal);
+
+      writer.header("autodarts_callback_duration_seconds", "histogram", "Time spent in the listeners of one event");
+      for (uint8_t idx = 0; idx < AUTODARTS_CLIENT_TOPICS; idx++) {
+        writer.histogram("autodarts_callback_duration_seconds", String("topic=\"") + topics[idx] + "\"", _callbackTime[idx]);
+      }
+      writer.header("autodarts_throw_latency_seconds", "histogram", "Latency of a new dart from the websocket to the callback");
+      for (uint8_t idx = 0; idx < AUTODARTS_LATENCY_STAGES; idx++) {
+        writer.histogram("autodarts_throw_latency_seconds", String("stage=\"") + stages[idx] + "\"", _throwLatency[idx]);
+      }
+      writer.header("autodarts_http_duration_seconds", "histogram", "Duration of the requests to autodarts.io");
+      for (uint8_t idx = 0; idx < AUTODARTS_HTTP_ENDPOINTS; idx++) {
+        writer.histogram("autodarts_http_duration_seconds", String("endpoint=\"") + endpoints[idx] + "\"", _httpLatency[idx]);
+      }
+      writer.header("autodarts_http_failures_total", "counter", "Requests to autodarts.io that did not succeed");
+      for (uint8_t idx = 0; idx < AUTODARTS_HTTP_ENDPOINTS; idx++) {
+        writer.sample("autodarts_http_failures_total", String("endpoint=\"") + endpoints[idx] + "\"", _httpFailures[idx].get());
+      }
 
-    void onDetectionState(DetectionStateCallback callback) {
-      _onDetectionStateCallback = callback;
+#ifdef ESP32
+      writer.header("autodarts_heap_free_bytes", "gauge", "Free heap");
+      writer.sample("autodarts_heap_free_bytes", "", ESP.getFreeHeap());
+      writer.header("autodarts_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+      writer.sample("autodarts_heap_min_free_bytes", "", ESP.getMinFreeHeap());
+      writer.header("autodarts_heap_max_alloc_bytes", "gauge", "Largest block that can be allocated");
+      writer.sample("autodarts_heap_max_alloc_bytes", "", ESP.getMaxAllocHeap());
+      if (_networkTask != nullptr) {
+        writer.header("autodarts_network_task_stack_free_bytes", "gauge", "Lowest free stack of the network task");
+        writer.sample("autodarts_network_task_stack_free_bytes", "", uxTaskGetStackHighWaterMark(_networkTask));
+      }
+#endif
     }
 
-    void onDetectionEvent(DetectionEventCallback callback) {
-      _onDetectionEventCallback = callback;
+    bool unsubscribe(Subscription subscription) {
+      return _dataTopic.unsubscribe(subscription)
+        || _connectionChangeTopic.unsubscribe(subscription)
+        || _cameraStatsTopic.unsubscribe(subscription)
+        || _cameraSystemStateTopic.unsubscribe(subscription)
+        || _cameraDegradedTopic.unsubscribe(subscription)
+        || _detectionStateTopic.unsubscribe(subscription)
+        || _detectionEventTopic.unsubscribe(subscription)
+        || _throwTopic.unsubscribe(subscription)
+        || _matchChangeTopic.unsubscribe(subscription)
+        || _matchStateTopic.unsubscribe(subscription);
     }
 
   private:
+    typedef std::pair<Uuid, BoardHandle> MatchBoard;
+
+    struct Notification {
+      enum class Type : uint8_t {
+        DATA,
+        CONNECTION_CHANGE,
+        CAMERA_STATS,
+        CAMERA_SYSTEM_STATE,
+        CAMERA_DEGRADED,
+        DETECTION_STATE,
+        DETECTION_EVENT,
+        THROW,
+      };
+
+      Type         type;
+      const Board* board;
+      ChangeMask   changes;
+      int8_t       id;
+      int8_t       fps;
+      int16_t      width;
+      int16_t      height;
+      State        first;
+      State        second;
+      int16_t      numThrows;
+      Status::Code status;
+      Event::Code  event;
+      Throw        dart;
+      CameraStats  cameraStats;
+      uint32_t     receivedAt;
+      uint32_t     parsedAt;
+    };
+
+    // Invokes the client callbacks right away on the task that updates the boards
+    class DirectListener : public BoardListener {
+    public:
+      DirectListener(Client& client) : _client(client) {}
+
+      void onData(const Board& board) override {
+        if (_client._relay) {
+          _client._relay->publish(board, board.getChanges());
+        }
+        _client._dataTopic.publishIf(board.getChanges(), board);
+      }
+
+      void onConnectionChange(const Board& board) override {
+        _client._connectionChangeTopic.publish(board);
+      }
+
+      void onCameraStats(const Board& board, int8_t id, int8_t fps, int16_t width, int16_t height) override {
+        if (_client._relay) {
+          _client._relay->publishStats(board, id);
+        }
+        _client._cameraStatsTopic.publish(id, fps, width, height);
+      }
+
+      void onCameraSystemState(const Board& board, State opened, State running) override {
+        _client._cameraSystemStateTopic.publish(opened, running);
+      }
+
+      void onCameraDegraded(const Board& board, const CameraStats& stats, bool degraded) override {
+        _client._cameraDegradedTopic.publish(board, stats, degraded);
+      }
+
+      void onDetectionState(const Board& board, State connected, State running, int16_t numThrows) override {
+        _client._detectionStateTopic.publish(connected, running, numThrows);
+      }
+
+      void onDetectionEvent(const Board& board, Status::Code status, Event::Code event) override {
+        _client._detectionEventTopic.publish(status, event);
+      }
+
+      void onThrow(const Board& board, uint8_t idx, const Throw& dart) override {
+        _client.recordThrowLatency(board.getReceivedAt(), board.getParsedAt());
+        _client._throwTopic.publish(board, idx, dart);
+      }
+
+    private:
+      Client& _client;
+    };
+
+    // Only queues a notification, the callbacks are invoked by processNotifications()
+    class DeferredListener : public BoardListener {
+    public:
+      DeferredListener(Client& client) : _client(client) {}
+
+      void onData(const Board& board) override {
+        Notification notification;
+        notification.type    = Notification::Type::DATA;
+        notification.board   = &board;
+        notification.changes = board.getChanges();
+        _client.pushNotification(notification);
+      }
+
+      void onConnectionChange(const Board& board) override {
+        Notification notification;
+        notification.type  = Notification::Type::CONNECTION_CHANGE;
+        notification.board = &board;
+        _client.pushNotification(notification);
+      }
+
+      void onCameraStats(const Board& board, int8_t id, int8_t fps, int16_t width, int16_t height) override {
+        Notification notification;
+        notification.type   = Notification::Type::CAMERA_STATS;
+        notification.board  = &board;
+        notification.id     = id;
+        notification.fps    = fps;
+        notification.width  = width;
+        notification.height = height;
+        _client.pushNotification(notification);
+      }
+
+      void onCameraSystemState(const Board& board, State opened, State running) override {
+        Notification notification;
+        notification.type   = Notification::Type::CAMERA_SYSTEM_STATE;
+        notification.board  = &board;
+        notification.first  = opened;
+        notification.second = running;
+        _client.pushNotification(notification);
+      }
+
+      void onCameraDegraded(const Board& board, const CameraStats& stats, bool degraded) override {
+        Notification notification;
+        notification.type        = Notification::Type::CAMERA_DEGRADED;
+        notification.board       = &board;
+        notification.cameraStats = stats;
+        notification.first       = degraded ? State::TURNED_TRUE : State::TURNED_FALSE;
+        _client.pushNotification(notification);
+      }
+
+      void onDetectionState(const Board& board, State connected, State running, int16_t numThrows) override {
+        Notification notification;
+        notification.type      = Notification::Type::DETECTION_STATE;
+        notification.board     = &board;
+        notification.first     = connected;
+        notification.second    = running;
+        notification.numThrows = numThrows;
+        _client.pushNotification(notification);
+      }
+
+      void onDetectionEvent(const Board& board, Status::Code status, Event::Code event) override {
+        Notification notification;
+        notification.type   = Notification::Type::DETECTION_EVENT;
+        notification.board  = &board;
+        notification.status = status;
+        notification.event  = event;
+        _client.pushNotification(notification);
+      }
+
+      void onThrow(const Board& board, uint8_t idx, const Throw& dart) override {
+        Notification notification;
+        notification.type       = Notification::Type::THROW;
+        notification.board      = &board;
+        notification.id         = idx;
+        notification.dart       = dart;
+        notification.receivedAt = board.getReceivedAt();
+        notification.parsedAt   = board.getParsedAt();
+        _client.pushNotification(notification);
+      }
+
+    private:
+      Client& _client;
+    };
+
+    BoardListener* currentListener() {
+      return isNetworkTaskRunning() ? static_cast<BoardListener*>(&_deferredListener) : &_directListener;
+    }
+
+    void setListener(BoardListener* listener) {
+      for (Board& board : _boards) {
+        board.setListener(listener);
+      }
+    }
+
+    enum class Job : uint8_t {
+      BOARDS,  // Token and board list
+      TOKEN,   // Token only
+      TICKET,  // Token and a ticket for the cloud connection
+    };
+
+    struct AsyncRequest {
+      Client*             client;
+      String              username;
+      String              password;
+      bool                forceUpdate = false;
+      Token               accessToken;
+      Token               refreshToken;
+      bool                newToken = false; // Only new tokens replace the ones of the client
+      Job                 job = Job::BOARDS;
+      String              ticket;
+      String              etag;
+      std::vector<String> boards;
+      bool                complete = false;
+      HttpCallback        callback;
+      uint32_t            stackSize = 8192;
+      int                 code = 0;
+      std::atomic<bool>   cancelled{false}; // The client is going away, no further step is started
+      std::atomic<bool>   done{false};
+    };
+
+    // Stores what a request changed: a new token, the board list if a board has been added,
+    // changed or removed since it was last stored, otherwise only a new etag. Renewing the
+    // token or the cloud ticket leaves the board list alone.
+    void persistChanges(bool newToken, bool newETag) const {
+      if (_storage == nullptr) {
+        return;
+      }
+      if (newToken) {
+        persistToken();
+      }
+      if (_boardsModified) {
+        persistBoards();
+      }
+      else if (newETag) {
+        persistETag();
+      }
+    }
+
+    // Expiries are stored as wall clock time. Until the clock is set only the refresh token is
+    // stored, without its expiry, and keycloak tells after a restart whether it is still valid.
+    void persistToken() const {
+      time_t now = time(nullptr);
+      bool clock = now > AUTODARTS_MIN_EPOCH;
+      bool access = clock && _accessToken.second > millis();
+      bool refresh = _refreshToken.second > millis();
+      if (!access && !refresh) {
+        return;
+      }
+      DynamicJsonDocument doc(256);
+      if (access) {
+        doc["access_token"]       = _accessToken.first.c_str();
+        doc["expires_at"]         = now + static_cast<time_t>((_accessToken.second - millis()) / 1000);
+      }
+      if (refresh) {
+        doc["refresh_token"]      = _refreshToken.first.c_str();
+        if (clock) {
+          doc["refresh_expires_at"] = now + static_cast<time_t>((_refreshToken.second - millis()) / 1000);
+        }
+      }
+      String value;
+      serializeJson(doc, value);
+      if (!_storage->write(AUTODARTS_STORAGE_TOKEN, value)) {
+        LOG_ERROR(__FUNCTION__, F("Could not store token"));
+      }
+    }
+
+    bool persistBoards() const {
+      // Streamed one board at a time instead of building the whole list in memory
+      bool ret = _storage->writeStream(AUTODARTS_STORAGE_BOARDS, [this](Print& out) {
+        DynamicJsonDocument doc(384);
+        bool first = true;
+        if (out.print('[') != 1) {
+          return false;
+        }
+        for (auto it = _boards.begin(); it != _boards.end(); ++it) {
+          JsonObject json = doc.to<JsonObject>();
+          it->toJson(json);
+          // Boards added by the application are kept when the account list changes
+          if (!isAccountBoard(it.handle())) {
+            json["account"] = false;
+          }
+          if ((!first && out.print(',') != 1) || serializeJson(doc, out) != measureJson(doc)) {
+            return false;
+          }
+          first = false;
+        }
+        return out.print(']') == 1;
+      });
+      if (!ret) {
+        LOG_ERROR(__FUNCTION__, F("Could not store ") << _boards.size() << F(" boards"));
+        _storage->remove(AUTODARTS_STORAGE_ETAG);
+        return false;
+      }
+      _boardsModified = false;
+      return persistETag();
+    }
+
+    // The etag is only valid together with the stored list
+    bool persistETag() const {
+      if (_boardsETag.isEmpty()) {
+        _storage->remove(AUTODARTS_STORAGE_ETAG);
+        return true;
+      }
+      if (!_storage->write(AUTODARTS_STORAGE_ETAG, _boardsETag)) {
+        LOG_ERROR(__FUNCTION__, F("Could not store boards etag"));
+        return false;
+      }
+      return true;
+    }
+
+    // Applies the result of a finished asynchronous request on the calling task
+    void processRequest() {
+      if (!_request || !_request->done) {
+        return;
+      }
+
+      std::unique_ptr<AsyncRequest> request(std::move(_request));
+      bool newETag = false;
+      if (request->newToken) {
+        _accessToken  = request->accessToken;
+        _refreshToken = request->refreshToken;
+      }
+      if (request->job == Job::TICKET) {
+        if (request->code == HTTP_CODE_OK && _cloud.isEnabled()) {
+          _cloud.connect(request->ticket);
+        }
+        else {
+          _cloud.failed();
+        }
+      }
+      else if (request->code == HTTP_CODE_OK && request->job == Job::BOARDS) {
+        std::vector<bool> seen;
+        DynamicJsonDocument doc(1024);
+        for (const String& json : request->boards) {
+          if (!deserializeJson(doc, json)) {
+            markSeen(seen, mergeBoard(doc.as<JsonObjectConst>()));
+          }
+        }
+        if (request->complete) {
+          removeUnseenBoards(seen);
+        }
+        newETag = !_boardsETag.equals(request->etag);
+        _boardsETag = request->etag;
+      }
+      if (request->code == HTTP_CODE_OK || request->code == HTTP_CODE_NOT_MODIFIED) {
+        persistChanges(request->newToken, newETag);
+      }
+#ifdef ESP32
+      if (_queuedRequest) {
+        HttpCallback callback = _queuedRequest->callback;
+        if (!launchRequest(std::move(_queuedRequest))) {
+          callback(HTTP_CODE_INTERNAL_SERVER_ERROR);
+        }
+      }
+#endif
+      request->callback(request->code);
+    }
+
+#ifdef ESP32
+    // Starts the request, or queues it behind the running one. A request that is still
+    // queued is replaced, its callback gets HTTP_CODE_CONFLICT.
+    bool startRequest(const String& username, const String& password, HttpCallback callback, bool forceUpdate, Job job, uint32_t stackSize) {
+      std::unique_ptr<AsyncRequest> request(new AsyncRequest());
+      request->client      = this;
+      request->username    = username;
+      request->password    = password;
+      request->forceUpdate = forceUpdate;
+      request->job         = job;
+      request->callback    = callback;
+      request->stackSize   = stackSize;
+
+      if (_request) {
+        if (_queuedRequest) {
+          LOG_WARNING(__FUNCTION__, F("Replacing the queued request"));
+          _queuedRequest->callback(HTTP_CODE_CONFLICT);
+        }
+        _queuedRequest = std::move(request);
+        return true;
+      }
+      return launchRequest(std::move(request));
+    }
+
+    // The request task works with the sessions of the client, so it has to finish before they
+    // are gone. The step it is in is completed, the callbacks are not called.
+    void cancelRequest() {
+      _queuedRequest.reset();
+      if (!_request) {
+        return;
+      }
+      _request->cancelled = true;
+      while (!_request->done) {
+        delay(1);
+      }
+      _request.reset();
+    }
+
+    // Tokens and ETag are taken when the task starts, so a queued request uses the newest
+    bool launchRequest(std::unique_ptr<AsyncRequest> request) {
+      request->accessToken  = _accessToken;
+      request->refreshToken = _refreshToken;
+      request->etag         = _boardsETag;
+
+      _request = std::move(request);
+      if (xTaskCreate(requestTask, "autodarts_http", _request->stackSize, _request.get(), 1, nullptr) != pdPASS) {
+        LOG_ERROR(__FUNCTION__, F("Could not create request task"));
+        _request.reset();
+        return false;
+      }
+      return true;
+    }
+
+    // Starts renewing the access token ahead of its expiry while a refresh token is available
+    void renewAccessToken() {
+      if (isRequestPending() || _refreshToken.first.isEmpty()) {
+        return;
+      }
+      uint64_t now = millis();
+      if (_accessToken.second > now + AUTODARTS_TOKEN_RENEW_MARGIN || _refreshToken.second < now) {
+        return;
+      }
+      if (_lastRenewal > 0 && (now - _lastRenewal) < AUTODARTS_TOKEN_RENEW_MARGIN / 2) {
+        return;
+      }
+      _lastRenewal = now;
+      renewAccessTokenAsync();
+    }
+
+    // Only works on the request, the client itself is not touched until processRequest()
+    static void requestTask(void* parameter) {
+      AsyncRequest* request = static_cast<AsyncRequest*>(parameter);
+      uint64_t expiry = request->accessToken.second;
+      request->code = request->client->requestAccessToken(request->username, request->password, request->accessToken, request->refreshToken, request->forceUpdate);
+      request->newToken = request->code == HTTP_CODE_OK && request->accessToken.second != expiry;
+      bool next = request->code == HTTP_CODE_OK && !request->cancelled;
+      if (next && request->job == Job::TICKET) {
+        request->code = request->client->requestTicket(request->ticket, request->accessToken);
+      }
+      else if (next && request->job == Job::BOARDS) {
+        request->code = request->client->fetchBoards(request->accessToken, request->etag, [request](const JsonObjectConst& json) {
+          String buffer;
+          serializeJson(json, buffer);
+          request->boards.push_back(buffer);
+        }, request->complete);
+      }
+      request->done = true;
+      vTaskDelete(nullptr);
+    }
+#endif
+
+#ifdef ESP32
+    // Requests a ticket whenever the cloud connection has to be opened again
+    void updateCloud() {
+      _cloud.update();
+      if (_cloud.needsTicket() && !isRequestPending()) {
+        startRequest(String(), String(), [](int){}, false, Job::TICKET, 8192);
+      }
+    }
+#endif
+
+    void subscribeBoard(const Board& board) {
+      if (_cloud.isOpen()) {
+        _cloud.subscribe(AUTODARTS_CLOUD_BOARDS_CHANNEL, board.getId() + ".matches");
+        if (!board.getMatchId().isEmpty()) {
+          _cloud.subscribe(AUTODARTS_CLOUD_MATCHES_CHANNEL, board.getMatchId().toString() + ".state");
+        }
+      }
+    }
+
+    void unsubscribeBoard(const Board& board) {
+      if (_cloud.isOpen()) {
+        _cloud.unsubscribe(AUTODARTS_CLOUD_BOARDS_CHANNEL, board.getId() + ".matches");
+        if (!board.getMatchId().isEmpty()) {
+          _cloud.unsubscribe(AUTODARTS_CLOUD_MATCHES_CHANNEL, board.getMatchId().toString() + ".state");
+        }
+      }
+    }
+
+    // Topics start with the id of the board or match, boards are found through the registry
+    // index, matches through the index of boards by match
+    void routeCloudMessage(const JsonObjectConst& message) {
+      const char* channel = message["channel"];
+      const char* topic   = message["topic"];
+      if (channel == nullptr || topic == nullptr || strlen(topic) < 36) {
+        return;
+      }
+      char buffer[37];
+      memcpy(buffer, topic, 36);
+      buffer[36] = '\0';
+      Uuid id;
+      if (!Uuid::fromString(buffer, id)) {
+        return;
+      }
+
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      JsonObjectConst data = message["data"];
+      if (strcmp(channel, AUTODARTS_CLOUD_BOARDS_CHANNEL) == 0) {
+        BoardHandle handle = _boards.find(id);
+        Board* board = _boards.get(handle);
+        if (board == nullptr || strcmp(topic + 36, ".matches") != 0) {
+          return;
+        }
+        // Only a start or an explicit end changes the match, other events are ignored
+        Uuid matchId = board->getMatchId();
+        const char* event = data["event"] | "";
+        if (strcmp(event, "start") == 0) {
+          matchId = Uuid();
+          Uuid::fromString(data["id"].as<const char*>(), matchId);
+        }
+        else if (strcmp(event, "finish") == 0 || strcmp(event, "end") == 0 || strcmp(event, "delete") == 0) {
+          // The end of another match, e.g. an older one, leaves the current match
+          Uuid ended;
+          if (!Uuid::fromString(data["id"].as<const char*>(), ended) || ended == matchId) {
+            matchId = Uuid();
+          }
+        }
+        if (matchId == board->getMatchId()) {
+          return;
+        }
+        if (!board->getMatchId().isEmpty()) {
+          _cloud.unsubscribe(AUTODARTS_CLOUD_MATCHES_CHANNEL, board->getMatchId().toString() + ".state");
+          unindexMatch(board->getMatchId(), handle);
+        }
+        board->setMatchId(matchId);
+        if (!matchId.isEmpty()) {
+          _cloud.subscribe(AUTODARTS_CLOUD_MATCHES_CHANNEL, matchId.toString() + ".state");
+          indexMatch(matchId, handle);
+        }
+        LOG_INFO(board->getName().c_str(), F("Match changed: ") << matchId.toString());
+        std::lock_guard<std::recursive_mutex> boardLock(board->getMutex());
+        _matchChangeTopic.publish(*board);
+      }
+      else if (strcmp(channel, AUTODARTS_CLOUD_MATCHES_CHANNEL) == 0) {
+        // By position, a listener may delete a board
+        size_t pos = std::lower_bound(_matchBoards.begin(), _matchBoards.end(), MatchBoard(id, 0)) - _matchBoards.begin();
+        for (; pos < _matchBoards.size() && _matchBoards[pos].first == id; pos++) {
+          const Board* board = _boards.get(_matchBoards[pos].second);
+          std::lock_guard<std::recursive_mutex> boardLock(board->getMutex());
+          _matchStateTopic.publish(*board, data);
+        }
+      }
+    }
+
+    void indexMatch(const Uuid& matchId, BoardHandle handle) {
+      MatchBoard entry(matchId, handle);
+      _matchBoards.insert(std::lower_bound(_matchBoards.begin(), _matchBoards.end(), entry), entry);
+    }
+
+    void unindexMatch(const Uuid& matchId, BoardHandle handle) {
+      MatchBoard entry(matchId, handle);
+      auto it = std::lower_bound(_matchBoards.begin(), _matchBoards.end(), entry);
+      if (it != _matchBoards.end() && *it == entry) {
+        _matchBoards.erase(it);
+      }
+    }
+
+    // Closes the board on the task that delivers the notifications. The queue and the journal
+    // are only fed by the network task, so while it runs the board is closed without them and
+    // its connection change is delivered here, after the notifications queued before it.
+    // Call with the boards locked.
+    void closeBoard(Board& board) {
+      // Waits for an update of the network task, which needs the registry to take the board again
+      std::lock_guard<std::recursive_mutex> boardLock(board.getMutex());
+      if (!isNetworkTaskRunning()) {
+        board.close();
+        return;
+      }
+      bool open = board.isOpen();
+      board.setListener(nullptr);
+      board.setJournal(nullptr);
+      board.close();
+      board.setListener(&_deferredListener);
+      board.setJournal(_journal.get());
+      if (open) {
+        processNotifications();
+        _directListener.onConnectionChange(board);
+      }
+    }
+
+    // Closes the board while it still reports to the listener, so the notifications of
+    // the closed connection are delivered before the board they point to is gone.
+    // Destroying the websocket later raises nothing. Call with the boards locked.
+    void eraseBoard(BoardHandle handle) {
+      Board* board = _boards.get(handle);
+      {
+        std::lock_guard<std::recursive_mutex> boardLock(board->getMutex());
+        closeBoard(*board);
+        board->setListener(nullptr);
+        board->setJournal(nullptr);
+      }
+      processNotifications();
+      _reconnect.release(handle);
+      unsubscribeBoard(*board);
+      if (!board->getMatchId().isEmpty()) {
+        unindexMatch(board->getMatchId(), handle);
+      }
+      _boards.erase(handle);
+      _boardsModified = true;
+    }
+
+    bool isAccountBoard(BoardHandle handle) const {
+      uint16_t slot = BoardRegistry::slot(handle);
+      return slot < _accountBoards.size() && _accountBoards[slot];
+    }
+
+    void markAccountBoard(BoardHandle handle, bool account) {
+      if (handle == BoardRegistry::INVALID) {
+        return;
+      }
+      uint16_t slot = BoardRegistry::slot(handle);
+      if (slot >= _accountBoards.size()) {
+        _accountBoards.resize(slot + 1, false);
+      }
+      _accountBoards[slot] = account;
+    }
+
+    static void markSeen(std::vector<bool>& seen, BoardHandle handle) {
+      if (handle == BoardRegistry::INVALID) {
+        return;
+      }
+      uint16_t slot = BoardRegistry::slot(handle);
+      if (slot >= seen.size()) {
+        seen.resize(slot + 1, false);
+      }
+      seen[slot] = true;
+    }
+
+    void recordThrowLatency(uint32_t receivedAt, uint32_t parsedAt) {
+      uint32_t now = micros();
+      _throwLatency[static_cast<uint8_t>(LatencyStage::PARSE)].record(parsedAt - receivedAt);
+      _throwLatency[static_cast<uint8_t>(LatencyStage::DISPATCH)].record(now - parsedAt);
+      _throwLatency[static_cast<uint8_t>(LatencyStage::TOTAL)].record(now - receivedAt);
+    }
+
+    void pushNotification(const Notification& notification) {
+      if (!_notifications.push(notification)) {
+        _droppedNotifications++;
+      }
+    }
+
+    void processNotifications() {
+      Notification notification;
+      while (_notifications.pop(notification)) {
+        switch (notification.type) {
+          case Notification::Type::DATA: {
+            // The network task may be updating the board while the listeners read it
+            std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+            std::lock_guard<std::recursive_mutex> boardLock(notification.board->getMutex());
+            if (_relay) {
+              _relay->publish(*notification.board, notification.changes);
+            }
+            _dataTopic.publishIf(notification.changes, *notification.board);
+            break;
+          }
+          case Notification::Type::CONNECTION_CHANGE: {
+            std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+            std::lock_guard<std::recursive_mutex> boardLock(notification.board->getMutex());
+            _connectionChangeTopic.publish(*notification.board);
+            break;
+          }
+          case Notification::Type::CAMERA_STATS:
+            if (_relay) {
+              std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+              std::lock_guard<std::recursive_mutex> boardLock(notification.board->getMutex());
+              _relay->publishStats(*notification.board, notification.id);
+            }
+            _cameraStatsTopic.publish(notification.id, notification.fps, notification.width, notification.height);
+            break;
+          case Notification::Type::CAMERA_SYSTEM_STATE:
+            _cameraSystemStateTopic.publish(notification.first, notification.second);
+            break;
+          case Notification::Type::CAMERA_DEGRADED: {
+            std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+            std::lock_guard<std::recursive_mutex> boardLock(notification.board->getMutex());
+            _cameraDegradedTopic.publish(*notification.board, notification.cameraStats, notification.first == State::TURNED_TRUE);
+            break;
+          }
+          case Notification::Type::DETECTION_STATE:
+            _detectionStateTopic.publish(notification.first, notification.second, notification.numThrows);
+            break;
+          case Notification::Type::DETECTION_EVENT:
+            _detectionEventTopic.publish(notification.status, notification.event);
+            break;
+          case Notification::Type::THROW: {
+            recordThrowLatency(notification.receivedAt, notification.parsedAt);
+            std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+            std::lock_guard<std::recursive_mutex> boardLock(notification.board->getMutex());
+            _throwTopic.publish(*notification.board, notification.id, notification.dart);
+            break;
+          }
+        }
+      }
+    }
+
+    // The boards are only locked while the lines of one board are put together
+    template <typename TFunction>
+    void writeBoardSamples(Print& out, TFunction function) const {
+      for (size_t slot = 0; ; slot++) {
+        MetricsBuffer lines;
+        {
+          std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+          if (slot >= _boards.capacity()) {
+            break;
+          }
+          const Board* board = _boards.get(_boards.handleAt(slot));
+          if (board == nullptr) {
+            continue;
+          }
+          std::lock_guard<std::recursive_mutex> boardLock(board->getMutex());
+          PrometheusWriter writer(lines);
+          function(writer, *board);
+        }
+        out.print(lines.getText());
+      }
+    }
+
+    static String boardLabels(const Board& board) {
+      return String("board=\"") + board.getId() + "\",name=\"" + PrometheusWriter::escape(board.getName()) + "\"";
+    }
+
+    void recordHttp(HttpEndpoint endpoint, uint32_t start, int code) const {
+      uint8_t idx = static_cast<uint8_t>(endpoint);
+      _httpLatency[idx].record(micros() - start);
+      if (code != HTTP_CODE_OK && code != HTTP_CODE_NOT_MODIFIED) {
+        _httpFailures[idx].increment();
+      }
+    }
+
+    // Runs on the task that updates the boards. Each board is updated with only its own lock
+    // held, so a board that blocks in connect() stalls neither the registry nor the listeners
+    // of the other boards.
+    void pollBoards() {
+      {
+        std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+        _reconnect.update(_boards);
+      }
+      for (size_t slot = 0; ; slot++) {
+        Board* board;
+        std::unique_lock<std::recursive_mutex> boardLock;
+        {
+          std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+          if (slot >= _boards.capacity()) {
+            break;
+          }
+          board = _boards.get(_boards.handleAt(slot));
+          if (board == nullptr) {
+            continue;
+          }
+          // Taken with the registry locked, so the board cannot be erased before it is updated
+          boardLock = std::unique_lock<std::recursive_mutex>(board->getMutex());
+        }
+        board->update();
+      }
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      if (_replay && !_replay->update()) {
+        LOG_INFO("Replay", F("Replayed ") << _replay->getNumFrames() << F(" frames in ") << _replay->getElapsed() << F(" us"));
+        _replay.reset();
+      }
+      if (_journal) {
+        _journal->update();
+      }
+    }
+
+#ifdef ESP32
+    static void networkTask(void* parameter) {
+      Client* client = static_cast<Client*>(parameter);
+      while (client->_networkTaskRunning) {
+        client->pollBoards();
+        vTaskDelay(1);
+      }
+      client->_networkTask = nullptr;
+      vTaskDelete(nullptr);
+    }
+
+    std::atomic<TaskHandle_t> _networkTask{nullptr};
+#endif
+
     String _ticket;
     Token _accessToken;
-    BoardArray _boards;
+    Token _refreshToken;
+    String _boardsETag;
+    mutable bool _boardsModified = false; // Boards changed since the list was stored
+    std::vector<bool> _accountBoards; // By slot, boards that came from the account list
+    std::vector<MatchBoard> _matchBoards; // Boards with a running match, sorted by match id
+    uint64_t _lastRenewal = 0;
+    BoardRegistry _boards;
+    ReconnectScheduler _reconnect;
     uint64_t _lastChecked = 0;
+    int8_t _degradedFps = 0;
+    std::array<LatencyHistogram, AUTODARTS_LATENCY_STAGES> _throwLatency;
+    std::array<MetricHistogram, AUTODARTS_CLIENT_TOPICS> _callbackTime; // By topic id - 1
+    mutable std::array<MetricHistogram, AUTODARTS_HTTP_ENDPOINTS> _httpLatency;
+    mutable std::array<MetricCounter, AUTODARTS_HTTP_ENDPOINTS> _httpFailures;
+
+    mutable std::recursive_mutex _boardsMutex;
+    std::atomic<bool> _networkTaskRunning{false};
+    std::atomic<uint32_t> _droppedNotifications{0};
+    SpscQueue<Notification, 64> _notifications;
+    DirectListener _directListener{*this};
+    DeferredListener _deferredListener{*this};
+    std::unique_ptr<AsyncRequest> _request;
+    std::unique_ptr<AsyncRequest> _queuedRequest; // Waits until _request is done
+    Storage* _storage = nullptr;
+
+    CloudConnection _cloud;
+    std::unique_ptr<RelayServer> _relay;
+    std::unique_ptr<Journal> _journal;
+    std::unique_ptr<JournalReplay> _replay;
+
+    // One kept alive connection per host, shared by all requests
+    mutable HttpSession _authSession;
+    mutable HttpSession _apiSession;
 
-    BoardCallback             _onDataCallback              = [](const Board&){};
-    BoardCallback             _onConnectionChangeCallback  = [](const Board&){};
-    CameraStatsCallback       _onCameraStatsCallback       = [](int8_t, int8_t, int16_t, int16_t){};
-    CameraSystemStateCallback _onCameraSystemStateCallback = [](State, State){};
-    DetectionStateCallback    _onDetectionStateCallback    = [](State, State,  int16_t){};
-    DetectionEventCallback    _onDetectionEventCallback    = [](Status::Code, Event::Code){};
+    Topic<AUTODARTS_MAX_LISTENERS, const Board&>                           _dataTopic{1, &_callbackTime[0]};
+    Topic<AUTODARTS_MAX_LISTENERS, const Board&>                           _connectionChangeTopic{2, &_callbackTime[1]};
+    Topic<AUTODARTS_MAX_LISTENERS, int8_t, int8_t, int16_t, int16_t>       _cameraStatsTopic{3, &_callbackTime[2]};
+    Topic<AUTODARTS_MAX_LISTENERS, State, State>                           _cameraSystemStateTopic{4, &_callbackTime[3]};
+    Topic<AUTODARTS_MAX_LISTENERS, State, State, int16_t>                  _detectionStateTopic{5, &_callbackTime[4]};
+    Topic<AUTODARTS_MAX_LISTENERS, Status::Code, Event::Code>              _detectionEventTopic{6, &_callbackTime[5]};
+    Topic<AUTODARTS_MAX_LISTENERS, const Board&, uint8_t, const Throw&>    _throwTopic{7, &_callbackTime[6]};
+    Topic<AUTODARTS_MAX_LISTENERS, const Board&, const CameraStats&, bool> _cameraDegradedTopic{8, &_callbackTime[7]};
+    Topic<AUTODARTS_MAX_LISTENERS, const Board&>                           _matchChangeTopic{9, &_callbackTime[8]};
+    Topic<AUTODARTS_MAX_LISTENERS, const Board&, const JsonObjectConst&>   _matchStateTopic{10, &_callbackTime[9]};
   };
 
 } // autodarts
@@ -5,9 +5,41 @@ WiFiManagerParameter autodartsPassword("password", "Password", "", 20);
 
 #include "AutodartsClient.h"
 autodarts::Client client;
+autodarts::PreferencesStorage storage;
 
 SET_LOOP_TASK_STACK_SIZE(16*1024); // 16KB
 
+// Root certificates autodarts.io is verified against. The bundle is made with gen_crt_bundle.py
+// of ESP-IDF and embedded as data/cert/x509_crt_bundle.bin, see the WiFiClientSecure docs.
+extern const uint8_t rootca_crt_bundle_start[] asm("_binary_data_cert_x509_crt_bundle_bin_start");
+
+// Sends what is printed as chunks of a response of unknown length, so a large body is
+// never held in memory as a whole
+class ChunkedResponse : public Print {
+public:
+  ChunkedResponse(WebServer& server) : _server(server) {}
+
+  size_t write(uint8_t c) override {
+    _buffer[_length++] = c;
+    if (_length == sizeof(_buffer)) {
+      flush();
+    }
+    return 1;
+  }
+
+  void flush() override {
+    if (_length > 0) {
+      _server.sendContent(_buffer, _length);
+      _length = 0;
+    }
+  }
+
+private:
+  WebServer& _server;
+  char _buffer[512];
+  size_t _length = 0;
+};
+
 void onDataCallback(const autodarts::Board& board) {
   Serial.println("Received new data");
 }
@@ -29,8 +61,18 @@ void onSaveWifiParams () {
   if (strlen(autodartsUsername.getValue()) != 0 && strlen(autodartsPassword.getValue()) != 0) {
     LOG_INFO("WifiManager", autodartsUsername.getLabel() << " = " << autodartsUsername.getValue());
     LOG_INFO("WifiManager", autodartsPassword.getLabel() << " = " << autodartsPassword.getValue());
-    client.autoDetectBoards(autodartsUsername.getValue(), autodartsPassword.getValue());
-    client.openBoards();
+    // Waits behind a request that is still running, e.g. the refresh started in setup()
+    bool started = client.autoDetectBoardsAsync(autodartsUsername.getValue(), autodartsPassword.getValue(), [](int code) {
+      if (code == HTTP_CODE_OK || code == HTTP_CODE_NOT_MODIFIED) {
+        client.openBoards();
+      }
+      else {
+        Serial.printf("Could not load the boards of the account [%d]\n", code);
+      }
+    });
+    if (!started) {
+      Serial.println("Could not start loading the boards of the account");
+    }
   }
 }
 
@@ -45,6 +87,18 @@ void setup() {
     wifiManager.setSaveParamsCallback(onSaveWifiParams);
     wifiManager.setConfigPortalBlocking(false);
 
+    // Serve the client metrics for Prometheus next to the web portal
+    wifiManager.setWebServerCallback([]() {
+      wifiManager.server->on("/metrics", HTTP_GET, []() {
+        wifiManager.server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        wifiManager.server->send(200, "text/plain; version=0.0.4", "");
+        ChunkedResponse body(*wifiManager.server);
+        client.writeMetrics(body);
+        body.flush();
+        wifiManager.server->sendContent("");
+      });
+    });
+
     // Automatically connect using saved credentials if they exist
     // If connection fails it starts an access point with the specified name
     if(wifiManager.autoConnect("AutoConnectAP")){
@@ -60,6 +114,21 @@ void setup() {
     client.onData(onDataCallback);
     client.onConnectionChange(onConnectionChangeCallback);
     client.onCameraSystemState(onCameraSystemStateCallback);
+
+    client.setCACertBundle(rootca_crt_bundle_start);
+
+    // Open the boards known from the last session without waiting for autodarts.io
+    client.setStorage(&storage);
+    client.restore();
+
+    // Refresh the cached boards in the background, a stored refresh token replaces the credentials
+    if (WiFi.isConnected()) {
+      client.autoDetectBoardsAsync("", "", [](int code) {
+        if (code == HTTP_CODE_OK || code == HTTP_CODE_NOT_MODIFIED) {
+          client.openBoards();
+        }
+      });
+    }
 }
 
 void loop() {
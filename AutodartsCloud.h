@@ -0,0 +1,216 @@
+#ifndef AutodartsCloud_h_
+#define AutodartsCloud_h_
+
+#include <algorithm>
+#include <memory>
+
+#include <ArduinoJson.h>
+#include <WebSocketsClient.h>
+
+#include "AutodartsDefines.h"
+
+namespace autodarts {
+
+  typedef std::function<void(const Board& board, const JsonObjectConst& data)> MatchStateCallback;
+
+  // One websocket to autodarts.io shared by all boards of a client. Every connection
+  // needs a fresh ticket, so the library must not reconnect on its own. The client
+  // requests a ticket whenever needsTicket() and sends its subscriptions again from
+  // the connected callback.
+  class CloudConnection {
+  public:
+    typedef std::function<void(const JsonObjectConst& message)> MessageCallback;
+    typedef std::function<void()> ConnectedCallback;
+
+    CloudConnection() = default;
+    CloudConnection(const CloudConnection&) = delete;
+    CloudConnection& operator=(const CloudConnection&) = delete;
+
+    // The message document is only allocated while the connection is enabled
+    void setEnabled(bool enabled) {
+      _enabled = enabled;
+      if (enabled && !_json) {
+        _json.reset(new DynamicJsonDocument(AUTODARTS_CLOUD_DOCUMENT_SIZE));
+      }
+      else if (!enabled) {
+        close();
+        _json.reset();
+      }
+      _retryAt = millis();
+      _retryDelay = AUTODARTS_CLOUD_MIN_RETRY;
+    }
+
+    bool isEnabled() const {
+      return _enabled;
+    }
+
+    // The server is verified against the root certificate or bundle, which have to outlive
+    // the connection. Without either it is not opened unless verification is turned off.
+    void setCACert(const char* rootCA) {
+      _caCert = rootCA;
+      _insecure = false;
+    }
+
+    void setCACertBundle(const uint8_t* bundle) {
+      _caBundle = bundle;
+      _insecure = false;
+    }
+
+    void setInsecure() {
+      _insecure = true;
+    }
+
+    bool isOpen() const {
+      return _open;
+    }
+
+    // Disconnected, enabled and the backoff after the last failure has passed
+    bool needsTicket() const {
+      return _enabled && !_open && !_connecting && static_cast<int32_t>(millis() - _retryAt) >= 0;
+    }
+
+    void connect(const String& ticket) {
+      String path = String(AUTODARTS_CLOUD_PATH) + ticket;
+      LOG_DEBUG("Cloud", F("Opening connection"));
+      if (_caCert != nullptr) {
+        _websocket.beginSslWithCA(AUTODARTS_CLOUD_HOST, 443, path.c_str(), _caCert);
+      }
+      else if (_caBundle != nullptr) {
+        _websocket.beginSslWithBundle(AUTODARTS_CLOUD_HOST, 443, path.c_str(), _caBundle);
+      }
+      else if (_insecure) {
+        _websocket.beginSSL(AUTODARTS_CLOUD_HOST, 443, path.c_str());
+      }
+      else {
+        LOG_ERROR("Cloud", F("No root certificate set to verify the server"));
+        failed();
+        return;
+      }
+      _connecting = true;
+      _connectingSince = millis();
+      _websocket.setReconnectInterval(AUTODARTS_CONNECT_TIMEOUT);
+      _websocket.onEvent([this](WStype_t type, uint8_t* payload, size_t length) {
+        switch (type) {
+          case WStype_CONNECTED:
+            LOG_INFO("Cloud", F("Connection opened"));
+            _open = true;
+            _connecting = false;
+            _openedAt = millis();
+            _retryDelay = AUTODARTS_CLOUD_MIN_RETRY;
+            _onConnectedCallback();
+            break;
+          case WStype_DISCONNECTED:
+            LOG_INFO("Cloud", F("Connection closed"));
+            if (_open && millis() - _openedAt >= AUTODARTS_CLOUD_MIN_RETRY) {
+              closed();
+            }
+            else {
+              failed();
+            }
+            break;
+          case WStype_TEXT: {
+            if (!_json) {
+              break;
+            }
+            DeserializationError err = deserializeJson(*_json, reinterpret_cast<char*>(payload), length);
+            if (err) {
+              LOG_ERROR("Cloud", F("Could not deserialize message: ") << err.c_str());
+              break;
+            }
+            _onMessageCallback(_json->as<JsonObjectConst>());
+            break;
+          }
+          default:
+            break;
+        }
+      });
+    }
+
+    // Tells the connection that no ticket could be obtained, the next one is requested after a backoff
+    void failed() {
+      _open = false;
+      _connecting = false;
+      _retryAt = millis() + _retryDelay;
+      _retryDelay = std::min(_retryDelay * 2, AUTODARTS_CLOUD_MAX_RETRY);
+    }
+
+    // The server closed a connection that was up for a while, e.g. because its ticket expired.
+    // The next ticket is requested right away, a connection dropped sooner counts as failed.
+    void closed() {
+      _open = false;
+      _connecting = false;
+      _retryAt = millis();
+      _retryDelay = AUTODARTS_CLOUD_MIN_RETRY;
+    }
+
+    void close() {
+      if (_open || _connecting) {
+        _websocket.disconnect();
+      }
+      _open = false;
+      _connecting = false;
+    }
+
+    void update() {
+      if (!_open && !_connecting) {
+        return;
+      }
+      if (_connecting && millis() - _connectingSince > AUTODARTS_CONNECT_TIMEOUT) {
+        LOG_WARNING("Cloud", F("Connection attempt timed out"));
+        _websocket.disconnect();
+        failed();
+        return;
+      }
+      _websocket.loop();
+    }
+
+    bool subscribe(const char* channel, const String& topic) {
+      return send("subscribe", channel, topic);
+    }
+
+    bool unsubscribe(const char* channel, const String& topic) {
+      return send("unsubscribe", channel, topic);
+    }
+
+    void onMessage(MessageCallback callback) {
+      _onMessageCallback = callback;
+    }
+
+    void onConnected(ConnectedCallback callback) {
+      _onConnectedCallback = callback;
+    }
+
+  private:
+    bool send(const char* type, const char* channel, const String& topic) {
+      if (!_open) {
+        return false;
+      }
+      StaticJsonDocument<192> json;
+      json["channel"] = channel;
+      json["type"]    = type;
+      json["topic"]   = topic.c_str();
+      String message;
+      serializeJson(json, message);
+      return _websocket.sendTXT(message);
+    }
+
+    WebSocketsClient _websocket;
+    std::unique_ptr<DynamicJsonDocument> _json;
+    const char* _caCert = nullptr;
+    const uint8_t* _caBundle = nullptr;
+    bool _insecure = false;
+    bool _enabled = false;
+    bool _open = false;
+    bool _connecting = false;
+    uint32_t _connectingSince = 0;
+    uint32_t _openedAt = 0;
+    uint32_t _retryAt = 0;
+    uint32_t _retryDelay = AUTODARTS_CLOUD_MIN_RETRY;
+
+    MessageCallback   _onMessageCallback   = [](const JsonObjectConst&){};
+    ConnectedCallback _onConnectedCallback = [](){};
+  };
+
+} // autodarts
+
+#endif // AutodartsCloud_h_
@@ -1,6 +1,19 @@
 #ifndef AutodartsDefines_h_
 #define AutodartsDefines_h_
 
+#include <array>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <Arduino.h>
+
+// Camera slots per board, define before including the library to match the rig
+#ifndef AUTODARTS_MAX_CAMERAS
+#define AUTODARTS_MAX_CAMERAS 3
+#endif
+
 #define LOG_FORMATTING LOG_FORMATTING_NOTIME
 #define LOG_LEVEL LOG_LEVEL_DEBUG
 #include <EasyLogger.h>
@@ -8,6 +21,7 @@
 namespace autodarts {
 
   class Board;
+  class Throw;
 
   struct Status {
     enum class Code : int8_t {
@@ -45,28 +59,44 @@ namespace autodarts {
       _value = value;
     }
 
-    static String toString(Code value) {
+    static const char* name(Code value) {
       switch (value) {
-        case Code::STOPPED:          return F("Stopped");
-        case Code::STARTING:         return F("Starting");
-        case Code::THROW:            return F("Throw");
-        case Code::TAKEOUT:          return F("Takeout");
-        case Code::TAKEOUT_PROGRESS: return F("Takeout in progress");
-        default:                     return F("Unknown");
+        case Code::STOPPED:          return "Stopped";
+        case Code::STARTING:         return "Starting";
+        case Code::THROW:            return "Throw";
+        case Code::TAKEOUT:          return "Takeout";
+        case Code::TAKEOUT_PROGRESS: return "Takeout in progress";
+        default:                     return "Unknown";
       }
     }
 
+    static String toString(Code value) {
+      return name(value);
+    }
+
     String toString() const {
       return toString(_value);
     }
 
     static Code fromString(const String& value) {
-      if      (value == F("Stopped"))             return Code::STOPPED;
-      else if (value == F("Starting"))            return Code::STARTING;
-      else if (value == F("Throw"))               return Code::THROW;
-      else if (value == F("Takeout"))             return Code::TAKEOUT;
-      else if (value == F("Takeout in progress")) return Code::TAKEOUT_PROGRESS;
-      else                                        return Code::UNKNOWN;
+      return fromString(value.c_str());
+    }
+
+    // Pick the only candidate by length and first character, then confirm it with one compare
+    static Code fromString(const char* value) {
+      if (value == nullptr) {
+        return Code::UNKNOWN;
+      }
+
+      Code code;
+      switch (strlen(value)) {
+        case 5:  code = Code::THROW;                                          break;
+        case 7:  code = value[0] == 'S' ? Code::STOPPED : Code::TAKEOUT;      break;
+        case 8:  code = Code::STARTING;                                       break;
+        case 19: code = Code::TAKEOUT_PROGRESS;                               break;
+        default: return Code::UNKNOWN;
+      }
+      return strcmp(value, name(code)) == 0 ? code : Code::UNKNOWN;
     }
 
   private:
@@ -112,40 +142,233 @@ namespace autodarts {
       _value = value;
     }
 
-    static String toString(Code value) {
+    static const char* name(Code value) {
       switch (value) {
-        case Code::STOPPED:          return F("Stopped");
-        case Code::STOPPING:         return F("Stopping");
-        case Code::STARTING:         return F("Starting");
-        case Code::STARTED:          return F("Started");
-        case Code::THROW_DETECTED:   return F("Throw detected");
-        case Code::TAKEOUT_STARTED:  return F("Takeout started");
-        case Code::TAKEOUT_FINISHED: return F("Takeout finished");
-        case Code::RESET:            return F("Manual reset");
-        default:                     return F("Unknown");
+        case Code::STOPPED:          return "Stopped";
+        case Code::STOPPING:         return "Stopping";
+        case Code::STARTING:         return "Starting";
+        case Code::STARTED:          return "Started";
+        case Code::THROW_DETECTED:   return "Throw detected";
+        case Code::TAKEOUT_STARTED:  return "Takeout started";
+        case Code::TAKEOUT_FINISHED: return "Takeout finished";
+        case Code::RESET:            return "Manual reset";
+        default:                     return "Unknown";
       }
     }
 
+    static String toString(Code value) {
+      return name(value);
+    }
+
     String toString() const {
       return toString(_value);
     }
 
     static Code fromString(const String& value) {
-      if      (value == F("Stopped"))             return Code::STOPPED;
-      else if (value == F("Stopping"))            return Code::STOPPING;
-      else if (value == F("Starting"))            return Code::STARTING;
-      else if (value == F("Started"))             return Code::STARTED;
-      else if (value == F("Throw detected"))      return Code::THROW_DETECTED;
-      else if (value == F("Takeout started"))     return Code::TAKEOUT_STARTED;
-      else if (value == F("Takeout finished"))    return Code::TAKEOUT_FINISHED;
-      else if (value == F("Manual reset"))        return Code::RESET;
-      else                                        return Code::UNKNOWN;
+      return fromString(value.c_str());
+    }
+
+    // Pick the only candidate by length and a distinguishing character, then confirm it with one compare
+    static Code fromString(const char* value) {
+      if (value == nullptr) {
+        return Code::UNKNOWN;
+      }
+
+      Code code;
+      switch (strlen(value)) {
+        case 7:  code = value[3] == 'p' ? Code::STOPPED  : Code::STARTED;     break;
+        case 8:  code = value[2] == 'o' ? Code::STOPPING : Code::STARTING;    break;
+        case 12: code = Code::RESET;                                          break;
+        case 14: code = Code::THROW_DETECTED;                                 break;
+        case 15: code = Code::TAKEOUT_STARTED;                                break;
+        case 16: code = Code::TAKEOUT_FINISHED;                               break;
+        default: return Code::UNKNOWN;
+      }
+      return strcmp(value, name(code)) == 0 ? code : Code::UNKNOWN;
     }
 
   private:
     Code _value = Code::UNKNOWN;
   };
 
+  struct Message {
+    enum class Type : int8_t {
+      UNKNOWN          =  -1,
+      STATE            =   0,
+      CAM_STATE        =   1,
+      CAM_STATS        =   2,
+    };
+
+    static const char* toString(Type value) {
+      switch (value) {
+        case Type::STATE:            return "state";
+        case Type::CAM_STATE:        return "cam_state";
+        case Type::CAM_STATS:        return "cam_stats";
+        default:                     return "unknown";
+      }
+    }
+
+    // Resolve the type with a single switch on the length and the
+    // distinguishing character instead of comparing every known name
+    static Type fromString(const char* value) {
+      if (value == nullptr) {
+        return Type::UNKNOWN;
+      }
+
+      switch (strlen(value)) {
+        case 5:
+          return strcmp(value, "state") == 0 ? Type::STATE : Type::UNKNOWN;
+        case 9:
+          if (strncmp(value, "cam_stat", 8) != 0) {
+            return Type::UNKNOWN;
+          }
+          switch (value[8]) {
+            case 'e':                return Type::CAM_STATE;
+            case 's':                return Type::CAM_STATS;
+            default:                 return Type::UNKNOWN;
+          }
+        default:
+          return Type::UNKNOWN;
+      }
+    }
+  };
+
+  // Board id kept as its 16 raw bytes instead of the 36 character string
+  struct Uuid {
+    std::array<uint8_t, 16> bytes{};
+
+    bool isEmpty() const {
+      for (uint8_t byte : bytes) {
+        if (byte != 0) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool operator==(const Uuid& other) const {
+      return bytes == other.bytes;
+    }
+
+    bool operator!=(const Uuid& other) const {
+      return bytes != other.bytes;
+    }
+
+    bool operator<(const Uuid& other) const {
+      return bytes < other.bytes;
+    }
+
+    // FNV-1a
+    uint32_t hash() const {
+      uint32_t hash = 2166136261u;
+      for (uint8_t byte : bytes) {
+        hash = (hash ^ byte) * 16777619u;
+      }
+      return hash;
+    }
+
+    String toString() const {
+      char buffer[37];
+      toChars(buffer);
+      return String(buffer);
+    }
+
+    // Writes the canonical form and the terminator into 37 chars, empty for the empty id
+    void toChars(char* buffer) const {
+      if (isEmpty()) {
+        *buffer = '\0';
+        return;
+      }
+
+      static const char* digits = "0123456789abcdef";
+      char* out = buffer;
+      for (uint8_t idx = 0; idx < bytes.size(); idx++) {
+        if (idx == 4 || idx == 6 || idx == 8 || idx == 10) {
+          *out++ = '-';
+        }
+        *out++ = digits[bytes[idx] >> 4];
+        *out++ = digits[bytes[idx] & 0x0F];
+      }
+      *out = '\0';
+    }
+
+    // Accepts the canonical 8-4-4-4-12 form in upper or lower case
+    static bool fromString(const char* value, Uuid& uuid) {
+      if (value == nullptr || strlen(value) != 36) {
+        return false;
+      }
+
+      Uuid parsed;
+      uint8_t idx = 0;
+      for (uint8_t pos = 0; pos < 36; pos++) {
+        if (pos == 8 || pos == 13 || pos == 18 || pos == 23) {
+          if (value[pos] != '-') {
+            return false;
+          }
+          continue;
+        }
+        int8_t nibble = hexValue(value[pos]);
+        if (nibble < 0) {
+          return false;
+        }
+        parsed.bytes[idx / 2] |= (idx % 2 == 0) ? nibble << 4 : nibble;
+        idx++;
+      }
+      uuid = parsed;
+      return true;
+    }
+
+  private:
+    static int8_t hexValue(char c) {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      return -1;
+    }
+  };
+
+  // Returns a shared copy of value, used for strings with only a handful of distinct values like board versions
+  inline const char* intern(const char* value) {
+    static std::vector<std::unique_ptr<char[]>> pool;
+    if (value == nullptr || *value == '\0') {
+      return "";
+    }
+    for (const std::unique_ptr<char[]>& entry : pool) {
+      if (strcmp(entry.get(), value) == 0) {
+        return entry.get();
+      }
+    }
+    size_t length = strlen(value) + 1;
+    pool.emplace_back(new char[length]);
+    memcpy(pool.back().get(), value, length);
+    return pool.back().get();
+  }
+
+  typedef uint16_t ChangeMask;
+
+  // Bits of the fields that were modified by a message
+  struct Change {
+    enum : ChangeMask {
+      NONE              = 0,
+      CONNECTED         = 1 << 0,
+      RUNNING           = 1 << 1,
+      NUM_THROWS        = 1 << 2,
+      STATUS            = 1 << 3,
+      EVENT             = 1 << 4,
+      THROWS            = 1 << 5,
+      CAMERA_OPENED     = 1 << 6,
+      CAMERA_RUNNING    = 1 << 7,
+      CAMERA_FPS        = 1 << 8,
+      CAMERA_RESOLUTION = 1 << 9,
+
+      DETECTION_STATE   = CONNECTED | RUNNING | NUM_THROWS,
+      DETECTION_EVENT   = STATUS | EVENT,
+      CAMERA_STATE      = CAMERA_OPENED | CAMERA_RUNNING,
+      CAMERA_STATS      = CAMERA_FPS | CAMERA_RESOLUTION,
+      ALL               = 0xFFFF,
+    };
+  };
+
   enum class State : int8_t {
     TURNED_FALSE = -1,
     IS_FALSE     =  0,
@@ -153,21 +376,91 @@ namespace autodarts {
     TURNED_TRUE  =  2
   };
 
-  typedef std::function<void(int8_t id, int8_t fps, int16_t width, int16_t height)> CameraStatsCallback;
-  typedef std::function<void(State opened, State running)>                          CameraSystemStateCallback;
-  typedef std::function<void(State connected, State running, int16_t numThrows)>    DetectionStateCallback;
-  typedef std::function<void(Status::Code status, Event::Code event)>               DetectionEventCallback;
-  typedef std::function<void(State connected)>                                      BoardConnectionCallback;
-  typedef std::function<void(const Board& board)>                                   BoardCallback;
-
-  static const char* AUTODARTS_URL                   = "https://autodarts.io";
-  static const char* AUTODARTS_AUTH_KEYCLOAK_URL     = "https://login.autodarts.io/realms/autodarts/protocol/openid-connect/token";
-  static const char* AUTODARTS_AUTH_KEYCLOAK_REQUEST = "client_id=autodarts-app&scope=openid&grant_type=password&username=%s&password=%s";
-  static const char* AUTODARTS_API_MATCHES_URL       = "https://api.autodarts.io/gs/v0/matches";
-  static const char* AUTODARTS_API_BOARDS_URL        = "https://api.autodarts.io/bs/v0/boards";
-  static const char* AUTODARTS_API_TICKET_URL        = "https://api.autodarts.io/ms/v0/ticket";
-  static const char* AUTODARTS_WS_SECURE_URL         = "ws://api.autodarts.io/ms/v0/subscribe?ticket=";
-  static const char* AUTODARTS_WS_LOCAL_URL          = "ws://%s/api/events";
+  // Snapshot of the last stats of a camera and its rolling FPS statistics
+  struct CameraStats {
+    int8_t  id      = -1;
+    int8_t  fps     = -1;
+    int16_t width   = -1;
+    int16_t height  = -1;
+    uint8_t samples = 0;
+    int8_t  minFps  = -1;
+    int8_t  maxFps  = -1;
+    int8_t  p95Fps  = -1;
+    float   meanFps = 0;
+  };
+
+  typedef std::function<void(int8_t id, int8_t fps, int16_t width, int16_t height)>        CameraStatsCallback;
+  typedef std::function<void(const Board& board, const CameraStats& stats, bool degraded)> CameraDegradedCallback;
+  typedef std::function<void(State opened, State running)>                                 CameraSystemStateCallback;
+  typedef std::function<void(State connected, State running, int16_t numThrows)>           DetectionStateCallback;
+  typedef std::function<void(Status::Code status, Event::Code event)>                      DetectionEventCallback;
+  typedef std::function<void(const Board& board, uint8_t idx, const Throw& dart)>          ThrowCallback;
+  typedef std::function<void(State connected)>                                             BoardConnectionCallback;
+  typedef std::function<void(const Board& board)>                                          BoardCallback;
+  typedef std::function<void(int code)>                                                    HttpCallback;
+
+  // Receives all events of boards. One instance is shared by all boards of a client
+  // instead of every board holding copies of the same callbacks.
+  class BoardListener {
+  public:
+    virtual ~BoardListener() = default;
+
+    virtual void onData(const Board& board) {}
+    virtual void onConnectionChange(const Board& board) {}
+    virtual void onCameraStats(const Board& board, int8_t id, int8_t fps, int16_t width, int16_t height) {}
+    virtual void onCameraSystemState(const Board& board, State opened, State running) {}
+    virtual void onCameraDegraded(const Board& board, const CameraStats& stats, bool degraded) {}
+    virtual void onDetectionState(const Board& board, State connected, State running, int16_t numThrows) {}
+    virtual void onDetectionEvent(const Board& board, Status::Code status, Event::Code event) {}
+    virtual void onThrow(const Board& board, uint8_t idx, const Throw& dart) {}
+  };
+
+  // Owned by a board and shared with its detector and cameras, so every
+  // event reaches the listener with a single virtual call
+  struct EventSink {
+    const Board*   board;
+    BoardListener* listener;
+    uint32_t       receivedAt = 0; // micros() when the current message arrived
+    uint32_t       parsedAt   = 0; // micros() when the last dart was parsed
+  };
+
+  static const uint16_t AUTODARTS_BOARD_PORT         = 3180;
+  static const size_t   AUTODARTS_MESSAGE_DOCUMENT   = 2048;       // Parsed message of a board, one per board that receives
+  static const uint8_t  AUTODARTS_MAX_LISTENERS      = 4;          // Listeners per event topic of a client
+  static const uint8_t  AUTODARTS_CAMERA_HISTORY     = 32;         // Stats messages kept per camera for the rolling statistics
+  static const uint8_t  AUTODARTS_CAMERA_MAX_FPS     = 63;         // Higher rates are counted as this value in the statistics
+  static const time_t   AUTODARTS_MIN_EPOCH          = 1577836800; // 2020-01-01, anything earlier means the clock is not set
+  static const uint32_t AUTODARTS_TOKEN_RENEW_MARGIN = 60000;      // Renew access token one minute before it expires
+  static const uint32_t AUTODARTS_CONNECT_TIMEOUT    = 5000;       // Connection attempts to a board without handshake count as failed
+  static const uint32_t AUTODARTS_CLOUD_MIN_RETRY    = 2000;       // Backoff of the cloud connection after the first failure
+  static const uint32_t AUTODARTS_CLOUD_MAX_RETRY    = 60000;
+  static const size_t   AUTODARTS_CLOUD_DOCUMENT_SIZE = 8192;      // Match states are the largest cloud messages
+  static const uint16_t AUTODARTS_RELAY_PORT         = 3181;
+  static const uint8_t  AUTODARTS_RELAY_QUEUE        = 16;         // Messages queued per relay subscriber before dropping
+  static const uint8_t  AUTODARTS_RELAY_BURST        = 4;          // Messages sent per relay subscriber and update
+  static const size_t   AUTODARTS_RELAY_MESSAGE      = 512;        // Largest relayed message, a state with three darts is about 400 bytes
+  static const uint8_t  AUTODARTS_RELAY_BUFFERS      = 20;         // Relayed messages held at once, shared by the queues of all subscribers
+  static const size_t   AUTODARTS_JOURNAL_BLOCK      = 512;        // Journal records are written to the file in blocks of this size
+  static const uint32_t AUTODARTS_JOURNAL_FLUSH      = 1000;       // Longest time a journal record stays in memory
+  static const size_t   AUTODARTS_JOURNAL_MAX_FRAME  = 2048;       // Largest frame the replay can feed to a board
+  static const uint8_t  AUTODARTS_JOURNAL_BURST      = 16;         // Frames replayed per update when not replaying in real time
+  static const size_t   AUTODARTS_STORAGE_CHUNK      = 1024;       // Streamed values are stored in NVS blobs of this size
+
+  static const char* const AUTODARTS_URL                   = "https://autodarts.io";
+  static const char* const AUTODARTS_AUTH_KEYCLOAK_URL     = "https://login.autodarts.io/realms/autodarts/protocol/openid-connect/token";
+  static const char* const AUTODARTS_AUTH_KEYCLOAK_REQUEST = "client_id=autodarts-app&scope=openid&grant_type=password&username=%s&password=%s";
+  static const char* const AUTODARTS_AUTH_KEYCLOAK_REFRESH_REQUEST = "client_id=autodarts-app&grant_type=refresh_token&refresh_token=";
+  static const char* const AUTODARTS_API_MATCHES_URL       = "https://api.autodarts.io/gs/v0/matches";
+  static const char* const AUTODARTS_API_BOARDS_URL        = "https://api.autodarts.io/bs/v0/boards";
+  static const char* const AUTODARTS_API_TICKET_URL        = "https://api.autodarts.io/ms/v0/ticket";
+  static const char* const AUTODARTS_CLOUD_HOST            = "api.autodarts.io";
+  static const char* const AUTODARTS_CLOUD_PATH            = "/ms/v0/subscribe?ticket=";
+  static const char* const AUTODARTS_CLOUD_BOARDS_CHANNEL  = "autodarts.boards";
+  static const char* const AUTODARTS_CLOUD_MATCHES_CHANNEL = "autodarts.matches";
+  static const char* const AUTODARTS_WS_LOCAL_URL          = "ws://%s/api/events";
+  static const char* const AUTODARTS_STORAGE_TOKEN         = "token";
+  static const char* const AUTODARTS_STORAGE_BOARDS        = "boardlist";
+  static const char* const AUTODARTS_STORAGE_ETAG          = "etag";
 };
 
 #endif // AutodartsDefines_h_
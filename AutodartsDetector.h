@@ -1,7 +1,8 @@
-#include "WString.h"
 #ifndef AutodartsDetector_h_
 #define AutodartsDetector_h_
 
+#include <algorithm>
+
 #include <ArduinoJson.h>
 
 #include "AutodartsDefines.h"
@@ -9,6 +10,62 @@
 
 namespace autodarts {
 
+  class Throw {
+  public:
+    Throw() = default;
+
+    Throw(int8_t number, int8_t multiplier, float x, float y) : _number(number), _multiplier(multiplier), _x(x), _y(y) {}
+
+    int8_t getNumber() const {
+      return _number;
+    }
+
+    int8_t getMultiplier() const {
+      return _multiplier;
+    }
+
+    int16_t getScore() const {
+      return _number < 0 ? 0 : _number * _multiplier;
+    }
+
+    float getX() const {
+      return _x;
+    }
+
+    float getY() const {
+      return _y;
+    }
+
+    void fromJson(const JsonObjectConst& root) {
+      _number     = root["segment"]["number"] | -1;
+      _multiplier = root["segment"]["multiplier"] | 0;
+      _x          = root["coords"]["x"] | 0.0f;
+      _y          = root["coords"]["y"] | 0.0f;
+    }
+
+    bool operator==(const Throw& other) const {
+      return _number == other._number && _multiplier == other._multiplier && _x == other._x && _y == other._y;
+    }
+
+    bool operator!=(const Throw& other) const {
+      return !(*this == other);
+    }
+
+    void toJson(JsonObject& root) const {
+      root["segment"]["number"]     = _number;
+      root["segment"]["multiplier"] = _multiplier;
+      root["coords"]["x"]           = _x;
+      root["coords"]["y"]           = _y;
+    }
+
+  private:
+    int8_t _number = -1;
+    int8_t _multiplier = 0;
+    float  _x = 0.0f;
+    float  _y = 0.0f;
+  };
+
+
   class Detector {
   public:
     bool isConnected() const {
@@ -31,59 +88,256 @@ namespace autodarts {
       return _event;
     }
 
+    uint8_t getNumStoredThrows() const {
+      return _numStoredThrows;
+    }
+
+    const Throw& getThrow(uint8_t idx) const {
+      return _throws[idx];
+    }
+
     CameraSystem& getCameraSystem() {
       return _cameraSystem;
     }
 
-    void fromJson(const JsonObjectConst& root) {
-      if (root["type"] == "state") {
-        _wasConnected = _isConnected;
-        _wasRunning   = _isRunning;
+    const CameraSystem& getCameraSystem() const {
+      return _cameraSystem;
+    }
 
-        _isConnected = root["data"]["connected"];
-        _isRunning   = root["data"]["running"];
-        _numThrows   = root["data"]["numThrows"];
-        _status.fromString(root["data"]["status"]);
-        _event.fromString(root["data"]["event"]);
+    // Returns the fields that were changed by the message
+    ChangeMask fromJson(const JsonObjectConst& root) {
+      Message::Type type = Message::fromString(root["type"]);
+      switch (type) {
+        case Message::Type::STATE:
+          return updateState(root["data"]);
+        case Message::Type::CAM_STATE:
+        case Message::Type::CAM_STATS:
+          return _cameraSystem.fromJson(type, root);
+        default:
+          LOG_WARNING("Detector", F("Unknown message type:") << root["type"].as<const char*>());
+          return Change::NONE;
+      }
+    }
 
+    ChangeMask updateState(const JsonObjectConst& data) {
+      ChangeMask changes = applyState(data["connected"], data["running"], data["numThrows"],
+                                      Status::fromString(data["status"].as<const char*>()),
+                                      Event::fromString(data["event"].as<const char*>()));
+      changes |= updateThrows(data["throws"]);
+      raiseState(changes);
+      return changes;
+    }
+
+    // Takes over the state fields without raising events, see raiseState()
+    ChangeMask applyState(bool connected, bool running, int16_t numThrows, Status::Code status, Event::Code event) {
+      _wasConnected = _isConnected;
+      _wasRunning   = _isRunning;
+
+      ChangeMask changes = Change::NONE;
+      _isConnected = connected;
+      if (_isConnected != _wasConnected) {
+        changes |= Change::CONNECTED;
+      }
+      _isRunning = running;
+      if (_isRunning != _wasRunning) {
+        changes |= Change::RUNNING;
+      }
+      if (numThrows != _numThrows) {
+        changes |= Change::NUM_THROWS;
+        _numThrows = numThrows;
+      }
+      if (status != _status.value()) {
+        changes |= Change::STATUS;
+        _status = status;
+      }
+      if (event != _event.value()) {
+        changes |= Change::EVENT;
+        _event = event;
+      }
+      return changes;
+    }
+
+    // Raises the state and event callbacks for the changes of the last applyState()
+    void raiseState(ChangeMask changes) {
+      if (_sink == nullptr) {
+        return;
+      }
+      if (changes & Change::DETECTION_STATE) {
         State connected = static_cast<State>(2*_isConnected - _wasConnected);
         State running   = static_cast<State>(2*_isRunning   - _wasRunning);
-        _onDetectionStateCallback(connected, running, _numThrows);
-        _onDetectionEventCallback(_status.value(), _event.value());
+        _sink->listener->onDetectionState(*_sink->board, connected, running, _numThrows);
+      }
+      if (changes & Change::DETECTION_EVENT) {
+        _sink->listener->onDetectionEvent(*_sink->board, _status.value(), _event.value());
+      }
+    }
+
+    // Raises the darts that were added since the last state, a shorter list starts a new visit.
+    // The board manager may correct a stored dart in place, which only changes Change::THROWS.
+    ChangeMask updateThrows(const JsonArrayConst& throws) {
+      uint8_t count = std::min<size_t>(throws.size(), _throws.size());
+      ChangeMask changes = count != _numStoredThrows ? Change::THROWS : Change::NONE;
+      if (count < _numStoredThrows) {
+        _numStoredThrows = 0;
+      }
+
+      uint8_t idx = 0;
+      for (JsonObjectConst item : throws) {
+        if (idx >= count) {
+          break;
+        }
+        Throw dart;
+        dart.fromJson(item);
+        changes |= storeThrow(idx, dart);
+        idx++;
+      }
+      _numStoredThrows = count;
+      return changes;
+    }
+
+    // Same as updateThrows() for darts that are already decoded
+    ChangeMask applyThrows(const Throw* throws, uint8_t count) {
+      count = std::min<size_t>(count, _throws.size());
+      ChangeMask changes = count != _numStoredThrows ? Change::THROWS : Change::NONE;
+      if (count < _numStoredThrows) {
+        _numStoredThrows = 0;
       }
-      else {
-        _cameraSystem.fromJson(root);
+      for (uint8_t idx = 0; idx < count; idx++) {
+        changes |= storeThrow(idx, throws[idx]);
       }
+      _numStoredThrows = count;
+      return changes;
     }
 
     void toJson(JsonObject& root) const {
       JsonObject data = root.createNestedObject("data");
       data["connected"] = _isConnected;
       data["running"]   = _isRunning;
-      data["status"]    = _status.toString();
-      data["event"]     = _event.toString();
+      data["status"]    = Status::name(_status.value());
+      data["event"]     = Event::name(_event.value());
       data["numThrows"] = _numThrows;
-      root["type"]      = "state";
+      JsonArray throws  = data.createNestedArray("throws");
+      for (uint8_t idx = 0; idx < _numStoredThrows; idx++) {
+        JsonObject item = throws.createNestedObject();
+        _throws[idx].toJson(item);
+      }
+      root["type"]      = Message::toString(Message::Type::STATE);
+    }
+
+    // Raises a new dart straight from the raw message of a throw detected event before
+    // the whole message is parsed. Only the object of the last dart is deserialized, the
+    // full parse then finds the dart already stored. Returns Change::THROWS if a dart was raised.
+    ChangeMask preScan(const char* payload, size_t length) {
+      const char* end = payload + length;
+      if (find(payload, end, "\"Throw detected\"") == nullptr) {
+        return Change::NONE;
+      }
+      const char* array = find(payload, end, "\"throws\"");
+      if (array == nullptr) {
+        return Change::NONE;
+      }
+      array = static_cast<const char*>(memchr(array, '[', end - array));
+      if (array == nullptr) {
+        return Change::NONE;
+      }
+
+      // Walk the array to count the darts and find the bounds of the last one
+      uint8_t count = 0;
+      const char* dartBegin = nullptr;
+      const char* dartEnd = nullptr;
+      uint8_t depth = 0;
+      bool closed = false;
+      for (const char* c = array + 1; c < end && !closed; c++) {
+        switch (*c) {
+          case '"':
+            // Skip strings, they may contain brackets
+            for (c++; c < end && *c != '"'; c++) {
+              if (*c == '\\') {
+                c++;
+              }
+            }
+            break;
+          case '{':
+          case '[':
+            if (depth == 0) {
+              count++;
+              dartBegin = c;
+            }
+            depth++;
+            break;
+          case '}':
+          case ']':
+            if (depth == 0) {
+              closed = true;
+              break;
+            }
+            depth--;
+            if (depth == 0) {
+              dartEnd = c + 1;
+            }
+            break;
+        }
+      }
+
+      // A list shorter than the stored one starts a new visit like in updateThrows(), which
+      // happens when the takeout message was missed
+      uint8_t stored = count < _numStoredThrows ? 0 : _numStoredThrows;
+      if (!closed || dartBegin == nullptr || dartEnd < dartBegin || count != stored + 1 || count > _throws.size()) {
+        return Change::NONE;
+      }
+
+      StaticJsonDocument<384> json;
+      if (deserializeJson(json, dartBegin, dartEnd - dartBegin)) {
+        return Change::NONE;
+      }
+      uint8_t idx = count - 1;
+      _throws[idx].fromJson(json.as<JsonObjectConst>());
+      _numStoredThrows = count;
+      raiseThrow(idx);
+      return Change::THROWS;
     }
 
-    void onCameraStats(CameraStatsCallback callback) {
-      _onCameraStatsCallback = callback;
+    // Events of the detector and its cameras are raised on sink, which has to outlive the detector
+    void setSink(EventSink* sink) {
+      _sink = sink;
+      _cameraSystem.setSink(sink);
     }
 
-    void onCameraSystemState(CameraSystemStateCallback callback) {
-      _onCameraSystemStateCallback = callback;
+  private:
+    // Raises a dart beyond the stored ones, a stored dart is only replaced if it differs
+    ChangeMask storeThrow(uint8_t idx, const Throw& dart) {
+      if (idx >= _numStoredThrows) {
+        _throws[idx] = dart;
+        raiseThrow(idx);
+        return Change::THROWS;
+      }
+      if (_throws[idx] != dart) {
+        _throws[idx] = dart;
+        return Change::THROWS;
+      }
+      return Change::NONE;
     }
 
-    void onDetectionState(DetectionStateCallback callback) {
-      _onDetectionStateCallback = callback;
+    void raiseThrow(uint8_t idx) {
+      if (_sink != nullptr) {
+        _sink->parsedAt = micros();
+        _sink->listener->onThrow(*_sink->board, idx, _throws[idx]);
+      }
     }
 
-    void onDetectionEvent(DetectionEventCallback callback) {
-      _onDetectionEventCallback = callback;
+    static const char* find(const char* begin, const char* end, const char* needle) {
+      size_t length = strlen(needle);
+      for (; begin + length <= end; begin++) {
+        if (*begin == *needle && memcmp(begin, needle, length) == 0) {
+          return begin;
+        }
+      }
+      return nullptr;
     }
 
-  private:
     CameraSystem _cameraSystem;
+    std::array<Throw, 3> _throws;
+    uint8_t _numStoredThrows = 0;
     
     bool _isConnected = false;
     bool _isRunning = false;
@@ -94,10 +348,7 @@ namespace autodarts {
     Status _status = Status::Code::UNKNOWN;
     Event _event = Event::Code::UNKNOWN;
 
-    CameraStatsCallback       _onCameraStatsCallback       = [](int8_t, int8_t, int16_t, int16_t){};
-    CameraSystemStateCallback _onCameraSystemStateCallback = [](State, State){};
-    DetectionStateCallback    _onDetectionStateCallback    = [](State, State,  int16_t){};
-    DetectionEventCallback    _onDetectionEventCallback    = [](Status::Code, Event::Code){};
+    EventSink* _sink = nullptr;
   };
 
 
@@ -0,0 +1,146 @@
+#ifndef AutodartsEvents_h_
+#define AutodartsEvents_h_
+
+#include <array>
+#include <functional>
+#include <utility>
+
+#include "AutodartsDefines.h"
+#include "AutodartsMetrics.h"
+
+namespace autodarts {
+
+  // Identifies a listener of a topic: topic id, generation and slot, 0 is never handed out
+  typedef uint32_t Subscription;
+
+  static const Subscription AUTODARTS_NO_SUBSCRIPTION = 0;
+
+  // Fixed number of listeners for one kind of event. The slots are allocated with
+  // the topic, subscribing only assigns the listener to a free slot. Not thread safe,
+  // subscribe and publish on the task that calls Client::updateBoards().
+  //
+  // Listeners are held as std::function. The libstdc++ of the ESP32 core, like the one of
+  // the host build, only stores a listener inline if its captures are trivially copyable
+  // and take at most two pointers, e.g. [this] or [&count, &board]. A larger listener is
+  // allocated once, when it is converted to a std::function. Publishing never allocates.
+  template <size_t N, typename... Args>
+  class Topic {
+    static_assert(N > 0 && N < 256, "Topic needs between 1 and 255 slots");
+
+  public:
+    typedef std::function<void(Args...)> Listener;
+
+    // Time spent in the listeners of a publish is recorded to histogram if given
+    Topic(uint8_t id, MetricHistogram* histogram = nullptr) : _id(id), _histogram(histogram) {}
+
+    Topic(const Topic&) = delete;
+    Topic& operator=(const Topic&) = delete;
+
+    // Listener is only called for publishIf() with changes in mask. It is moved into the
+    // slot, so subscribing does not allocate beyond the conversion to Listener.
+    Subscription subscribe(Listener listener, ChangeMask mask = Change::ALL) {
+      if (!listener) {
+        return AUTODARTS_NO_SUBSCRIPTION;
+      }
+      for (uint8_t idx = 0; idx < N; idx++) {
+        Slot& slot = _slots[idx];
+        if (!slot.active && !slot.listener) {
+          slot.listener = std::move(listener);
+          slot.mask = mask;
+          slot.active = true;
+          return (static_cast<Subscription>(_id) << 16) | (slot.generation << 8) | idx;
+        }
+      }
+      LOG_WARNING(__FUNCTION__, F("No free listener slot in topic ") << _id);
+      return AUTODARTS_NO_SUBSCRIPTION;
+    }
+
+    bool unsubscribe(Subscription subscription) {
+      if (!owns(subscription)) {
+        return false;
+      }
+      Slot& slot = _slots[subscription & 0xFF];
+      if (!slot.active || slot.generation != ((subscription >> 8) & 0xFF)) {
+        return false;
+      }
+
+      // Old tokens of this slot must not match the next listener
+      slot.active = false;
+      slot.generation = slot.generation == 0xFF ? 1 : slot.generation + 1;
+      if (_depth == 0) {
+        slot.listener = nullptr;
+      }
+      else {
+        // The listener may be running right now, it is released after publishing
+        _released = true;
+      }
+      return true;
+    }
+
+    bool owns(Subscription subscription) const {
+      return subscription != AUTODARTS_NO_SUBSCRIPTION && (subscription >> 16) == _id && (subscription & 0xFF) < N;
+    }
+
+    void publish(Args... args) {
+      publishIf(Change::ALL, args...);
+    }
+
+    void publishIf(ChangeMask changes, Args... args) {
+      // The clock is only read if there is a listener to time
+      uint32_t start = 0;
+      bool called = false;
+      _depth++;
+      for (Slot& slot : _slots) {
+        if (slot.active && (slot.mask & changes)) {
+          if (!called && _histogram != nullptr) {
+            start = micros();
+          }
+          called = true;
+          slot.listener(args...);
+        }
+      }
+      _depth--;
+      if (called && _histogram != nullptr) {
+        _histogram->record(micros() - start);
+      }
+
+      if (_depth == 0 && _released) {
+        _released = false;
+        for (Slot& slot : _slots) {
+          if (!slot.active) {
+            slot.listener = nullptr;
+          }
+        }
+      }
+    }
+
+    size_t size() const {
+      size_t count = 0;
+      for (const Slot& slot : _slots) {
+        count += slot.active ? 1 : 0;
+      }
+      return count;
+    }
+
+    size_t capacity() const {
+      return N;
+    }
+
+  private:
+    struct Slot {
+      Listener   listener;
+      ChangeMask mask = Change::ALL;
+      uint8_t    generation = 1;
+      bool       active = false;
+    };
+
+    std::array<Slot, N> _slots;
+    uint8_t _id;
+    MetricHistogram* _histogram;
+    uint8_t _depth = 0;
+    bool _released = false;
+  };
+
+} // autodarts
+
+#endif // AutodartsEvents_h_
@@ -0,0 +1,248 @@
+#ifndef AutodartsHttp_h_
+#define AutodartsHttp_h_
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+
+namespace autodarts {
+
+  // Body of a response, decoded if it was sent with "Transfer-Encoding: chunked" and
+  // limited to the Content-Length otherwise, so that it can be read to its very end
+  class BodyStream : public Stream {
+  public:
+    // A size of -1 is a body that is chunked or ends when the connection is closed
+    void reset(Stream* stream, int size = -1, bool chunked = false) {
+      _stream = stream;
+      _remaining = size > 0 ? size : 0;
+      _sized = size >= 0 && !chunked;
+      _chunked = chunked;
+      _started = false;
+      _finished = _stream == nullptr || size == 0;
+      if (_stream != nullptr) {
+        setTimeout(_stream->getTimeout());
+      }
+    }
+
+    int available() override {
+      if (_stream != nullptr && !_sized && !_chunked) {
+        return _stream->available();
+      }
+      return prepare() ? std::min<int>(_stream->available(), _remaining) : 0;
+    }
+
+    int read() override {
+      if (_stream != nullptr && !_sized && !_chunked) {
+        return _stream->read();
+      }
+      if (!prepare()) {
+        return -1;
+      }
+      int c = _stream->read();
+      if (c >= 0 && --_remaining == 0 && _sized) {
+        _finished = true;
+      }
+      return c;
+    }
+
+    int peek() override {
+      if (_stream != nullptr && !_sized && !_chunked) {
+        return _stream->peek();
+      }
+      return prepare() ? _stream->peek() : -1;
+    }
+
+    size_t write(uint8_t) override {
+      return 0;
+    }
+
+    // Reads the body up to its end without waiting for the timeout once it is complete
+    String readAll() {
+      if (_stream != nullptr && !_sized && !_chunked) {
+        return readString();
+      }
+      String body;
+      while (prepare()) {
+        int c = timedRead();
+        if (c < 0) {
+          break;
+        }
+        body += static_cast<char>(c);
+      }
+      return body;
+    }
+
+    // Reads what is left of the body, false if it did not arrive in time or its end is unknown
+    bool skip() {
+      if (_stream == nullptr || (!_sized && !_chunked)) {
+        return _finished;
+      }
+      while (prepare()) {
+        if (timedRead() < 0) {
+          return false;
+        }
+      }
+      return _finished;
+    }
+
+  private:
+    // Reads the next chunk header once the current chunk has been consumed
+    bool prepare() {
+      if (_remaining > 0) {
+        return true;
+      }
+      if (_finished || !_chunked || _stream == nullptr) {
+        return false;
+      }
+      if (_started && !_stream->find("\r\n")) {
+        _stream = nullptr;
+        return false;
+      }
+      _started = true;
+
+      char header[16];
+      size_t length = _stream->readBytesUntil('\n', header, sizeof(header) - 1);
+      header[length] = '\0';
+      _remaining = strtoul(header, nullptr, 16);
+      if (length == 0) {
+        _stream = nullptr;
+        return false;
+      }
+      if (_remaining == 0) {
+        // The last chunk is followed by an empty line
+        _finished = _stream->find("\r\n");
+        return false;
+      }
+      return true;
+    }
+
+    Stream* _stream = nullptr;
+    size_t  _remaining = 0;
+    bool    _sized = false;
+    bool    _chunked = false;
+    bool    _started = false;
+    bool    _finished = false;
+  };
+
+
+  // Keeps the TLS connection to one host open between requests. Every request
+  // has to be enclosed in begin() and end(), which serialize access across tasks.
+  // The server is verified against the root certificate or bundle that is set, without
+  // either no connection is opened unless verification has been turned off.
+  class HttpSession {
+  public:
+    HttpSession() {
+      _http.setReuse(true);
+    }
+
+    HttpSession(const HttpSession&) = delete;
+    HttpSession& operator=(const HttpSession&) = delete;
+
+    // Has to outlive the session
+    void setCACert(const char* rootCA) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _secure.stop();
+      _secure.setCACert(rootCA);
+    }
+
+    // Has to outlive the session
+    void setCACertBundle(const uint8_t* bundle) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _secure.stop();
+      _secure.setCACertBundle(bundle);
+    }
+
+    // Accepts any server, only for tests and networks that are trusted anyway
+    void setInsecure() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _secure.stop();
+      _secure.setInsecure();
+    }
+
+    HTTPClient& begin(const char* url) {
+      static const char* headers[] = { "Transfer-Encoding", "ETag" };
+
+      _mutex.lock();
+      _reused = _secure.connected();
+      _http.begin(_secure, url);
+      _http.collectHeaders(headers, 2);
+      return _http;
+    }
+
+    // A kept alive connection may have been closed by the server in the meantime,
+    // in that case the request is repeated once on a new connection
+    int send(const char* method, const String& payload = String()) {
+      int ret = _http.sendRequest(method, payload);
+      if (ret < 0 && _reused) {
+        _secure.stop();
+        _reused = false;
+        ret = _http.sendRequest(method, payload);
+      }
+
+      if (_reused) {
+        _numReused++;
+      }
+      else {
+        _numHandshakes++;
+      }
+
+      // Responses to HEAD and 1xx, 204 and 304 responses never have a body
+      if (ret < HTTP_CODE_OK || ret == HTTP_CODE_NO_CONTENT || ret == HTTP_CODE_NOT_MODIFIED || strcmp(method, "HEAD") == 0) {
+        _body.reset(&_http.getStream(), 0);
+      }
+      else {
+        _body.reset(&_http.getStream(), _http.getSize(), _http.header("Transfer-Encoding").equalsIgnoreCase("chunked"));
+      }
+      return ret;
+    }
+
+    // Body of the response with the transfer encoding removed
+    Stream& getStream() {
+      return _body;
+    }
+
+    String getString() {
+      return _body.readAll();
+    }
+
+    // The rest of the body is read first, otherwise it would be taken for the response to
+    // the next request. Without a known end the connection can not be reused.
+    void end() {
+      if (_secure.connected() && !_body.skip()) {
+        _secure.stop();
+      }
+      _http.end();
+      _body.reset(nullptr);
+      _mutex.unlock();
+    }
+
+    // Drops the connection to free the memory held by the TLS context
+    void close() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _secure.stop();
+    }
+
+    uint32_t getNumHandshakes() const {
+      return _numHandshakes;
+    }
+
+    uint32_t getNumReused() const {
+      return _numReused;
+    }
+
+  private:
+    WiFiClientSecure _secure;
+    HTTPClient _http;
+    BodyStream _body;
+    std::mutex _mutex;
+    bool _reused = false;
+    std::atomic<uint32_t> _numHandshakes{0};
+    std::atomic<uint32_t> _numReused{0};
+  };
+
+} // autodarts
+
+#endif // AutodartsHttp_h_
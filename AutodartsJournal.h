@@ -0,0 +1,150 @@
+#ifndef AutodartsJournal_h_
+#define AutodartsJournal_h_
+
+#include <array>
+#include <string.h>
+
+#include <FS.h>
+
+#include "AutodartsBinary.h"
+#include "AutodartsDefines.h"
+
+namespace autodarts {
+
+  static const uint8_t AUTODARTS_JOURNAL_MAGIC[3]   = {'A', 'D', 'J'};
+  static const uint8_t AUTODARTS_JOURNAL_VERSION    = 1;
+  static const size_t  AUTODARTS_JOURNAL_HEADER     = 4;  // Magic and version at the start of the file
+  static const size_t  AUTODARTS_JOURNAL_RECORD     = 23; // Record header in front of the payload
+
+  enum class JournalRecord : uint8_t {
+    TEXT         = 1, // Raw board manager message
+    CONNECTED    = 2,
+    DISCONNECTED = 3,
+  };
+
+  // Append-only recording of the raw frames and connection changes of all boards of a
+  // client, so a session can be replayed later with JournalReplay. Records are collected
+  // in a block and written when it is full or older than AUTODARTS_JOURNAL_FLUSH.
+  //
+  // Every record is u8 type, u32 millis(), 16 bytes board id, u16 payload length and the
+  // payload, all little endian. Not thread safe, record on the task that updates the boards.
+  class Journal {
+  public:
+    Journal() = default;
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    ~Journal() {
+      end();
+    }
+
+    // Appends to the file on a LittleFS or SD file system, new files start with the header
+    bool begin(fs::FS& fs, const char* path) {
+      end();
+      _file = fs.open(path, FILE_APPEND);
+      if (!_file) {
+        LOG_ERROR("Journal", F("Could not open ") << path);
+        return false;
+      }
+      if (_file.size() == 0) {
+        append(AUTODARTS_JOURNAL_MAGIC, sizeof(AUTODARTS_JOURNAL_MAGIC));
+        append(&AUTODARTS_JOURNAL_VERSION, 1);
+      }
+      return true;
+    }
+
+    void end() {
+      if (_file) {
+        flush();
+        _file.close();
+      }
+    }
+
+    bool isOpen() const {
+      return _file;
+    }
+
+    void record(const Uuid& board, JournalRecord type, const uint8_t* payload = nullptr, size_t length = 0) {
+      if (!_file) {
+        return;
+      }
+      if (length > 0xFFFF) {
+        _droppedRecords++;
+        return;
+      }
+
+      std::array<uint8_t, AUTODARTS_JOURNAL_RECORD> header;
+      BinaryWriter writer(header.data(), header.size());
+      writer.writeU8(static_cast<uint8_t>(type));
+      writer.writeU32(millis());
+      writer.writeBytes(board.bytes.data(), board.bytes.size());
+      writer.writeU16(length);
+
+      append(header.data(), header.size());
+      append(payload, length);
+      _numRecords++;
+    }
+
+    // Writes the pending block once it is older than AUTODARTS_JOURNAL_FLUSH
+    void update() {
+      if (_used > 0 && millis() - _blockSince >= AUTODARTS_JOURNAL_FLUSH) {
+        flush();
+      }
+    }
+
+    void flush() {
+      if (!_file) {
+        return;
+      }
+      write(_block.data(), _used);
+      _used = 0;
+      _file.flush();
+    }
+
+    uint32_t getNumRecords() const {
+      return _numRecords;
+    }
+
+    // Records lost because they were too large or the file system was full
+    uint32_t getDroppedRecords() const {
+      return _droppedRecords;
+    }
+
+  private:
+    void append(const uint8_t* data, size_t length) {
+      if (length == 0) {
+        return;
+      }
+      if (length > _block.size() - _used) {
+        write(_block.data(), _used);
+        _used = 0;
+      }
+      // Large frames bypass the block instead of being split
+      if (length >= _block.size()) {
+        write(data, length);
+        return;
+      }
+      if (_used == 0) {
+        _blockSince = millis();
+      }
+      memcpy(_block.data() + _used, data, length);
+      _used += length;
+    }
+
+    void write(const uint8_t* data, size_t length) {
+      if (length > 0 && _file.write(data, length) != length) {
+        _droppedRecords++;
+      }
+    }
+
+    fs::File _file;
+    std::array<uint8_t, AUTODARTS_JOURNAL_BLOCK> _block;
+    size_t   _used = 0;
+    uint32_t _blockSince = 0;
+    uint32_t _numRecords = 0;
+    uint32_t _droppedRecords = 0;
+  };
+
+} // autodarts
+
+#endif // AutodartsJournal_h_
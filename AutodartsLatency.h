@@ -0,0 +1,87 @@
+#ifndef AutodartsLatency_h_
+#define AutodartsLatency_h_
+
+#include <array>
+
+#include <Arduino.h>
+
+namespace autodarts {
+
+  // Stages of a throw from the websocket to the application callback
+  enum class LatencyStage : uint8_t {
+    PARSE,     // Message received until the dart has been parsed
+    DISPATCH,  // Dart parsed until the callback is entered
+    TOTAL,     // Message received until the callback is entered
+  };
+
+  static const uint8_t AUTODARTS_LATENCY_STAGES = 3;
+
+  // Histogram of durations in microseconds with power of two buckets. Bucket 0
+  // counts 0 us, bucket i counts durations below 2^i us, the last one everything above.
+  class LatencyHistogram {
+  public:
+    static const uint8_t NUM_BUCKETS = 21; // Last regular bucket ends at ~1 s
+
+    void record(uint32_t duration) {
+      uint8_t idx = duration == 0 ? 0 : 32 - __builtin_clz(duration);
+      _buckets[idx < NUM_BUCKETS ? idx : NUM_BUCKETS - 1]++;
+      _count++;
+      _sum += duration;
+      if (duration > _max) {
+        _max = duration;
+      }
+    }
+
+    void reset() {
+      _buckets.fill(0);
+      _count = 0;
+      _sum = 0;
+      _max = 0;
+    }
+
+    uint32_t getCount() const {
+      return _count;
+    }
+
+    uint32_t getMax() const {
+      return _max;
+    }
+
+    uint64_t getSum() const {
+      return _sum;
+    }
+
+    uint32_t getMean() const {
+      return _count > 0 ? _sum / _count : 0;
+    }
+
+    uint32_t getBucket(uint8_t idx) const {
+      return idx < NUM_BUCKETS ? _buckets[idx] : 0;
+    }
+
+    // Upper bound in microseconds of the bucket that contains the percentile
+    uint32_t getPercentile(uint8_t pct) const {
+      if (_count == 0) {
+        return 0;
+      }
+      uint64_t rank = (static_cast<uint64_t>(pct) * _count + 99) / 100;
+      uint64_t seen = 0;
+      for (uint8_t idx = 0; idx < NUM_BUCKETS; idx++) {
+        seen += _buckets[idx];
+        if (seen >= rank && seen > 0) {
+          return idx + 1 < NUM_BUCKETS ? (1UL << idx) : _max;
+        }
+      }
+      return _max;
+    }
+
+  private:
+    std::array<uint32_t, NUM_BUCKETS> _buckets{};
+    uint32_t _count = 0;
+    uint64_t _sum = 0;
+    uint32_t _max = 0;
+  };
+
+} // autodarts
+
+#endif // AutodartsLatency_h_
@@ -0,0 +1,173 @@
+#ifndef AutodartsMetrics_h_
+#define AutodartsMetrics_h_
+
+#include <array>
+#include <atomic>
+
+#include <Arduino.h>
+
+#include "AutodartsDefines.h"
+#include "AutodartsLatency.h"
+
+namespace autodarts {
+
+  // Event counter that any task can increment without a lock
+  class MetricCounter {
+  public:
+    void increment(uint32_t count = 1) {
+      _value.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    uint32_t get() const {
+      return _value.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<uint32_t> _value{0};
+  };
+
+  // Durations in microseconds with the buckets of LatencyHistogram, recorded without a lock.
+  // The sum wraps after about 71 minutes of accumulated time, Prometheus takes that for a counter
+  // reset and rate() only misses part of one scrape interval. The ESP32 has no lock free 64 bit
+  // atomics, a wider sum would take a lock on every record.
+  class MetricHistogram {
+  public:
+    static const uint8_t NUM_BUCKETS = LatencyHistogram::NUM_BUCKETS;
+
+    void record(uint32_t duration) {
+      uint8_t idx = duration == 0 ? 0 : 32 - __builtin_clz(duration);
+      _buckets[idx < NUM_BUCKETS ? idx : NUM_BUCKETS - 1].fetch_add(1, std::memory_order_relaxed);
+      _count.fetch_add(1, std::memory_order_relaxed);
+      _sum.fetch_add(duration, std::memory_order_relaxed);
+    }
+
+    uint32_t getCount() const {
+      return _count.load(std::memory_order_relaxed);
+    }
+
+    uint32_t getSum() const {
+      return _sum.load(std::memory_order_relaxed);
+    }
+
+    uint32_t getBucket(uint8_t idx) const {
+      return idx < NUM_BUCKETS ? _buckets[idx].load(std::memory_order_relaxed) : 0;
+    }
+
+  private:
+    std::array<std::atomic<uint32_t>, NUM_BUCKETS> _buckets{};
+    std::atomic<uint32_t> _count{0};
+    std::atomic<uint32_t> _sum{0};
+  };
+
+  // Counters of one board, incremented on the task that updates the boards
+  struct BoardMetrics {
+    std::array<MetricCounter, 4> frames; // By Message::Type, unknown first
+    MetricCounter parseErrors;
+    MetricCounter connects;
+    MetricCounter connectTimeouts;
+    MetricCounter aliveTimeouts;
+
+    MetricCounter& framesOf(Message::Type type) {
+      return frames[static_cast<int8_t>(type) + 1];
+    }
+  };
+
+  // Requests to autodarts.io whose latency is recorded
+  enum class HttpEndpoint : uint8_t {
+    TOKEN,
+    TICKET,
+    BOARDS,
+  };
+
+  static const uint8_t AUTODARTS_HTTP_ENDPOINTS = 3;
+
+  // Collects printed lines, e.g. the samples of one board that are written out together
+  class MetricsBuffer : public Print {
+  public:
+    size_t write(uint8_t c) override {
+      _text += static_cast<char>(c);
+      return 1;
+    }
+
+    const String& getText() const {
+      return _text;
+    }
+
+  private:
+    String _text;
+  };
+
+  // Writes metrics in the Prometheus text format, durations are converted to seconds
+  class PrometheusWriter {
+  public:
+    PrometheusWriter(Print& out) : _out(out) {}
+
+    void header(const char* name, const char* type, const char* help) {
+      _out.print(F("# HELP "));
+      _out.print(name);
+      _out.print(' ');
+      _out.println(help);
+      _out.print(F("# TYPE "));
+      _out.print(name);
+      _out.print(' ');
+      _out.println(type);
+    }
+
+    void sample(const char* name, const String& labels, uint32_t value) {
+      begin(name, labels);
+      _out.println(value);
+    }
+
+    // Bucket i ends below 2^i us, the last one is only covered by +Inf
+    template <typename Histogram>
+    void histogram(const char* name, const String& labels, const Histogram& histogram) {
+      String bucket = String(name) + "_bucket";
+      String separator = labels.isEmpty() ? "" : ",";
+      uint32_t cumulative = 0;
+      for (uint8_t idx = 0; idx < Histogram::NUM_BUCKETS; idx++) {
+        cumulative += histogram.getBucket(idx);
+        if (idx + 1 < Histogram::NUM_BUCKETS) {
+          begin(bucket.c_str(), labels + separator + "le=\"" + String(((1UL << idx) - 1) / 1e6, 6) + "\"");
+        }
+        else {
+          begin(bucket.c_str(), labels + separator + "le=\"+Inf\"");
+        }
+        _out.println(cumulative);
+      }
+      begin((String(name) + "_sum").c_str(), labels);
+      _out.println(histogram.getSum() / 1e6, 6);
+      begin((String(name) + "_count").c_str(), labels);
+      _out.println(cumulative);
+    }
+
+    // Label value with backslashes, quotes and line breaks escaped
+    static String escape(const String& value) {
+      String escaped;
+      escaped.reserve(value.length());
+      for (size_t idx = 0; idx < value.length(); idx++) {
+        char c = value[idx];
+        if (c == '\\' || c == '"' || c == '\n') {
+          escaped += '\\';
+        }
+        escaped += c == '\n' ? 'n' : c;
+      }
+      return escaped;
+    }
+
+  private:
+    void begin(const char* name, const String& labels) {
+      _out.print(name);
+      if (!labels.isEmpty()) {
+        _out.print('{');
+        _out.print(labels);
+        _out.print('}');
+      }
+      _out.print(' ');
+    }
+
+    Print& _out;
+  };
+
+} // autodarts
+
+#endif // AutodartsMetrics_h_
@@ -0,0 +1,54 @@
+#ifndef AutodartsQueue_h_
+#define AutodartsQueue_h_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace autodarts {
+
+  // Lock-free ring buffer for exactly one producer and one consumer task.
+  // Capacity must be a power of two, one slot is kept free to tell full from empty.
+  template <typename T, size_t N>
+  class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Capacity must be a power of two");
+
+  public:
+    bool push(const T& value) {
+      size_t head = _head.load(std::memory_order_relaxed);
+      size_t next = (head + 1) & (N - 1);
+      if (next == _tail.load(std::memory_order_acquire)) {
+        return false;
+      }
+      _buffer[head] = value;
+      _head.store(next, std::memory_order_release);
+      return true;
+    }
+
+    bool pop(T& value) {
+      size_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail == _head.load(std::memory_order_acquire)) {
+        return false;
+      }
+      value = _buffer[tail];
+      _tail.store((tail + 1) & (N - 1), std::memory_order_release);
+      return true;
+    }
+
+    bool isEmpty() const {
+      return _tail.load(std::memory_order_acquire) == _head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+      return N - 1;
+    }
+
+  private:
+    std::array<T, N> _buffer;
+    std::atomic<size_t> _head{0};
+    std::atomic<size_t> _tail{0};
+  };
+
+} // autodarts
+
+#endif // AutodartsQueue_h_
@@ -0,0 +1,183 @@
+#ifndef AutodartsReconnect_h_
+#define AutodartsReconnect_h_
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "AutodartsDefines.h"
+#include "AutodartsRegistry.h"
+
+namespace autodarts {
+
+  // Decides when the boards of a client (re)connect. Failed boards back off
+  // exponentially with jitter, and only a limited number of handshakes run at the
+  // same time, so controllers do not hit the board managers in lockstep after a
+  // power or Wi-Fi outage. Boards that dropped after a healthy connection retry quickly.
+  // Only connections of this uptime count as healthy: boards restored at boot are spread
+  // and capped like added ones, since all controllers of a venue boot at the same time.
+  class ReconnectScheduler {
+  public:
+    typedef BoardRegistry::Handle Handle;
+
+    struct Policy {
+      uint32_t minDelay      = 1000;   // Backoff after the first failure
+      uint32_t maxDelay      = 60000;  // Upper bound of the backoff
+      uint32_t healthyAfter  = 30000;  // Connections lasting this long reset the backoff
+      uint8_t  maxConnecting = 2;      // Handshakes running at the same time
+    };
+
+    void setPolicy(const Policy& policy) {
+      _policy = policy;
+    }
+
+    const Policy& getPolicy() const {
+      return _policy;
+    }
+
+    // Keeps the board connected from now on, the first attempt is spread over minDelay.
+    // Boards that have been healthy since boot skip the spread and the handshake cap.
+    void request(Handle handle, bool immediately = false) {
+      Entry& entry = at(handle);
+      if (entry.wanted && !immediately) {
+        return;
+      }
+      // An attempt that has not succeeded yet is dropped and does not count as healthy
+      bool healthy = entry.healthy && !entry.attempted;
+      entry = Entry();
+      entry.wanted = true;
+      entry.healthy = healthy;
+      entry.fast = healthy;
+      entry.nextAttempt = millis() + (immediately || healthy ? 0 : jitter(_policy.minDelay));
+    }
+
+    bool isRequested(Handle handle) const {
+      uint16_t slot = BoardRegistry::slot(handle);
+      return slot < _entries.size() && _entries[slot].wanted;
+    }
+
+    // Stops managing the board, e.g. because it was deleted
+    void release(Handle handle) {
+      uint16_t slot = BoardRegistry::slot(handle);
+      if (slot < _entries.size()) {
+        _entries[slot] = Entry();
+      }
+    }
+
+    uint32_t getNumAttempts() const {
+      return _numAttempts;
+    }
+
+    // Number of consecutive failed attempts of a board
+    uint8_t getFailures(Handle handle) const {
+      uint16_t slot = BoardRegistry::slot(handle);
+      return slot < _entries.size() ? _entries[slot].failures : 0;
+    }
+
+    // Has to run on the task that updates the boards, with the registry locked. Each board
+    // is locked while it is looked at, other tasks read its connection under that lock.
+    void update(const BoardRegistry& boards) {
+      uint32_t now = millis();
+      uint8_t connecting = 0;
+      for (const Board& board : boards) {
+        std::lock_guard<std::recursive_mutex> lock(board.getMutex());
+        connecting += board.isConnecting() ? 1 : 0;
+      }
+
+      for (auto it = boards.begin(); it != boards.end(); ++it) {
+        if (it.slot() >= _entries.size() || !_entries[it.slot()].wanted) {
+          continue;
+        }
+        Entry& entry = _entries[it.slot()];
+        Board& board = *it;
+        std::lock_guard<std::recursive_mutex> lock(board.getMutex());
+
+        if (board.isOpen()) {
+          if (!entry.open) {
+            entry.open = true;
+            entry.attempted = false;
+            entry.connectedAt = now;
+          }
+          else if (!entry.healthy && now - entry.connectedAt >= _policy.healthyAfter) {
+            entry.failures = 0;
+            entry.healthy = true;
+          }
+          continue;
+        }
+        if (board.isConnecting()) {
+          continue;
+        }
+
+        if (entry.open) {
+          // Dropped connection, retry quickly if it has been healthy
+          entry.open = false;
+          if (now - entry.connectedAt >= _policy.healthyAfter) {
+            entry.failures = 0;
+            entry.nextAttempt = now + jitter(_policy.minDelay / 4);
+          }
+          else {
+            backoff(entry, now);
+          }
+        }
+        else if (entry.attempted) {
+          entry.attempted = false;
+          backoff(entry, now);
+        }
+
+        if (static_cast<int32_t>(now - entry.nextAttempt) < 0 || (connecting >= _policy.maxConnecting && !entry.fast)) {
+          continue;
+        }
+
+        if (board.open(true)) {
+          entry.attempted = true;
+          entry.fast = false;
+          connecting++;
+          _numAttempts++;
+        }
+        else {
+          backoff(entry, now);
+        }
+      }
+    }
+
+  private:
+    struct Entry {
+      bool     wanted = false;
+      bool     open = false;
+      bool     attempted = false;
+      bool     healthy = false;   // Connected for healthyAfter since boot
+      bool     fast = false;      // The next attempt skips the handshake cap
+      uint8_t  failures = 0;
+      uint32_t nextAttempt = 0;
+      uint32_t connectedAt = 0;
+    };
+
+    Entry& at(Handle handle) {
+      uint16_t slot = BoardRegistry::slot(handle);
+      if (slot >= _entries.size()) {
+        _entries.resize(slot + 1);
+      }
+      return _entries[slot];
+    }
+
+    // Equal jitter: half of the exponential delay is fixed, the other half random
+    void backoff(Entry& entry, uint32_t now) {
+      entry.healthy = false;
+      entry.fast = false;
+      entry.failures = std::min<uint8_t>(entry.failures + 1, 16);
+      uint32_t delay = std::min<uint64_t>(static_cast<uint64_t>(_policy.minDelay) << (entry.failures - 1), _policy.maxDelay);
+      entry.nextAttempt = now + delay / 2 + jitter(delay / 2);
+    }
+
+    static uint32_t jitter(uint32_t range) {
+      return range > 0 ? random(range + 1) : 0;
+    }
+
+    Policy _policy;
+    std::vector<Entry> _entries;
+    uint32_t _numAttempts = 0;
+  };
+
+} // autodarts
+
+#endif // AutodartsReconnect_h_
@@ -0,0 +1,228 @@
+#ifndef AutodartsRegistry_h_
+#define AutodartsRegistry_h_
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "AutodartsBoard.h"
+
+namespace autodarts {
+
+  // Owns the boards of a client. Every board keeps its slot until it is erased. A handle
+  // is the slot and the generation of the slot, which changes when the slot is reused, so
+  // the handle of an erased board stays invalid. Bookkeeping per board is indexed by slot.
+  // Lookup by id uses an open addressing table with linear probing over the hash of the
+  // binary id.
+  class BoardRegistry {
+  public:
+    typedef std::unique_ptr<Board> BoardPtr;
+    typedef uint32_t Handle;
+
+    static const Handle INVALID = 0xFFFFFFFF;
+
+    static uint16_t slot(Handle handle) {
+      return handle & 0xFFFF;
+    }
+
+    class Iterator {
+    public:
+      Iterator(const BoardRegistry& registry, size_t idx) : _registry(registry), _idx(idx) {
+        skip();
+      }
+
+      Board& operator*() const {
+        return *_registry._slots[_idx];
+      }
+
+      Board* operator->() const {
+        return _registry._slots[_idx].get();
+      }
+
+      Handle handle() const {
+        return _registry.handleOf(_idx);
+      }
+
+      uint16_t slot() const {
+        return _idx;
+      }
+
+      Iterator& operator++() {
+        _idx++;
+        skip();
+        return *this;
+      }
+
+      bool operator!=(const Iterator& other) const {
+        return _idx != other._idx;
+      }
+
+    private:
+      void skip() {
+        while (_idx < _registry._slots.size() && !_registry._slots[_idx]) {
+          _idx++;
+        }
+      }
+
+      const BoardRegistry& _registry;
+      size_t _idx;
+    };
+
+    Iterator begin() const {
+      return Iterator(*this, 0);
+    }
+
+    Iterator end() const {
+      return Iterator(*this, _slots.size());
+    }
+
+    size_t size() const {
+      return _size;
+    }
+
+    // Upper bound of all slots, e.g. to size per board bookkeeping
+    size_t capacity() const {
+      return _slots.size();
+    }
+
+    Board* get(Handle handle) const {
+      uint16_t idx = slot(handle);
+      return idx < _slots.size() && _generations[idx] == handle >> 16 ? _slots[idx].get() : nullptr;
+    }
+
+    // Handle of the board in a slot, INVALID for an empty slot
+    Handle handleAt(size_t idx) const {
+      return idx < _slots.size() && _slots[idx] ? handleOf(idx) : INVALID;
+    }
+
+    Handle find(const char* id) const {
+      Uuid uuid;
+      if (id == nullptr || !Uuid::fromString(id, uuid)) {
+        return INVALID;
+      }
+      return find(uuid);
+    }
+
+    Handle find(const Uuid& id) const {
+      if (_index.empty()) {
+        return INVALID;
+      }
+
+      uint32_t hash = id.hash();
+      for (size_t pos = hash & (_index.size() - 1);; pos = (pos + 1) & (_index.size() - 1)) {
+        const Entry& entry = _index[pos];
+        if (entry.slot == EMPTY) {
+          return INVALID;
+        }
+        if (entry.slot != TOMBSTONE && entry.hash == hash && _slots[entry.slot]->getUuid() == id) {
+          return handleOf(entry.slot);
+        }
+      }
+    }
+
+    // A board whose id is already in the registry is refused
+    Handle insert(BoardPtr board) {
+      if (!board || _size >= TOMBSTONE || find(board->getUuid()) != INVALID) {
+        return INVALID;
+      }
+
+      uint16_t idx;
+      if (_free.empty()) {
+        idx = _slots.size();
+        _slots.push_back(std::move(board));
+        _generations.push_back(0);
+      }
+      else {
+        idx = _free.back();
+        _free.pop_back();
+        _slots[idx] = std::move(board);
+      }
+      _size++;
+
+      // Keep the table at most half full, counting tombstones
+      if ((_used + 1) * 2 > _index.size()) {
+        rehash(std::max<size_t>(16, _size * 4));
+      }
+      place(_slots[idx]->getUuid().hash(), idx);
+      return handleOf(idx);
+    }
+
+    BoardPtr erase(Handle handle) {
+      Board* board = get(handle);
+      if (board == nullptr) {
+        return BoardPtr();
+      }
+
+      uint16_t idx = slot(handle);
+      uint32_t hash = board->getUuid().hash();
+      for (size_t pos = hash & (_index.size() - 1);; pos = (pos + 1) & (_index.size() - 1)) {
+        Entry& entry = _index[pos];
+        if (entry.slot == EMPTY) {
+          break;
+        }
+        if (entry.slot == idx) {
+          entry.slot = TOMBSTONE;
+          break;
+        }
+      }
+
+      _size--;
+      _free.push_back(idx);
+      _generations[idx]++;
+      return std::move(_slots[idx]);
+    }
+
+  private:
+    static const uint16_t EMPTY = 0xFFFF;
+    static const uint16_t TOMBSTONE = 0xFFFE;
+
+    struct Entry {
+      uint32_t hash;
+      uint16_t slot;
+    };
+
+    Handle handleOf(size_t idx) const {
+      return static_cast<Handle>(_generations[idx]) << 16 | idx;
+    }
+
+    void place(uint32_t hash, uint16_t idx) {
+      for (size_t pos = hash & (_index.size() - 1);; pos = (pos + 1) & (_index.size() - 1)) {
+        Entry& entry = _index[pos];
+        if (entry.slot == EMPTY || entry.slot == TOMBSTONE) {
+          if (entry.slot == EMPTY) {
+            _used++;
+          }
+          entry.hash = hash;
+          entry.slot = idx;
+          return;
+        }
+      }
+    }
+
+    void rehash(size_t minimum) {
+      size_t capacity = 16;
+      while (capacity < minimum) {
+        capacity *= 2;
+      }
+
+      std::vector<Entry> index(capacity, Entry{0, EMPTY});
+      _index.swap(index);
+      _used = 0;
+      for (const Entry& entry : index) {
+        if (entry.slot != EMPTY && entry.slot != TOMBSTONE) {
+          place(entry.hash, entry.slot);
+        }
+      }
+    }
+
+    std::vector<BoardPtr> _slots;
+    std::vector<uint16_t> _generations; // By slot, counts the boards erased from it
+    std::vector<uint16_t> _free;
+    std::vector<Entry> _index;
+    size_t _size = 0;
+    size_t _used = 0;
+  };
+
+} // autodarts
+
+#endif // AutodartsRegistry_h_
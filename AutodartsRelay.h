@@ -0,0 +1,312 @@
+#ifndef AutodartsRelay_h_
+#define AutodartsRelay_h_
+
+#include <array>
+#include <mutex>
+
+#include <ArduinoJson.h>
+#include <WebSocketsServer.h>
+
+#include "AutodartsDefines.h"
+#include "AutodartsRegistry.h"
+
+namespace autodarts {
+
+  // Serves the events of all boards of one client to displays on the local network, so
+  // only the relaying controller connects to the board managers. Messages have the shape
+  // of the board manager events plus the board id. Every message is serialized once into
+  // one of AUTODARTS_RELAY_BUFFERS buffers, which the fixed queues of all subscribers
+  // share, so relaying does not allocate. A subscriber that falls behind loses stale
+  // cam_stats first, then older messages replaced by newer ones of the same board. If no
+  // buffer is free the oldest queued messages are dropped.
+  // New subscribers get the current state of every board first, which is sent outside
+  // the queue as the socket accepts it, so it is complete for any number of boards.
+  class RelayServer {
+  public:
+    RelayServer(const BoardRegistry& boards, std::recursive_mutex& boardsMutex, uint16_t port = AUTODARTS_RELAY_PORT)
+      : _boards(boards), _boardsMutex(boardsMutex), _server(port) {}
+
+    RelayServer(const RelayServer&) = delete;
+    RelayServer& operator=(const RelayServer&) = delete;
+
+    void begin() {
+      _server.onEvent([this](uint8_t num, WStype_t type, uint8_t* payload, size_t length) {
+        if (num >= _subscribers.size()) {
+          return;
+        }
+        switch (type) {
+          case WStype_CONNECTED:
+            LOG_INFO("Relay", F("Subscriber ") << num << F(" connected"));
+            _subscribers[num].connected = true;
+            clear(_subscribers[num]);
+            _subscribers[num].joining = true;
+            _subscribers[num].next = 0;
+            _subscribers[num].part = 0;
+            break;
+          case WStype_DISCONNECTED:
+            LOG_INFO("Relay", F("Subscriber ") << num << F(" disconnected"));
+            _subscribers[num].connected = false;
+            clear(_subscribers[num]);
+            break;
+          default:
+            break;
+        }
+      });
+      _server.begin();
+    }
+
+    void stop() {
+      _server.close();
+      for (Subscriber& subscriber : _subscribers) {
+        subscriber.connected = false;
+        clear(subscriber);
+      }
+    }
+
+    // Sends up to AUTODARTS_RELAY_BURST snapshot or queued messages to every subscriber
+    void update() {
+      _server.loop();
+      for (uint8_t num = 0; num < _subscribers.size(); num++) {
+        Subscriber& subscriber = _subscribers[num];
+        uint8_t sent = subscriber.connected && subscriber.joining ? snapshot(num, subscriber) : 0;
+        while (subscriber.connected && !subscriber.joining && subscriber.count > 0 && sent < AUTODARTS_RELAY_BURST) {
+          Buffer& buffer = _buffers[subscriber.at(0).buffer];
+          if (!_server.sendTXT(num, buffer.data.data(), buffer.length)) {
+            break;
+          }
+          pop(subscriber);
+          sent++;
+        }
+      }
+    }
+
+    // Queues the messages for the parts of the board that changed. The mask does not say
+    // which camera changed, cam_stats are queued by publishStats() instead.
+    void publish(const Board& board, ChangeMask changes) {
+      if (getNumSubscribers() == 0) {
+        return;
+      }
+      if (changes & (Change::DETECTION_STATE | Change::DETECTION_EVENT | Change::THROWS)) {
+        broadcast(board, Message::Type::STATE);
+      }
+      if (changes & Change::CAMERA_STATE) {
+        broadcast(board, Message::Type::CAM_STATE);
+      }
+    }
+
+    // Queues the cam_stats of the one camera whose stats changed
+    void publishStats(const Board& board, int8_t camera) {
+      if (getNumSubscribers() == 0 || !board.getDetector().getCameraSystem().hasCamera(camera)) {
+        return;
+      }
+      broadcast(board, Message::Type::CAM_STATS, camera);
+    }
+
+    uint8_t getNumSubscribers() const {
+      uint8_t count = 0;
+      for (const Subscriber& subscriber : _subscribers) {
+        count += subscriber.connected ? 1 : 0;
+      }
+      return count;
+    }
+
+    // Messages dropped because a subscriber could not keep up
+    uint32_t getDroppedMessages() const {
+      return _droppedMessages;
+    }
+
+  private:
+    struct Buffer {
+      std::array<char, AUTODARTS_RELAY_MESSAGE> data;
+      uint16_t length = 0;
+      uint8_t  refs = 0; // Queued frames that point to this buffer
+    };
+
+    struct Frame {
+      uint8_t       buffer;
+      Uuid          board;
+      Message::Type type;
+      int8_t        camera;
+    };
+
+    struct Subscriber {
+      bool                  connected = false;
+      bool                  joining = false; // The snapshot has not been sent completely
+      uint16_t              next = 0;        // Slot of the board and part of the snapshot sent next
+      uint8_t               part = 0;
+      std::array<Frame, AUTODARTS_RELAY_QUEUE> frames; // Ring of count frames from head on
+      uint8_t               head = 0;
+      uint8_t               count = 0;
+
+      Frame& at(uint8_t idx) {
+        return frames[(head + idx) % AUTODARTS_RELAY_QUEUE];
+      }
+    };
+
+    // Parts of a board in the order of the snapshot: state, camera state, stats of every camera
+    static uint8_t partOf(Message::Type type, int8_t camera) {
+      switch (type) {
+        case Message::Type::STATE:     return 0;
+        case Message::Type::CAM_STATE: return 1;
+        default:                       return 2 + camera;
+      }
+    }
+
+    // Writes the message null terminated into data, 0 if it does not fit
+    static size_t serialize(const Board& board, Message::Type type, int8_t camera, char* data, size_t size) {
+      char id[37];
+      board.getUuid().toChars(id);
+      StaticJsonDocument<1024> json;
+      JsonObject root = json.to<JsonObject>();
+      root["board"] = static_cast<const char*>(id);
+      const Detector& detector = board.getDetector();
+      switch (type) {
+        case Message::Type::STATE:
+          detector.toJson(root);
+          break;
+        case Message::Type::CAM_STATE:
+          detector.getCameraSystem().toJson(root);
+          break;
+        default:
+          detector.getCameraSystem()[camera].toJson(root);
+          break;
+      }
+
+      if (measureJson(json) >= size) {
+        LOG_WARNING("Relay", F("Message of ") << board.getName() << F(" is too large"));
+        return 0;
+      }
+      return serializeJson(json, data, size);
+    }
+
+    void broadcast(const Board& board, Message::Type type, int8_t camera = -1) {
+      uint8_t idx = acquire();
+      Buffer& buffer = _buffers[idx];
+      buffer.length = serialize(board, type, camera, buffer.data.data(), buffer.data.size());
+      if (buffer.length == 0) {
+        return;
+      }
+      Frame frame{idx, board.getUuid(), type, camera};
+      for (Subscriber& subscriber : _subscribers) {
+        if (subscriber.connected) {
+          enqueue(subscriber, frame);
+        }
+      }
+    }
+
+    // A buffer no queue points to, the oldest queued frames are dropped until one is free
+    uint8_t acquire() {
+      while (true) {
+        for (uint8_t idx = 0; idx < _buffers.size(); idx++) {
+          if (_buffers[idx].refs == 0) {
+            return idx;
+          }
+        }
+        for (Subscriber& subscriber : _subscribers) {
+          if (subscriber.count > 0) {
+            pop(subscriber);
+            _droppedMessages++;
+          }
+        }
+      }
+    }
+
+    void enqueue(Subscriber& subscriber, const Frame& frame) {
+      // A part the snapshot has yet to send goes out with the snapshot, in its newer state
+      if (subscriber.joining) {
+        uint16_t slot = BoardRegistry::slot(_boards.find(frame.board));
+        if (slot > subscriber.next || (slot == subscriber.next && partOf(frame.type, frame.camera) >= subscriber.part)) {
+          return;
+        }
+      }
+      if (subscriber.count >= AUTODARTS_RELAY_QUEUE) {
+        uint8_t stale = subscriber.count;
+        for (uint8_t idx = 0; idx < subscriber.count && stale == subscriber.count; idx++) {
+          if (subscriber.at(idx).type == Message::Type::CAM_STATS) {
+            stale = idx;
+          }
+        }
+        for (uint8_t idx = 0; idx < subscriber.count && stale == subscriber.count; idx++) {
+          const Frame& queued = subscriber.at(idx);
+          if (queued.type == frame.type && queued.board == frame.board && queued.camera == frame.camera) {
+            stale = idx;
+          }
+        }
+        remove(subscriber, stale < subscriber.count ? stale : 0);
+        _droppedMessages++;
+      }
+      subscriber.at(subscriber.count) = frame;
+      subscriber.count++;
+      _buffers[frame.buffer].refs++;
+    }
+
+    void pop(Subscriber& subscriber) {
+      _buffers[subscriber.at(0).buffer].refs--;
+      subscriber.head = (subscriber.head + 1) % AUTODARTS_RELAY_QUEUE;
+      subscriber.count--;
+    }
+
+    // Closes the gap by moving the newer frames forward, the oldest one is only popped
+    void remove(Subscriber& subscriber, uint8_t idx) {
+      if (idx == 0) {
+        pop(subscriber);
+        return;
+      }
+      _buffers[subscriber.at(idx).buffer].refs--;
+      for (; idx + 1 < subscriber.count; idx++) {
+        subscriber.at(idx) = subscriber.at(idx + 1);
+      }
+      subscriber.count--;
+    }
+
+    void clear(Subscriber& subscriber) {
+      while (subscriber.count > 0) {
+        pop(subscriber);
+      }
+    }
+
+    // Sends the current state of the boards from where the subscriber left off, until the
+    // burst is used up or the socket is full. Returns the number of messages sent.
+    uint8_t snapshot(uint8_t num, Subscriber& subscriber) {
+      // The network task may be updating the boards
+      std::lock_guard<std::recursive_mutex> lock(_boardsMutex);
+      uint8_t sent = 0;
+      for (; subscriber.next < _boards.capacity(); subscriber.next++, subscriber.part = 0) {
+        const Board* board = _boards.get(_boards.handleAt(subscriber.next));
+        if (board == nullptr) {
+          continue;
+        }
+        std::lock_guard<std::recursive_mutex> boardLock(board->getMutex());
+        const CameraSystem& cameras = board->getDetector().getCameraSystem();
+        for (; subscriber.part < 2 + cameras.getNumCameras(); subscriber.part++) {
+          int8_t camera = static_cast<int8_t>(subscriber.part) - 2;
+          if (camera >= 0 && !cameras.hasCamera(camera)) {
+            continue;
+          }
+          Message::Type type = camera >= 0 ? Message::Type::CAM_STATS : subscriber.part == 0 ? Message::Type::STATE : Message::Type::CAM_STATE;
+          if (sent >= AUTODARTS_RELAY_BURST) {
+            return sent;
+          }
+          size_t length = serialize(*board, type, camera, _snapshot.data(), _snapshot.size());
+          if (length > 0 && !_server.sendTXT(num, _snapshot.data(), length)) {
+            return sent;
+          }
+          sent++;
+        }
+      }
+      subscriber.joining = false;
+      return sent;
+    }
+
+    const BoardRegistry& _boards;
+    std::recursive_mutex& _boardsMutex;
+    WebSocketsServer _server;
+    std::array<Subscriber, WEBSOCKETS_SERVER_CLIENT_MAX> _subscribers;
+    std::array<Buffer, AUTODARTS_RELAY_BUFFERS> _buffers;
+    std::array<char, AUTODARTS_RELAY_MESSAGE> _snapshot; // Snapshot parts are sent right away
+    uint32_t _droppedMessages = 0;
+  };
+
+} // autodarts
+
+#endif // AutodartsRelay_h_
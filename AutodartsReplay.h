@@ -0,0 +1,184 @@
+#ifndef AutodartsReplay_h_
+#define AutodartsReplay_h_
+
+#include <array>
+#include <mutex>
+
+#include <FS.h>
+
+#include "AutodartsBinary.h"
+#include "AutodartsDefines.h"
+#include "AutodartsJournal.h"
+#include "AutodartsRegistry.h"
+
+namespace autodarts {
+
+  // Feeds a journal back into the boards of a registry, either with the recorded
+  // timing or as fast as possible. Frames go through Board::receive(), so parsing
+  // and all events behave like a live session. The boards must exist with the
+  // recorded ids and should not be opened, records of unknown boards are skipped.
+  class JournalReplay {
+  public:
+    JournalReplay(BoardRegistry& boards) : _boards(boards) {}
+
+    JournalReplay(const JournalReplay&) = delete;
+    JournalReplay& operator=(const JournalReplay&) = delete;
+
+    bool begin(fs::FS& fs, const char* path, bool realtime = true) {
+      _file = fs.open(path, FILE_READ);
+      if (!_file) {
+        LOG_ERROR("Replay", F("Could not open ") << path);
+        return false;
+      }
+      uint8_t header[AUTODARTS_JOURNAL_HEADER];
+      if (_file.read(header, sizeof(header)) != sizeof(header) ||
+          memcmp(header, AUTODARTS_JOURNAL_MAGIC, sizeof(AUTODARTS_JOURNAL_MAGIC)) != 0 ||
+          header[3] != AUTODARTS_JOURNAL_VERSION) {
+        LOG_ERROR("Replay", F("Not a journal: ") << path);
+        _file.close();
+        return false;
+      }
+
+      _realtime = realtime;
+      _numFrames = 0;
+      _skippedRecords = 0;
+      _startedAt = micros();
+      _pending = next();
+      _offset = _pending ? millis() - _recordedAt : 0;
+      return true;
+    }
+
+    void end() {
+      _pending = false;
+      if (_file) {
+        _file.close();
+      }
+    }
+
+    bool isRunning() const {
+      return _pending;
+    }
+
+    // Feeds the records that are due, has to run on the task that updates the boards.
+    // Returns false once the journal is exhausted.
+    bool update() {
+      uint8_t count = 0;
+      while (_pending) {
+        if (_realtime) {
+          if (static_cast<int32_t>(millis() - (_recordedAt + _offset)) < 0) {
+            break;
+          }
+        }
+        else if (count++ >= AUTODARTS_JOURNAL_BURST) {
+          break;
+        }
+        apply();
+        _pending = next();
+      }
+      if (!_pending && _file) {
+        _elapsed = micros() - _startedAt;
+        _file.close();
+      }
+      return _pending;
+    }
+
+    // Replays the rest of the journal at once and returns the number of frames fed
+    uint32_t run() {
+      while (_pending) {
+        apply();
+        _pending = next();
+      }
+      update();
+      return _numFrames;
+    }
+
+    uint32_t getNumFrames() const {
+      return _numFrames;
+    }
+
+    // Records of unknown boards, larger than AUTODARTS_JOURNAL_MAX_FRAME or truncated
+    uint32_t getSkippedRecords() const {
+      return _skippedRecords;
+    }
+
+    // Microseconds from begin() until the journal was exhausted
+    uint32_t getElapsed() const {
+      return _pending ? micros() - _startedAt : _elapsed;
+    }
+
+  private:
+    // Reads the next record into the buffer, false at the end of the journal
+    bool next() {
+      while (_file.available() > 0) {
+        std::array<uint8_t, AUTODARTS_JOURNAL_RECORD> header;
+        if (_file.read(header.data(), header.size()) != header.size()) {
+          _skippedRecords++;
+          return false;
+        }
+        BinaryReader reader(header.data(), header.size());
+        _type       = static_cast<JournalRecord>(reader.readU8());
+        _recordedAt = reader.readU32();
+        reader.readBytes(_board.bytes.data(), _board.bytes.size());
+        _length     = reader.readU16();
+
+        if (_length >= _payload.size()) {
+          _file.seek(_length, fs::SeekCur);
+          _skippedRecords++;
+          continue;
+        }
+        if (_file.read(_payload.data(), _length) != _length) {
+          _skippedRecords++;
+          return false;
+        }
+        _payload[_length] = '\0';
+        return true;
+      }
+      return false;
+    }
+
+    void apply() {
+      Board* board = _boards.get(_boards.find(_board));
+      if (board == nullptr) {
+        _skippedRecords++;
+        return;
+      }
+      std::lock_guard<std::recursive_mutex> lock(board->getMutex());
+      switch (_type) {
+        case JournalRecord::TEXT:
+          board->receive(reinterpret_cast<char*>(_payload.data()), _length);
+          _numFrames++;
+          break;
+        case JournalRecord::CONNECTED:
+          board->connectionChanged(true);
+          break;
+        case JournalRecord::DISCONNECTED:
+          board->connectionChanged(false);
+          break;
+        default:
+          _skippedRecords++;
+          return;
+      }
+      // Like the websocket callback, every record is a sign of life
+      board->resetAlive();
+    }
+
+    BoardRegistry& _boards;
+    fs::File _file;
+    bool     _realtime = true;
+    bool     _pending = false;
+    uint32_t _offset = 0;
+    uint32_t _startedAt = 0;
+    uint32_t _elapsed = 0;
+    uint32_t _numFrames = 0;
+    uint32_t _skippedRecords = 0;
+
+    JournalRecord _type = JournalRecord::TEXT;
+    uint32_t      _recordedAt = 0;
+    Uuid          _board;
+    uint16_t      _length = 0;
+    std::array<uint8_t, AUTODARTS_JOURNAL_MAX_FRAME> _payload;
+  };
+
+} // autodarts
+
+#endif // AutodartsReplay_h_
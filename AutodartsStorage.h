@@ -0,0 +1,315 @@
+#ifndef AutodartsStorage_h_
+#define AutodartsStorage_h_
+
+#include <functional>
+
+#include <Arduino.h>
+#include <FS.h>
+
+#ifdef ESP32
+#include <Preferences.h>
+#endif
+
+#include "AutodartsDefines.h"
+
+namespace autodarts {
+
+  // Key/value backend used by Client to keep data across reboots
+  class Storage {
+  public:
+    typedef std::function<bool(Print& out)> Writer;
+    typedef std::function<bool(Stream& in)> Reader;
+
+    virtual ~Storage() = default;
+
+    virtual bool read(const char* key, String& value) = 0;
+    virtual bool write(const char* key, const String& value) = 0;
+    virtual bool remove(const char* key) = 0;
+
+    // Large values such as the board list are streamed, so they never have to fit into
+    // one String. The defaults go through one for backends that only store strings.
+    virtual bool writeStream(const char* key, const Writer& writer) {
+      StringStream value;
+      return writer(value) && write(key, value.get());
+    }
+
+    virtual bool readStream(const char* key, const Reader& reader) {
+      StringStream value;
+      return read(key, value.get()) && reader(value);
+    }
+
+  protected:
+    class StringStream : public Stream {
+    public:
+      String& get() {
+        return _value;
+      }
+
+      size_t write(uint8_t c) override {
+        return _value.concat(static_cast<char>(c)) ? 1 : 0;
+      }
+
+      int available() override {
+        return _value.length() - _position;
+      }
+
+      int read() override {
+        return _position < _value.length() ? _value[_position++] : -1;
+      }
+
+      int peek() override {
+        return _position < _value.length() ? _value[_position] : -1;
+      }
+
+    private:
+      String _value;
+      size_t _position = 0;
+    };
+  };
+
+  // Stores every value in its own file below a directory, e.g. of LittleFS
+  class FileStorage : public Storage {
+  public:
+    FileStorage(fs::FS& fs, const char* directory = "") : _fs(fs), _directory(directory) {}
+
+    bool read(const char* key, String& value) override {
+      return readStream(key, [&value](Stream& in) {
+        value = in.readString();
+        return !value.isEmpty();
+      });
+    }
+
+    bool write(const char* key, const String& value) override {
+      return writeStream(key, [&value](Print& out) {
+        return out.print(value) == value.length();
+      });
+    }
+
+    bool remove(const char* key) override {
+      return _fs.remove(path(key).c_str());
+    }
+
+    // Written to a new file that replaces the old one, which stays intact if writing fails
+    bool writeStream(const char* key, const Writer& writer) override {
+      String target = path(key);
+      String temporary = target + ".new";
+      File file = _fs.open(temporary, FILE_WRITE);
+      if (!file) {
+        return false;
+      }
+      bool ret = writer(file);
+      file.close();
+      if (!ret) {
+        _fs.remove(temporary.c_str());
+        return false;
+      }
+      _fs.remove(target.c_str());
+      return _fs.rename(temporary.c_str(), target.c_str());
+    }
+
+    bool readStream(const char* key, const Reader& reader) override {
+      File file = _fs.open(path(key), FILE_READ);
+      if (!file) {
+        return false;
+      }
+      bool ret = reader(file);
+      file.close();
+      return ret;
+    }
+
+  private:
+    String path(const char* key) const {
+      return String(_directory) + "/" + key;
+    }
+
+    fs::FS&     _fs;
+    const char* _directory;
+  };
+
+#ifdef ESP32
+  // Stores the values in a namespace of the ESP32 non-volatile storage
+  class PreferencesStorage : public Storage {
+  public:
+    PreferencesStorage(const char* name = "autodarts") : _name(name) {}
+
+    bool read(const char* key, String& value) override {
+      if (!_preferences.begin(_name, true)) {
+        return false;
+      }
+      value = _preferences.getString(key, "");
+      _preferences.end();
+      return !value.isEmpty();
+    }
+
+    bool write(const char* key, const String& value) override {
+      if (!_preferences.begin(_name, false)) {
+        return false;
+      }
+      bool ret = _preferences.putString(key, value) == value.length();
+      _preferences.end();
+      return ret;
+    }
+
+    bool remove(const char* key) override {
+      if (!_preferences.begin(_name, false)) {
+        return false;
+      }
+      bool ret = _preferences.remove(key);
+      removeChunks(key, 0);
+      _preferences.end();
+      return ret;
+    }
+
+    // Streamed values are kept as blobs of AUTODARTS_STORAGE_CHUNK bytes under "<key>.<n>",
+    // the key itself holds the number of chunks and is written last
+    bool writeStream(const char* key, const Writer& writer) override {
+      if (!_preferences.begin(_name, false)) {
+        return false;
+      }
+      ChunkWriter out(_preferences, key);
+      bool ret = writer(out) && out.finish();
+      uint16_t count = out.getNumChunks();
+      if (ret) {
+        ret = _preferences.putBytes(key, &count, sizeof(count)) == sizeof(count);
+      }
+      // Part of the old value has been overwritten, a failed write leaves nothing behind
+      if (!ret) {
+        _preferences.remove(key);
+        count = 0;
+      }
+      removeChunks(key, count);
+      _preferences.end();
+      return ret;
+    }
+
+    bool readStream(const char* key, const Reader& reader) override {
+      if (!_preferences.begin(_name, true)) {
+        return false;
+      }
+      uint16_t count = 0;
+      bool ret = _preferences.getBytes(key, &count, sizeof(count)) == sizeof(count) && count > 0;
+      if (ret) {
+        ChunkReader in(_preferences, key, count);
+        ret = reader(in);
+      }
+      _preferences.end();
+      return ret;
+    }
+
+  private:
+    static void chunkKey(char* buffer, const char* key, uint16_t idx) {
+      // NVS keys are limited to 15 characters
+      snprintf(buffer, 16, "%.9s.%u", key, idx);
+    }
+
+    // Removes the chunks left over from a longer value
+    void removeChunks(const char* key, uint16_t from) {
+      char name[16];
+      for (uint16_t idx = from;; idx++) {
+        chunkKey(name, key, idx);
+        if (!_preferences.isKey(name)) {
+          break;
+        }
+        _preferences.remove(name);
+      }
+    }
+
+    class ChunkWriter : public Print {
+    public:
+      ChunkWriter(Preferences& preferences, const char* key) : _preferences(preferences), _key(key) {}
+
+      size_t write(uint8_t c) override {
+        if (_failed) {
+          return 0;
+        }
+        _buffer[_length++] = c;
+        if (_length == sizeof(_buffer)) {
+          flushChunk();
+        }
+        return _failed ? 0 : 1;
+      }
+
+      bool finish() {
+        if (_length > 0) {
+          flushChunk();
+        }
+        return !_failed;
+      }
+
+      uint16_t getNumChunks() const {
+        return _numChunks;
+      }
+
+    private:
+      void flushChunk() {
+        char name[16];
+        chunkKey(name, _key, _numChunks);
+        _failed = _preferences.putBytes(name, _buffer, _length) != _length;
+        _numChunks++;
+        _length = 0;
+      }
+
+      Preferences& _preferences;
+      const char*  _key;
+      uint8_t      _buffer[AUTODARTS_STORAGE_CHUNK];
+      size_t       _length = 0;
+      uint16_t     _numChunks = 0;
+      bool         _failed = false;
+    };
+
+    class ChunkReader : public Stream {
+    public:
+      ChunkReader(Preferences& preferences, const char* key, uint16_t numChunks) : _preferences(preferences), _key(key), _numChunks(numChunks) {}
+
+      size_t write(uint8_t) override {
+        return 0;
+      }
+
+      int available() override {
+        return load() ? _length - _position : 0;
+      }
+
+      int read() override {
+        return load() ? _buffer[_position++] : -1;
+      }
+
+      int peek() override {
+        return load() ? _buffer[_position] : -1;
+      }
+
+    private:
+      // Makes sure there is an unread byte in the buffer
+      bool load() {
+        while (_position == _length) {
+          if (_next == _numChunks) {
+            return false;
+          }
+          char name[16];
+          chunkKey(name, _key, _next++);
+          _length = _preferences.getBytes(name, _buffer, sizeof(_buffer));
+          _position = 0;
+          if (_length == 0) {
+            _next = _numChunks;
+            return false;
+          }
+        }
+        return true;
+      }
+
+      Preferences& _preferences;
+      const char*  _key;
+      uint16_t     _numChunks;
+      uint16_t     _next = 0;
+      uint8_t      _buffer[AUTODARTS_STORAGE_CHUNK];
+      size_t       _length = 0;
+      size_t       _position = 0;
+    };
+
+    const char* _name;
+    Preferences _preferences;
+  };
+#endif
+
+} // autodarts
+
+#endif // AutodartsStorage_h_
@@ -0,0 +1,9 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/autodarts_cxx11.dir/compile_cxx11.cpp.o"
+  "CMakeFiles/autodarts_cxx11.dir/compile_cxx11.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/autodarts_cxx11.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
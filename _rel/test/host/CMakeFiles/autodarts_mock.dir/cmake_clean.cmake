@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/autodarts_mock.dir/mock/MockNetwork.cpp.o"
+  "CMakeFiles/autodarts_mock.dir/mock/MockNetwork.cpp.o.d"
+  "CMakeFiles/autodarts_mock.dir/mock/MockRuntime.cpp.o"
+  "CMakeFiles/autodarts_mock.dir/mock/MockRuntime.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/autodarts_mock.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_binary.dir/bench_binary.cpp.o"
+  "CMakeFiles/bench_binary.dir/bench_binary.cpp.o.d"
+  "bench_binary"
+  "bench_binary.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_binary.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
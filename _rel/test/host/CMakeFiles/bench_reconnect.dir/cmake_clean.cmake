@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_reconnect.dir/bench_reconnect.cpp.o"
+  "CMakeFiles/bench_reconnect.dir/bench_reconnect.cpp.o.d"
+  "bench_reconnect"
+  "bench_reconnect.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_reconnect.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
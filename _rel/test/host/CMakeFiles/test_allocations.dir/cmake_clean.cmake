@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_allocations.dir/test_allocations.cpp.o"
+  "CMakeFiles/test_allocations.dir/test_allocations.cpp.o.d"
+  "test_allocations"
+  "test_allocations.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_allocations.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
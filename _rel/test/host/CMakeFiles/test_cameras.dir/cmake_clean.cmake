@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_cameras.dir/test_cameras.cpp.o"
+  "CMakeFiles/test_cameras.dir/test_cameras.cpp.o.d"
+  "test_cameras"
+  "test_cameras.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_cameras.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_changes.dir/test_changes.cpp.o"
+  "CMakeFiles/test_changes.dir/test_changes.cpp.o.d"
+  "test_changes"
+  "test_changes.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_changes.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_defines.dir/test_defines.cpp.o"
+  "CMakeFiles/test_defines.dir/test_defines.cpp.o.d"
+  "test_defines"
+  "test_defines.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_defines.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
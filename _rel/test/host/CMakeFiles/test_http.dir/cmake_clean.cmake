@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_http.dir/test_http.cpp.o"
+  "CMakeFiles/test_http.dir/test_http.cpp.o.d"
+  "test_http"
+  "test_http.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_http.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_metrics.dir/test_metrics.cpp.o"
+  "CMakeFiles/test_metrics.dir/test_metrics.cpp.o.d"
+  "test_metrics"
+  "test_metrics.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_metrics.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_network_task.dir/test_network_task.cpp.o"
+  "CMakeFiles/test_network_task.dir/test_network_task.cpp.o.d"
+  "test_network_task"
+  "test_network_task.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_network_task.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
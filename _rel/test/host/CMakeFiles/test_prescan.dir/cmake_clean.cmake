@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_prescan.dir/test_prescan.cpp.o"
+  "CMakeFiles/test_prescan.dir/test_prescan.cpp.o.d"
+  "test_prescan"
+  "test_prescan.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_prescan.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
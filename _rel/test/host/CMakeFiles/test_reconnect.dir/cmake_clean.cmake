@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_reconnect.dir/test_reconnect.cpp.o"
+  "CMakeFiles/test_reconnect.dir/test_reconnect.cpp.o.d"
+  "test_reconnect"
+  "test_reconnect.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_reconnect.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
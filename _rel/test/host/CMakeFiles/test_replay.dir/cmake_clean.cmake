@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_replay.dir/test_replay.cpp.o"
+  "CMakeFiles/test_replay.dir/test_replay.cpp.o.d"
+  "test_replay"
+  "test_replay.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_replay.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,54 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/test/host
+# Build directory: /root/repo/_rel/test/host
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(test_allocations "/root/repo/_rel/test/host/test_allocations")
+set_tests_properties(test_allocations PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;46;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_binary "/root/repo/_rel/test/host/test_binary")
+set_tests_properties(test_binary PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;47;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_cameras "/root/repo/_rel/test/host/test_cameras")
+set_tests_properties(test_cameras PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;48;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_changes "/root/repo/_rel/test/host/test_changes")
+set_tests_properties(test_changes PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;49;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_cloud "/root/repo/_rel/test/host/test_cloud")
+set_tests_properties(test_cloud PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;50;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_defines "/root/repo/_rel/test/host/test_defines")
+set_tests_properties(test_defines PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;51;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_events "/root/repo/_rel/test/host/test_events")
+set_tests_properties(test_events PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;52;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_http "/root/repo/_rel/test/host/test_http")
+set_tests_properties(test_http PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;53;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_metrics "/root/repo/_rel/test/host/test_metrics")
+set_tests_properties(test_metrics PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;54;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_network_task "/root/repo/_rel/test/host/test_network_task")
+set_tests_properties(test_network_task PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;55;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_prescan "/root/repo/_rel/test/host/test_prescan")
+set_tests_properties(test_prescan PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;56;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_reconnect "/root/repo/_rel/test/host/test_reconnect")
+set_tests_properties(test_reconnect PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;57;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_relay "/root/repo/_rel/test/host/test_relay")
+set_tests_properties(test_relay PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;58;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_replay "/root/repo/_rel/test/host/test_replay")
+set_tests_properties(test_replay PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;59;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(test_storage "/root/repo/_rel/test/host/test_storage")
+set_tests_properties(test_storage PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;35;add_test;/root/repo/test/host/CMakeLists.txt;60;autodarts_test;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(bench_binary "/root/repo/_rel/test/host/bench_binary" "--quick")
+set_tests_properties(bench_binary PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;43;add_test;/root/repo/test/host/CMakeLists.txt;62;autodarts_benchmark;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(bench_dispatch "/root/repo/_rel/test/host/bench_dispatch" "--quick")
+set_tests_properties(bench_dispatch PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;43;add_test;/root/repo/test/host/CMakeLists.txt;63;autodarts_benchmark;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(bench_memory "/root/repo/_rel/test/host/bench_memory" "--quick")
+set_tests_properties(bench_memory PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;43;add_test;/root/repo/test/host/CMakeLists.txt;64;autodarts_benchmark;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(bench_metrics "/root/repo/_rel/test/host/bench_metrics" "--quick")
+set_tests_properties(bench_metrics PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;43;add_test;/root/repo/test/host/CMakeLists.txt;65;autodarts_benchmark;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(bench_parsers "/root/repo/_rel/test/host/bench_parsers" "--quick")
+set_tests_properties(bench_parsers PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;43;add_test;/root/repo/test/host/CMakeLists.txt;66;autodarts_benchmark;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(bench_reconnect "/root/repo/_rel/test/host/bench_reconnect" "--quick")
+set_tests_properties(bench_reconnect PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;43;add_test;/root/repo/test/host/CMakeLists.txt;67;autodarts_benchmark;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(bench_registry "/root/repo/_rel/test/host/bench_registry" "--quick")
+set_tests_properties(bench_registry PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;43;add_test;/root/repo/test/host/CMakeLists.txt;68;autodarts_benchmark;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(bench_replay "/root/repo/_rel/test/host/bench_replay" "--quick")
+set_tests_properties(bench_replay PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;43;add_test;/root/repo/test/host/CMakeLists.txt;69;autodarts_benchmark;/root/repo/test/host/CMakeLists.txt;0;")
+add_test(bench_topics "/root/repo/_rel/test/host/bench_topics" "--quick")
+set_tests_properties(bench_topics PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/host/CMakeLists.txt;43;add_test;/root/repo/test/host/CMakeLists.txt;70;autodarts_benchmark;/root/repo/test/host/CMakeLists.txt;0;")
@@ -0,0 +1,152 @@
+// Size and time of the binary snapshot format against the JSON messages of the board
+// manager that carry the same state. A full snapshot holds three darts and three cameras,
+// the JSON form are the state, cam_state and three cam_stats messages. A throw delta holds
+// the detection state and the darts, the JSON form is one state message. Encoding writes
+// into a buffer on the stack, decoding applies the state to a detector.
+
+#include <AutodartsClient.h>
+#include <Bench.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+
+  struct Result {
+    size_t   bytes;
+    double   encodeNanos;
+    double   decodeNanos;
+    uint64_t allocations;
+  };
+
+  template <typename TFunction>
+  double measure(uint32_t rounds, TFunction function) {
+    uint64_t start = bench::nowNanos();
+    for (uint32_t round = 0; round < rounds; round++) {
+      function();
+    }
+    return static_cast<double>(bench::nowNanos() - start) / rounds;
+  }
+
+  // Serializes one message of the board into the buffer and returns its length
+  template <typename TWrite>
+  size_t writeJson(char* buffer, size_t size, TWrite write) {
+    StaticJsonDocument<1024> json;
+    JsonObject root = json.to<JsonObject>();
+    write(root);
+    return serializeJson(json, buffer, size);
+  }
+
+  typedef std::array<size_t, 2 + AUTODARTS_MAX_CAMERAS> Lengths;
+
+  // The messages of the sections in changes, one after the other in buffer. Returns the
+  // number of messages, their lengths are stored in lengths.
+  size_t encodeJson(const Detector& detector, ChangeMask changes, char* buffer, size_t size, Lengths& lengths) {
+    size_t count = 0;
+    size_t offset = 0;
+    const CameraSystem& cameras = detector.getCameraSystem();
+    if (changes & (Change::DETECTION_STATE | Change::DETECTION_EVENT | Change::THROWS)) {
+      lengths[count] = writeJson(buffer + offset, size - offset, [&detector](JsonObject& root) { detector.toJson(root); });
+      offset += lengths[count++] + 1;
+    }
+    if (changes & Change::CAMERA_STATE) {
+      lengths[count] = writeJson(buffer + offset, size - offset, [&cameras](JsonObject& root) { cameras.toJson(root); });
+      offset += lengths[count++] + 1;
+    }
+    if (changes & Change::CAMERA_STATS) {
+      for (uint8_t idx = 0; idx < cameras.getNumCameras(); idx++) {
+        if (cameras.hasCamera(idx)) {
+          lengths[count] = writeJson(buffer + offset, size - offset, [&cameras, idx](JsonObject& root) { cameras[idx].toJson(root); });
+          offset += lengths[count++] + 1;
+        }
+      }
+    }
+    return count;
+  }
+
+  Result measureJson(const Board& board, ChangeMask changes, uint32_t rounds) {
+    char buffer[2048];
+    Lengths lengths;
+    size_t count = encodeJson(board.getDetector(), changes, buffer, sizeof(buffer), lengths);
+    Result result;
+    result.bytes = 0;
+    for (size_t idx = 0; idx < count; idx++) {
+      result.bytes += lengths[idx];
+    }
+
+    bench::AllocationCounter counter;
+    result.encodeNanos = measure(rounds, [&]() { encodeJson(board.getDetector(), changes, buffer, sizeof(buffer), lengths); });
+    Detector detector;
+    DynamicJsonDocument json(2048);
+    result.decodeNanos = measure(rounds, [&]() {
+      size_t offset = 0;
+      for (size_t idx = 0; idx < count; idx++) {
+        deserializeJson(json, static_cast<const char*>(buffer + offset), lengths[idx]);
+        detector.fromJson(json.as<JsonObjectConst>());
+        offset += lengths[idx] + 1;
+      }
+    });
+    result.allocations = counter.count() / rounds;
+    return result;
+  }
+
+  Result measureBinary(const Board& board, ChangeMask changes, uint32_t rounds) {
+    uint8_t buffer[AUTODARTS_BINARY_MAX_SIZE];
+    Result result;
+    result.bytes = board.toBinary(buffer, sizeof(buffer), changes);
+
+    bench::AllocationCounter counter;
+    result.encodeNanos = measure(rounds, [&]() { board.toBinary(buffer, sizeof(buffer), changes); });
+    Detector detector;
+    result.decodeNanos = measure(rounds, [&]() {
+      BoardSnapshot snapshot;
+      snapshot.decode(buffer, result.bytes);
+      snapshot.applyTo(detector);
+    });
+    result.allocations = counter.count() / rounds;
+    return result;
+  }
+
+  void row(const char* name, const char* format, const Result& result) {
+    printf("%-14s %-7s %8zu %12.1f %12.1f %12llu\n", name, format, result.bytes, result.encodeNanos, result.decodeNanos,
+           static_cast<unsigned long long>(result.allocations));
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint32_t rounds = bench::isQuick(argc, argv) ? 10 : 200000;
+
+  Board board("Board", BOARD_ID, "0.22.0", "10.0.0.1");
+  auto receive = [&board](const std::string& json) {
+    std::vector<char> payload(json.begin(), json.end());
+    payload.push_back('\0');
+    board.receive(payload.data(), json.length());
+  };
+  receive(session::camState(true, true));
+  for (int id = 0; id < 3; id++) {
+    receive(session::camStats(id, 30));
+  }
+  receive(session::state("Throw", "Throw detected", {{20, 3, 0.125f, -0.5f}, {19, 1, 0.25f, 0.375f}, {25, 2, 0.0f, 0.0f}}));
+
+  const ChangeMask delta = Change::DETECTION_STATE | Change::DETECTION_EVENT | Change::THROWS;
+  Result fullJson = measureJson(board, Change::ALL, rounds);
+  Result fullBinary = measureBinary(board, Change::ALL, rounds);
+  Result deltaJson = measureJson(board, delta, rounds);
+  Result deltaBinary = measureBinary(board, delta, rounds);
+
+  bench::header("Board state as JSON messages and binary snapshot");
+  printf("%-14s %-7s %8s %12s %12s %12s\n", "content", "format", "bytes", "encode ns", "decode ns", "allocations");
+  row("full snapshot", "json", fullJson);
+  row("full snapshot", "binary", fullBinary);
+  row("throw delta", "json", deltaJson);
+  row("throw delta", "binary", deltaBinary);
+
+  if (fullBinary.bytes != 76 || deltaBinary.bytes != 56 || fullBinary.allocations != 0 || deltaBinary.allocations != 0) {
+    fprintf(stderr, "Unexpected binary size or allocations\n");
+    return 1;
+  }
+  return 0;
+}
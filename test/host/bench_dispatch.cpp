@@ -0,0 +1,189 @@
+// Compares the message type dispatch of the board manager frames before and after the
+// message type parser: the chained root["type"] string compares of Detector and
+// CameraSystem against Message::fromString() and one switch. Only the dispatch is timed,
+// the handlers just count. The message mix is the one of a synthetic session, see Session.h.
+//
+// Then the events of a board are dispatched to a client with 0 to AUTODARTS_MAX_LISTENERS
+// listeners on every topic. The detector raises them from decoded darts and states, so no
+// JSON is parsed and the time added per listener call is the dispatch cost of one listener:
+// the board listener, the topic with its mask check and callback histogram, and the call.
+
+#include <map>
+#include <memory>
+
+#include <AutodartsClient.h>
+#include <ArduinoJson.h>
+#include <Bench.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  struct Counts {
+    uint32_t state = 0;
+    uint32_t camState = 0;
+    uint32_t camStats = 0;
+    uint32_t unknown = 0;
+  };
+
+  // Detector::fromJson and CameraSystem::fromJson before the change, one compare per type
+  namespace legacy {
+
+    void cameraSystemFromJson(const JsonObjectConst& root, Counts& counts) {
+      if (root["type"] == "cam_state") {
+        counts.camState++;
+      }
+      else if (root["type"] == "cam_stats") {
+        counts.camStats++;
+      }
+      else {
+        counts.unknown++;
+      }
+    }
+
+    void detectorFromJson(const JsonObjectConst& root, Counts& counts) {
+      if (root["type"] == "state") {
+        counts.state++;
+      }
+      else {
+        cameraSystemFromJson(root, counts);
+      }
+    }
+
+  } // legacy
+
+  void dispatch(const JsonObjectConst& root, Counts& counts) {
+    switch (Message::fromString(root["type"])) {
+      case Message::Type::STATE:     counts.state++;    break;
+      case Message::Type::CAM_STATE: counts.camState++; break;
+      case Message::Type::CAM_STATS: counts.camStats++; break;
+      default:                       counts.unknown++;  break;
+    }
+  }
+
+  template <typename TDispatch>
+  double measure(const std::vector<std::unique_ptr<DynamicJsonDocument>>& documents, uint32_t rounds, Counts& counts, TDispatch dispatch) {
+    uint64_t start = bench::nowNanos();
+    for (uint32_t round = 0; round < rounds; round++) {
+      for (const std::unique_ptr<DynamicJsonDocument>& document : documents) {
+        dispatch(document->as<JsonObjectConst>(), counts);
+      }
+    }
+    return static_cast<double>(bench::nowNanos() - start) / (static_cast<double>(rounds) * documents.size());
+  }
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+
+  // Every listener counts its calls
+  void subscribeAll(Client& client, uint64_t& calls) {
+    client.onData([&calls](const Board&) { calls++; });
+    client.onConnectionChange([&calls](const Board&) { calls++; });
+    client.onCameraStats([&calls](int8_t, int8_t, int16_t, int16_t) { calls++; });
+    client.onCameraSystemState([&calls](State, State) { calls++; });
+    client.onDetectionState([&calls](State, State, int16_t) { calls++; });
+    client.onDetectionEvent([&calls](Status::Code, Event::Code) { calls++; });
+    client.onThrow([&calls](const Board&, uint8_t, const Throw&) { calls++; });
+  }
+
+  // One round raises three darts, a detection event and a detection state change
+  double dispatchAll(Detector& detector, uint32_t rounds) {
+    const Throw darts[3] = {Throw(20, 3, 0.1f, 0.2f), Throw(5, 1, -0.3f, 0.4f), Throw(1, 2, 0.5f, -0.6f)};
+    uint64_t start = bench::nowNanos();
+    for (uint32_t round = 0; round < rounds; round++) {
+      bool running = round % 2 == 0;
+      detector.raiseState(detector.applyState(true, running, 3, Status::Code::THROW, running ? Event::Code::THROW_DETECTED : Event::Code::TAKEOUT_STARTED));
+      for (uint8_t count = 1; count <= 3; count++) {
+        detector.applyThrows(darts, count);
+      }
+      detector.applyThrows(darts, 0);
+    }
+    return static_cast<double>(bench::nowNanos() - start) / rounds;
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool quick = bench::isQuick(argc, argv);
+  uint32_t rounds = quick ? 10 : 20000;
+
+  session::Generator generator(3);
+  std::vector<session::Frame> frames = generator.generate(20);
+  // A message type that is not handled, as added by newer board managers
+  frames.push_back(session::Frame{0, "{\"type\":\"motion_state\",\"data\":{\"motion\":false}}"});
+
+  std::vector<std::unique_ptr<DynamicJsonDocument>> documents;
+  std::map<std::string, uint32_t> mix;
+  for (const session::Frame& frame : frames) {
+    documents.emplace_back(new DynamicJsonDocument(4096));
+    deserializeJson(*documents.back(), frame.json);
+    mix[(*documents.back())["type"].as<const char*>()]++;
+  }
+
+  Counts legacyCounts;
+  Counts counts;
+  double legacyNanos = measure(documents, rounds, legacyCounts, legacy::detectorFromJson);
+  double nanos = measure(documents, rounds, counts, dispatch);
+
+  bench::header("Message type dispatch");
+  printf("mix:");
+  for (auto& entry : mix) {
+    printf(" %s %u", entry.first.c_str(), entry.second);
+  }
+  printf("\n%-28s %10s\n", "dispatch", "ns/frame");
+  printf("%-28s %10.1f\n", "root[\"type\"] == chain", legacyNanos);
+  printf("%-28s %10.1f\n", "Message::fromString + switch", nanos);
+  printf("speedup: %.2fx\n", legacyNanos / nanos);
+
+  bool same = legacyCounts.state == counts.state && legacyCounts.camState == counts.camState &&
+              legacyCounts.camStats == counts.camStats && legacyCounts.unknown == counts.unknown;
+  if (!same) {
+    fprintf(stderr, "Dispatch results differ\n");
+    return 1;
+  }
+
+  uint32_t dispatchRounds = quick ? 10 : 100000;
+  uint32_t runs = quick ? 1 : 15;
+  bench::header("Dispatch of board events by listeners per topic");
+  printf("%-10s %12s %14s %14s\n", "listeners", "ns/round", "calls/round", "ns/call");
+  const uint8_t numCounts = AUTODARTS_MAX_LISTENERS + 1;
+  std::vector<std::unique_ptr<Client>> clients;
+  std::vector<uint64_t> calls(numCounts, 0);
+  std::vector<Detector*> detectors;
+  for (uint8_t count = 0; count < numCounts; count++) {
+    clients.emplace_back(new Client());
+    for (uint8_t idx = 0; idx < count; idx++) {
+      subscribeAll(*clients.back(), calls[count]);
+    }
+    detectors.push_back(&clients.back()->getBoard(clients.back()->addBoard("Board", BOARD_ID, "0.22.0", "10.0.0.1"))->getDetector());
+  }
+  // The listener counts take turns and the fastest run of each is kept, so that the noise
+  // and the drift of the host stay out of the differences
+  std::vector<double> dispatchNanos(numCounts, 0);
+  for (uint32_t run = 0; run < runs; run++) {
+    for (uint8_t count = 0; count < numCounts; count++) {
+      double nanos = dispatchAll(*detectors[count], dispatchRounds);
+      dispatchNanos[count] = run == 0 ? nanos : std::min(dispatchNanos[count], nanos);
+    }
+  }
+  std::vector<double> callsPerRound;
+  for (uint8_t count = 0; count < numCounts; count++) {
+    callsPerRound.push_back(static_cast<double>(calls[count]) / (static_cast<double>(runs) * dispatchRounds));
+    if (count == 0) {
+      printf("%-10u %12.1f %14.2f %14s\n", count, dispatchNanos[count], callsPerRound[count], "-");
+    }
+    else {
+      printf("%-10u %12.1f %14.2f %14.1f\n", count, dispatchNanos[count], callsPerRound[count],
+             (dispatchNanos[count] - dispatchNanos[0]) / callsPerRound[count]);
+    }
+    if (count > 0 && calls[count] == 0) {
+      fprintf(stderr, "No listener was called\n");
+      return 1;
+    }
+  }
+  // The first listener of a publish also reads the clock twice and records the histogram
+  uint8_t last = AUTODARTS_MAX_LISTENERS;
+  printf("first listener:   %6.1f ns/call\n", (dispatchNanos[1] - dispatchNanos[0]) / callsPerRound[1]);
+  printf("further listener: %6.1f ns/call\n", (dispatchNanos[last] - dispatchNanos[1]) / (callsPerRound[last] - callsPerRound[1]));
+  return 0;
+}
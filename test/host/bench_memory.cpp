@@ -0,0 +1,89 @@
+// Memory held per board: sizeof the board and its parts, and the heap used per board when
+// 500 boards are added or restored. Pointers and std::atomic are twice as wide on the host
+// as on the ESP32, so the host figures are an upper bound of the ones on the device. The
+// websocket client is the host stand-in; like the links2004 client it only allocates once
+// a connection is made, which is not counted here.
+
+#include <AutodartsClient.h>
+#include <Bench.h>
+
+using namespace autodarts;
+
+namespace {
+
+  // Free heap of an ESP32 without PSRAM once Wi-Fi is up and one TLS session to
+  // autodarts.io is open, assumed from ESP.getFreeHeap() of the examples
+  const size_t ESP32_FREE_HEAP = 160 * 1024;
+  // Heap left for the application and the connections to the boards that are open
+  const size_t ESP32_RESERVE = 64 * 1024;
+  // CONFIG_LWIP_MAX_SOCKETS of the Arduino core, the two HTTP sessions and the cloud take three
+  const uint32_t ESP32_SOCKETS = 10 - 3;
+
+  String boardId(uint32_t idx) {
+    char id[40];
+    snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+    return id;
+  }
+
+  void addBoards(Client& client, uint32_t count) {
+    for (uint32_t idx = 0; idx < count; idx++) {
+      String address = "10.1." + String(idx / 250) + "." + String(idx % 250 + 1);
+      client.addBoard("Board " + String(idx), boardId(idx), "0.22.0", address);
+    }
+  }
+
+  void printSize(const char* name, size_t size) {
+    printf("%-28s %6zu\n", name, size);
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool quick = bench::isQuick(argc, argv);
+  uint32_t count = quick ? 50 : 500;
+
+  bench::header("Size of a board in bytes");
+  printSize("Board", sizeof(Board));
+  printSize("  Detector", sizeof(Detector));
+  printSize("    CameraSystem", sizeof(CameraSystem));
+  printSize("      Camera", sizeof(Camera));
+  printSize("  BoardMetrics", sizeof(BoardMetrics));
+  printSize("  WebSocketsClient (host)", sizeof(WebSocketsClient));
+
+  Preferences::reset();
+  Preferences::setCapacity(1024 * 1024);
+  PreferencesStorage storage;
+
+  int64_t before = mock::heapStats().liveBytes;
+  std::unique_ptr<Client> client(new Client());
+  int64_t empty = mock::heapStats().liveBytes - before;
+  addBoards(*client, count);
+  int64_t added = mock::heapStats().liveBytes - before - empty;
+  client->setStorage(&storage);
+  client->persist();
+  client.reset();
+
+  before = mock::heapStats().liveBytes;
+  client.reset(new Client());
+  client->setStorage(&storage);
+  client->restore(false);
+  int64_t restored = mock::heapStats().liveBytes - before - empty;
+
+  double perBoard = static_cast<double>(restored) / count;
+  size_t fit = static_cast<size_t>((ESP32_FREE_HEAP - ESP32_RESERVE) / perBoard);
+  bench::header("Heap used by the boards");
+  printf("%-28s %8lld bytes\n", "client without boards", static_cast<long long>(empty));
+  printf("%-28s %8lld bytes, %6.0f per board\n", (std::to_string(count) + " boards added").c_str(),
+         static_cast<long long>(added), static_cast<double>(added) / count);
+  printf("%-28s %8lld bytes, %6.0f per board\n", (std::to_string(count) + " boards restored").c_str(),
+         static_cast<long long>(restored), perBoard);
+  printf("boards in %zu KB of %zu KB free heap: %zu, at most %u open at a time (lwIP sockets)\n",
+         (ESP32_FREE_HEAP - ESP32_RESERVE) / 1024, ESP32_FREE_HEAP / 1024, fit, ESP32_SOCKETS);
+
+  // Closed boards must stay small, otherwise the list of a venue does not fit
+  if (perBoard > 1536) {
+    fprintf(stderr, "A board uses %.0f bytes of heap\n", perBoard);
+    return 1;
+  }
+  return 0;
+}
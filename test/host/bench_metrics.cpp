@@ -0,0 +1,118 @@
+// Cost of recording a duration in a MetricHistogram, with its 32 bit sum against a 64 bit
+// sum, from one thread and from four threads that record into the same histogram. The host
+// has lock free 64 bit atomics, the ESP32 does not and would take a lock for the wider sum.
+// A timed publish adds two reads of the clock to the record, so both are shown next to the
+// publish of a throw event with and without a histogram.
+
+#include <thread>
+
+#include <AutodartsEvents.h>
+#include <AutodartsBoard.h>
+#include <Bench.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+  const uint8_t THREADS = 4;
+
+  typedef Topic<AUTODARTS_MAX_LISTENERS, const Board&, uint8_t, const Throw&> ThrowTopic;
+
+  // MetricHistogram with a sum that does not wrap
+  class Histogram64 {
+  public:
+    static const uint8_t NUM_BUCKETS = LatencyHistogram::NUM_BUCKETS;
+
+    void record(uint32_t duration) {
+      uint8_t idx = duration == 0 ? 0 : 32 - __builtin_clz(duration);
+      _buckets[idx < NUM_BUCKETS ? idx : NUM_BUCKETS - 1].fetch_add(1, std::memory_order_relaxed);
+      _count.fetch_add(1, std::memory_order_relaxed);
+      _sum.fetch_add(duration, std::memory_order_relaxed);
+    }
+
+    uint32_t getCount() const {
+      return _count.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::array<std::atomic<uint32_t>, NUM_BUCKETS> _buckets{};
+    std::atomic<uint32_t> _count{0};
+    std::atomic<uint64_t> _sum{0};
+  };
+
+  template <typename TFunction>
+  double measure(uint32_t rounds, TFunction function) {
+    uint64_t start = bench::nowNanos();
+    for (uint32_t round = 0; round < rounds; round++) {
+      function(round);
+    }
+    return static_cast<double>(bench::nowNanos() - start) / rounds;
+  }
+
+  // Wall time per round while every thread records one duration per round
+  template <typename THistogram>
+  double measureThreads(uint32_t rounds, THistogram& histogram) {
+    uint64_t start = bench::nowNanos();
+    std::vector<std::thread> threads;
+    for (uint8_t thread = 0; thread < THREADS; thread++) {
+      threads.emplace_back([rounds, &histogram]() {
+        for (uint32_t round = 0; round < rounds; round++) {
+          histogram.record(round & 0xFFF);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    return static_cast<double>(bench::nowNanos() - start) / rounds;
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint32_t rounds = bench::isQuick(argc, argv) ? 1000 : 5000000;
+
+  MetricHistogram single32;
+  Histogram64 single64;
+  double record32 = measure(rounds, [&single32](uint32_t round) { single32.record(round & 0xFFF); });
+  double record64 = measure(rounds, [&single64](uint32_t round) { single64.record(round & 0xFFF); });
+  MetricHistogram shared32;
+  Histogram64 shared64;
+  double threads32 = measureThreads(rounds, shared32);
+  double threads64 = measureThreads(rounds, shared64);
+
+  volatile uint32_t elapsed = 0;
+  double clock = measure(rounds, [&elapsed](uint32_t) {
+    uint32_t start = micros();
+    elapsed = micros() - start;
+  });
+
+  Board board("Board", BOARD_ID, "0.22.0", "10.0.0.1");
+  Throw dart;
+  uint64_t calls = 0;
+  MetricHistogram histogram;
+  ThrowTopic topic(1);
+  ThrowTopic timed(2, &histogram);
+  topic.subscribe([&calls](const Board&, uint8_t, const Throw&) { calls++; });
+  timed.subscribe([&calls](const Board&, uint8_t, const Throw&) { calls++; });
+  bench::AllocationCounter counter;
+  double publish = measure(rounds, [&](uint32_t round) { topic.publish(board, static_cast<uint8_t>(round % 3), dart); });
+  double timedPublish = measure(rounds, [&](uint32_t round) { timed.publish(board, static_cast<uint8_t>(round % 3), dart); });
+  uint64_t allocations = counter.count();
+
+  bench::header("Recording a duration in a histogram");
+  printf("%-28s %12s %12s\n", "operation", "32 bit sum", "64 bit sum");
+  printf("%-28s %12.1f %12.1f\n", "record, 1 thread", record32, record64);
+  printf("%-28s %12.1f %12.1f\n", "record, 4 threads", threads32, threads64);
+  printf("%-28s %12.1f\n", "micros() twice", clock);
+  printf("%-28s %12.1f\n", "publish, 1 listener", publish);
+  printf("%-28s %12.1f\n", "timed publish, 1 listener", timedPublish);
+
+  if (single32.getCount() != rounds || single64.getCount() != rounds || shared32.getCount() != rounds * THREADS ||
+      shared64.getCount() != rounds * THREADS || histogram.getCount() != rounds || calls != 2ull * rounds || allocations != 0) {
+    fprintf(stderr, "Unexpected samples, calls or allocations\n");
+    return 1;
+  }
+  return 0;
+}
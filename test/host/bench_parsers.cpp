@@ -0,0 +1,94 @@
+// Time per lookup of the Status and Event parsers, compared with the String compares
+// against F() literals they replaced. Every name is looked up on its own, unknown values
+// are the worst case of the old parsers as they were compared with every name.
+
+#include <AutodartsDefines.h>
+#include <Bench.h>
+
+using namespace autodarts;
+
+namespace {
+
+  // Status::fromString and Event::fromString before the change
+  namespace legacy {
+
+    Status::Code statusFromString(const String& value) {
+      if      (value == F("Stopped"))             return Status::Code::STOPPED;
+      else if (value == F("Starting"))            return Status::Code::STARTING;
+      else if (value == F("Throw"))               return Status::Code::THROW;
+      else if (value == F("Takeout"))             return Status::Code::TAKEOUT;
+      else if (value == F("Takeout in progress")) return Status::Code::TAKEOUT_PROGRESS;
+      return Status::Code::UNKNOWN;
+    }
+
+    Event::Code eventFromString(const String& value) {
+      if      (value == F("Stopped"))             return Event::Code::STOPPED;
+      else if (value == F("Stopping"))            return Event::Code::STOPPING;
+      else if (value == F("Starting"))            return Event::Code::STARTING;
+      else if (value == F("Started"))             return Event::Code::STARTED;
+      else if (value == F("Throw detected"))      return Event::Code::THROW_DETECTED;
+      else if (value == F("Takeout started"))     return Event::Code::TAKEOUT_STARTED;
+      else if (value == F("Takeout finished"))    return Event::Code::TAKEOUT_FINISHED;
+      else if (value == F("Manual reset"))        return Event::Code::RESET;
+      return Event::Code::UNKNOWN;
+    }
+
+  } // legacy
+
+  struct Result {
+    double   nanos;
+    uint64_t allocations;
+  };
+
+  // The old parsers took a String, the JSON value was converted once per lookup
+  template <typename TParse>
+  Result measure(const char* value, uint32_t rounds, TParse parse) {
+    volatile int sink = 0;
+    bench::AllocationCounter counter;
+    uint64_t start = bench::nowNanos();
+    for (uint32_t round = 0; round < rounds; round++) {
+      sink = sink + static_cast<int>(parse(value));
+    }
+    Result result;
+    result.nanos = static_cast<double>(bench::nowNanos() - start) / rounds;
+    result.allocations = counter.count() / rounds;
+    return result;
+  }
+
+  void row(const char* parser, const char* value, const Result& legacy, const Result& result) {
+    printf("%-7s %-22s %10.1f %8llu %10.1f %8llu\n", parser, value, legacy.nanos,
+           static_cast<unsigned long long>(legacy.allocations), result.nanos,
+           static_cast<unsigned long long>(result.allocations));
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint32_t rounds = bench::isQuick(argc, argv) ? 10 : 1000000;
+
+  const char* statuses[] = {"Stopped", "Starting", "Throw", "Takeout", "Takeout in progress", "Calibrating"};
+  const char* events[] = {"Stopped", "Stopping", "Starting", "Started", "Throw detected",
+                          "Takeout started", "Takeout finished", "Manual reset", "Calibration started"};
+
+  bench::header("Status and Event parsing per lookup");
+  printf("%-7s %-22s %10s %8s %10s %8s\n", "parser", "value", "old ns", "allocs", "new ns", "allocs");
+  bool same = true;
+  for (const char* value : statuses) {
+    Result legacy = measure(value, rounds, [](const char* value) { return legacy::statusFromString(String(value)); });
+    Result result = measure(value, rounds, [](const char* value) { return Status::fromString(value); });
+    row("Status", value, legacy, result);
+    same &= legacy::statusFromString(String(value)) == Status::fromString(value);
+  }
+  for (const char* value : events) {
+    Result legacy = measure(value, rounds, [](const char* value) { return legacy::eventFromString(String(value)); });
+    Result result = measure(value, rounds, [](const char* value) { return Event::fromString(value); });
+    row("Event", value, legacy, result);
+    same &= legacy::eventFromString(String(value)) == Event::fromString(value);
+  }
+
+  if (!same) {
+    fprintf(stderr, "Parse results differ\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,222 @@
+// Thundering herd of the controllers of a venue, simulated on the manual clock against fake
+// board managers. Every controller keeps a connection to every board. The blip drops all
+// connections and keeps the board managers down for a while, the cold start restarts all
+// controllers at once. The power blip restarts the controllers while the board managers are
+// still down, every controller restores its stored list at the same boot. "lockstep" is the behavior before the reconnect scheduler: every
+// board opened at once and retried every AUTODARTS_CONNECT_TIMEOUT. Attempts are the
+// handshakes and refused connections the board managers saw, the peak is the most attempts
+// one board manager saw within 100 ms.
+
+#include <memory>
+
+#include <AutodartsClient.h>
+#include <Bench.h>
+#include <FakeWebSocketServer.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const uint32_t STEP      = 10;    // ms between two updateBoards() of every controller
+  const uint32_t WINDOW    = 100;   // ms of the peak
+  const uint32_t HANDSHAKE = 40;    // ms a board manager needs to accept a connection
+  const uint32_t OUTAGE    = 15000; // ms the board managers are down after the blip
+  const uint32_t LIMIT     = 120000;
+
+  struct Result {
+    uint32_t attempts = 0;
+    uint32_t peak = 0;
+    uint32_t openAfter = 0; // ms from the board managers coming back until all are connected
+  };
+
+  String boardId(uint32_t idx) {
+    char id[40];
+    snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+    return id;
+  }
+
+  String boardIp(uint32_t idx) {
+    return "10.2.0." + String(idx + 1);
+  }
+
+  ReconnectScheduler::Policy lockstep() {
+    ReconnectScheduler::Policy policy;
+    policy.minDelay = 0;
+    policy.maxDelay = 0;
+    policy.maxConnecting = 255;
+    return policy;
+  }
+
+  class Venue {
+  public:
+    Venue(uint32_t controllers, uint32_t boards) : _controllers(controllers), _numBoards(boards) {
+      for (uint32_t idx = 0; idx < boards; idx++) {
+        _servers.emplace_back(new mock::FakeWebSocketServer(boardIp(idx), AUTODARTS_BOARD_PORT));
+        _servers.back()->setHandshakeDelay(HANDSHAKE);
+      }
+      _last.resize(boards, 0);
+    }
+
+    // Starts the controllers, with the boards restored from the stored list or added one by one
+    void start(const ReconnectScheduler::Policy& policy, PreferencesStorage* storage) {
+      _clients.clear();
+      for (uint32_t controller = 0; controller < _controllers; controller++) {
+        _clients.emplace_back(new Client());
+        Client& client = *_clients.back();
+        client.setReconnectPolicy(policy);
+        if (storage != nullptr) {
+          client.setStorage(storage);
+          client.restore(true);
+          continue;
+        }
+        for (uint32_t idx = 0; idx < _numBoards; idx++) {
+          client.addBoard("Board " + String(idx), boardId(idx), "0.22.0", boardIp(idx));
+        }
+        client.openBoards();
+      }
+    }
+
+    void setAccepting(bool accepting) {
+      for (auto& server : _servers) {
+        server->setAccepting(accepting);
+        if (!accepting) {
+          server->dropAll();
+        }
+      }
+    }
+
+    // Runs the controllers for the given time, or until all are connected
+    uint32_t run(uint32_t ms, Result& result, bool untilOpen) {
+      uint32_t elapsed = 0;
+      while (elapsed < ms) {
+        for (uint32_t step = 0; step < WINDOW; step += STEP) {
+          for (auto& client : _clients) {
+            client->updateBoards();
+          }
+          mock::advanceClock(STEP);
+        }
+        elapsed += WINDOW;
+        // Board managers send cam_stats every second, which keeps the connections alive
+        if (elapsed % 1000 == 0) {
+          for (auto& server : _servers) {
+            server->push(session::camStats(0, 30));
+          }
+        }
+        for (uint32_t idx = 0; idx < _servers.size(); idx++) {
+          uint32_t attempts = _servers[idx]->getNumHandshakes() + _servers[idx]->getNumRefused();
+          result.attempts += attempts - _last[idx];
+          result.peak = std::max(result.peak, attempts - _last[idx]);
+          _last[idx] = attempts;
+        }
+        if (untilOpen && isOpen()) {
+          break;
+        }
+      }
+      return elapsed;
+    }
+
+    bool isOpen() const {
+      for (const auto& client : _clients) {
+        for (uint32_t idx = 0; idx < _numBoards; idx++) {
+          const Board* board = client->getBoard(client->findBoard(boardId(idx).c_str()));
+          if (board == nullptr || !board->isOpen()) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+  private:
+    uint32_t _controllers;
+    uint32_t _numBoards;
+    std::vector<std::unique_ptr<mock::FakeWebSocketServer>> _servers;
+    std::vector<std::unique_ptr<Client>> _clients;
+    std::vector<uint32_t> _last;
+  };
+
+  // All connections drop and the board managers are down for OUTAGE
+  Result blip(uint32_t controllers, uint32_t boards, const ReconnectScheduler::Policy& policy) {
+    Venue venue(controllers, boards);
+    Result ignored;
+    venue.start(policy, nullptr);
+    venue.run(policy.healthyAfter + 5000, ignored, false);
+
+    Result result;
+    venue.setAccepting(false);
+    venue.run(OUTAGE, result, false);
+    venue.setAccepting(true);
+    result.openAfter = venue.run(LIMIT, result, true);
+    return result;
+  }
+
+  // All controllers start at the same time, the board managers come up after outage
+  Result coldStart(uint32_t controllers, uint32_t boards, const ReconnectScheduler::Policy& policy, PreferencesStorage* storage,
+                   uint32_t outage = 0) {
+    Venue venue(controllers, boards);
+    Result result;
+    venue.setAccepting(outage == 0);
+    venue.start(policy, storage);
+    venue.run(outage, result, false);
+    venue.setAccepting(true);
+    result.openAfter = venue.run(LIMIT, result, true);
+    return result;
+  }
+
+  void print(const char* scenario, const char* mode, const Result& result) {
+    printf("%-12s %-22s %10u %14u %12.1f\n", scenario, mode, result.attempts, result.peak, result.openAfter / 1000.0);
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool quick = bench::isQuick(argc, argv);
+  uint32_t controllers = quick ? 4 : 24;
+  uint32_t boards = quick ? 2 : 8;
+  mock::setManualClock(true);
+
+  // The stored list of the cold start
+  Preferences::reset();
+  PreferencesStorage storage;
+  {
+    Client client;
+    client.setStorage(&storage);
+    for (uint32_t idx = 0; idx < boards; idx++) {
+      client.addBoard("Board " + String(idx), boardId(idx), "0.22.0", boardIp(idx));
+    }
+    client.persist();
+  }
+
+  ReconnectScheduler::Policy scheduled;
+  Result blipLockstep = blip(controllers, boards, lockstep());
+  Result blipScheduled = blip(controllers, boards, scheduled);
+  Result coldLockstep = coldStart(controllers, boards, lockstep(), nullptr);
+  Result coldAdded = coldStart(controllers, boards, scheduled, nullptr);
+  Result coldRestored = coldStart(controllers, boards, scheduled, &storage);
+  Result powerLockstep = coldStart(controllers, boards, lockstep(), &storage, OUTAGE);
+  Result powerRestored = coldStart(controllers, boards, scheduled, &storage, OUTAGE);
+
+  bench::header("Reconnects of a venue");
+  printf("%u controllers, %u boards, board managers down for %u s after the blip\n", controllers, boards, OUTAGE / 1000);
+  printf("%-12s %-22s %10s %14s %12s\n", "scenario", "mode", "attempts", "peak/100 ms", "all open s");
+  print("blip", "lockstep", blipLockstep);
+  print("blip", "scheduler", blipScheduled);
+  print("cold start", "lockstep", coldLockstep);
+  print("cold start", "scheduler, added", coldAdded);
+  print("cold start", "scheduler, restored", coldRestored);
+  print("power blip", "lockstep, restored", powerLockstep);
+  print("power blip", "scheduler, restored", powerRestored);
+
+  // The scheduler spreads the retries of the blip and the boards restored at boot
+  int ret = 0;
+  if (blipScheduled.peak >= blipLockstep.peak || blipScheduled.openAfter >= LIMIT) {
+    fprintf(stderr, "The scheduler did not spread the reconnects\n");
+    ret = 1;
+  }
+  if (coldRestored.peak >= coldLockstep.peak || powerRestored.peak >= powerLockstep.peak || powerRestored.openAfter >= LIMIT) {
+    fprintf(stderr, "The scheduler did not spread the restored boards\n");
+    ret = 1;
+  }
+  return ret;
+}
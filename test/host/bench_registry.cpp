@@ -0,0 +1,166 @@
+// Board lookup and list refresh with up to 500 boards, compared with the linear scans the
+// registry replaced: mergeBoard() compared the id of every board with getId().equals(id)
+// and removeBoards() looked up every board in the list of ids that were seen. The ids are
+// kept as Strings for the old scans, like Board stored them before. The refresh applies
+// a parsed list to boards that all exist, which is the common case of a periodic refresh.
+
+#include <memory>
+
+#include <AutodartsClient.h>
+#include <Bench.h>
+#include <FakeHttpServer.h>
+
+using namespace autodarts;
+
+namespace {
+
+  String boardId(uint32_t idx) {
+    char id[40];
+    snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+    return id;
+  }
+
+  std::string entry(uint32_t idx) {
+    return std::string("{\"id\":\"") + boardId(idx).c_str() + "\",\"name\":\"Board " + std::to_string(idx) +
+           "\",\"ip\":\"10.1." + std::to_string(idx / 250) + "." + std::to_string(idx % 250 + 1) +
+           "\",\"version\":\"0.22.0\",\"permissions\":[\"owner\"]}";
+  }
+
+  std::string boardList(uint32_t count) {
+    std::string body = "[";
+    for (uint32_t idx = 0; idx < count; idx++) {
+      body += (idx > 0 ? "," : "") + entry(idx);
+    }
+    return body + "]";
+  }
+
+  // Client::_boards before the registry
+  struct LegacyBoards {
+    std::vector<String> ids;
+    std::vector<Board*> boards;
+
+    Board* find(const char* id) const {
+      for (size_t idx = 0; idx < ids.size(); idx++) {
+        if (ids[idx].equals(id)) {
+          return boards[idx];
+        }
+      }
+      return nullptr;
+    }
+
+    // Applies the list and returns the number of boards that are no longer in it
+    size_t refresh(const std::vector<std::unique_ptr<DynamicJsonDocument>>& list) const {
+      std::vector<String> seen;
+      for (const std::unique_ptr<DynamicJsonDocument>& json : list) {
+        const char* id = (*json)["id"];
+        seen.push_back(String(id));
+        Board* board = find(id);
+        if (board != nullptr) {
+          board->fromJson(json->as<JsonObjectConst>());
+        }
+      }
+      size_t removed = 0;
+      for (const String& id : ids) {
+        bool found = false;
+        for (const String& other : seen) {
+          if (other.equals(id)) {
+            found = true;
+            break;
+          }
+        }
+        removed += found ? 0 : 1;
+      }
+      return removed;
+    }
+  };
+
+  size_t refresh(const BoardRegistry& registry, const std::vector<std::unique_ptr<DynamicJsonDocument>>& list) {
+    std::vector<bool> seen(registry.capacity(), false);
+    for (const std::unique_ptr<DynamicJsonDocument>& json : list) {
+      BoardRegistry::Handle handle = registry.find((*json)["id"].as<const char*>());
+      Board* board = registry.get(handle);
+      if (board != nullptr) {
+        board->fromJson(json->as<JsonObjectConst>());
+        seen[BoardRegistry::slot(handle)] = true;
+      }
+    }
+    size_t removed = 0;
+    for (auto it = registry.begin(); it != registry.end(); ++it) {
+      removed += seen[it.slot()] ? 0 : 1;
+    }
+    return removed;
+  }
+
+  template <typename TFunction>
+  double measure(uint32_t rounds, uint32_t operations, TFunction function) {
+    uint64_t start = bench::nowNanos();
+    for (uint32_t round = 0; round < rounds; round++) {
+      function();
+    }
+    return static_cast<double>(bench::nowNanos() - start) / (static_cast<double>(rounds) * operations);
+  }
+
+  // requestBoards() against the fake server, the list is parsed from the stream
+  double request(uint32_t count, uint32_t rounds) {
+    mock::FakeHttpServer server;
+    std::string body = boardList(count);
+    server.on("GET", AUTODARTS_API_BOARDS_URL, [&body](const mock::HttpRequest&) {
+      mock::HttpResponse response;
+      response.body = body;
+      return response;
+    });
+    Client client;
+    client.setCACert(mock::ROOT_CA);
+    Client::Token token("access", millis() + 3600 * 1000);
+    client.requestBoards(token);
+    return measure(rounds, 1, [&client, &token]() { client.requestBoards(token); });
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool quick = bench::isQuick(argc, argv);
+  uint32_t rounds = quick ? 1 : 50;
+  int ret = 0;
+
+  bench::header("Board lookup by id and refresh of a list of existing boards");
+  printf("%7s %13s %13s %15s %15s %13s\n", "boards", "scan ns/find", "table ns/find", "scan us/list", "table us/list", "request us");
+  for (uint32_t count : {10u, 50u, 100u, 250u, 500u}) {
+    BoardRegistry registry;
+    LegacyBoards legacy;
+    std::vector<std::unique_ptr<DynamicJsonDocument>> list;
+    std::vector<String> ids;
+    for (uint32_t idx = 0; idx < count; idx++) {
+      ids.push_back(boardId(idx));
+      list.emplace_back(new DynamicJsonDocument(512));
+      deserializeJson(*list.back(), entry(idx));
+      BoardRegistry::Handle handle = registry.insert(BoardRegistry::BoardPtr(new Board("Board " + String(idx), ids.back(), "0.22.0", "10.1.0.1")));
+      legacy.ids.push_back(ids.back());
+      legacy.boards.push_back(registry.get(handle));
+    }
+
+    // Every id once, so the scan walks half of the boards on average
+    size_t found = 0;
+    double scanFind = measure(rounds * 20, count, [&]() {
+      for (const String& id : ids) {
+        found += legacy.find(id.c_str()) != nullptr;
+      }
+    });
+    double tableFind = measure(rounds * 20, count, [&]() {
+      for (const String& id : ids) {
+        found += registry.get(registry.find(id.c_str())) != nullptr;
+      }
+    });
+    size_t removed = 0;
+    double scanList = measure(rounds, 1, [&]() { removed += legacy.refresh(list); }) / 1000;
+    double tableList = measure(rounds, 1, [&]() { removed += refresh(registry, list); }) / 1000;
+    double requestList = request(count, rounds) / 1000;
+    printf("%7u %13.1f %13.1f %15.1f %15.1f %13.1f\n", count, scanFind, tableFind, scanList, tableList, requestList);
+
+    if (found != 2ull * rounds * 20 * count || removed != 0) {
+      fprintf(stderr, "Lookup results differ: found %zu, removed %zu\n", found, removed);
+      ret = 1;
+    }
+  }
+  return ret;
+}
@@ -0,0 +1,185 @@
+// Replays /api/events sessions through the WStype_TEXT path of Board, from the fake board
+// manager over WebSocketsClient to the callbacks of the client, and reports messages per
+// second, allocations per message and the dispatch latency per message type.
+//
+//   bench_replay [--quick] [--boards N] [--turns N] [--frames file]
+//
+// --frames replays a file with one board manager message per line instead of the
+// synthetic session, e.g. the frames of a board captured with the journal.
+
+#include <fstream>
+#include <map>
+
+#include <AutodartsClient.h>
+#include <Bench.h>
+#include <FakeWebSocketServer.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  struct Options {
+    bool        quick = false;
+    uint32_t    boards = 4;
+    uint32_t    turns = 200;
+    std::string frames;
+  };
+
+  Options parse(int argc, char** argv) {
+    Options options;
+    options.quick = bench::isQuick(argc, argv);
+    if (options.quick) {
+      options.boards = 1;
+      options.turns = 5;
+    }
+    for (int idx = 1; idx + 1 < argc; idx++) {
+      std::string arg = argv[idx];
+      if (arg == "--boards") {
+        options.boards = atoi(argv[++idx]);
+      }
+      else if (arg == "--turns") {
+        options.turns = atoi(argv[++idx]);
+      }
+      else if (arg == "--frames") {
+        options.frames = argv[++idx];
+      }
+    }
+    return options;
+  }
+
+  std::vector<std::string> loadFrames(const Options& options, uint32_t seed) {
+    std::vector<std::string> frames;
+    if (!options.frames.empty()) {
+      std::ifstream file(options.frames);
+      for (std::string line; std::getline(file, line);) {
+        if (!line.empty()) {
+          frames.push_back(line);
+        }
+      }
+      return frames;
+    }
+    session::Generator generator(seed);
+    for (const session::Frame& frame : generator.generate(options.turns)) {
+      frames.push_back(frame.json);
+    }
+    return frames;
+  }
+
+  std::string typeOf(const std::string& frame) {
+    if (frame.find("\"cam_stats\"") != std::string::npos) {
+      return "cam_stats";
+    }
+    if (frame.find("\"cam_state\"") != std::string::npos) {
+      return "cam_state";
+    }
+    return "state";
+  }
+
+  struct BoardSession {
+    std::unique_ptr<mock::FakeWebSocketServer> server;
+    Client::BoardHandle handle;
+    std::vector<std::string> frames;
+    size_t next = 0;
+  };
+
+  bool connectAll(Client& client, std::vector<BoardSession>& sessions) {
+    client.openBoards(true);
+    uint32_t start = millis();
+    while (millis() - start < 5000) {
+      client.updateBoards();
+      bool open = true;
+      for (BoardSession& session : sessions) {
+        open &= client.getBoard(session.handle)->isOpen();
+      }
+      if (open) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options = parse(argc, argv);
+
+  Client client;
+  uint32_t numThrows = 0;
+  uint32_t numData = 0;
+  client.onThrow([&numThrows](const Board&, uint8_t, const Throw&) { numThrows++; });
+  client.onData([&numData](const Board&) { numData++; });
+
+  std::vector<BoardSession> sessions(options.boards);
+  size_t numFrames = 0;
+  for (uint32_t idx = 0; idx < options.boards; idx++) {
+    BoardSession& session = sessions[idx];
+    String address = "10.0.0." + String(idx + 10);
+    char id[40];
+    snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+    session.server.reset(new mock::FakeWebSocketServer(address, AUTODARTS_BOARD_PORT));
+    session.handle = client.addBoard("Board " + String(idx), id, "0.22.0", address);
+    session.frames = loadFrames(options, idx + 1);
+    numFrames += session.frames.size();
+  }
+  if (!connectAll(client, sessions)) {
+    fprintf(stderr, "Boards did not connect\n");
+    return 1;
+  }
+  for (BoardSession& session : sessions) {
+    for (const std::string& frame : session.frames) {
+      session.server->push(frame);
+    }
+  }
+
+  // Every updateBoard() call delivers exactly one frame through WStype_TEXT
+  std::map<std::string, bench::Samples> latency;
+  std::map<std::string, size_t> counts;
+  std::map<std::string, uint64_t> allocationsOf;
+  bench::Samples all;
+  all.reserve(numFrames);
+  uint64_t allocations = 0;
+  uint64_t start = bench::nowNanos();
+  for (bool pending = true; pending;) {
+    pending = false;
+    for (BoardSession& session : sessions) {
+      if (session.next == session.frames.size()) {
+        continue;
+      }
+      pending = true;
+      const std::string& type = typeOf(session.frames[session.next++]);
+      bench::AllocationCounter counter;
+      uint64_t begin = bench::nowNanos();
+      client.updateBoard(session.handle);
+      uint64_t elapsed = bench::nowNanos() - begin;
+      allocations += counter.count();
+      allocationsOf[type] += counter.count();
+      latency[type].add(elapsed);
+      counts[type]++;
+      all.add(elapsed);
+    }
+  }
+  uint64_t total = bench::nowNanos() - start;
+
+  bench::header("Board manager replay through WStype_TEXT");
+  printf("%s, %u boards, %zu frames, %u throws, %u data callbacks\n",
+         options.frames.empty() ? "synthetic session" : options.frames.c_str(),
+         options.boards, numFrames, numThrows, numData);
+  printf("%-10s %8s %12s %10s %10s\n", "type", "frames", "allocs/msg", "p50 us", "p99 us");
+  for (auto& entry : latency) {
+    printf("%-10s %8zu %12.2f %10.2f %10.2f\n", entry.first.c_str(), counts[entry.first],
+           static_cast<double>(allocationsOf[entry.first]) / counts[entry.first],
+           entry.second.percentile(50) / 1000.0, entry.second.percentile(99) / 1000.0);
+  }
+  printf("%-10s %8zu %12.2f %10.2f %10.2f\n", "all", all.size(), static_cast<double>(allocations) / all.size(),
+         all.percentile(50) / 1000.0, all.percentile(99) / 1000.0);
+  printf("throughput: %.0f msgs/s\n", all.size() / (total / 1e9));
+
+  for (BoardSession& session : sessions) {
+    if (session.server->getPending() > 0) {
+      fprintf(stderr, "Frames left undelivered\n");
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+// Cost of publishing an event by the number of listeners, compared with the single
+// std::function slot a topic replaced. The topic is the one of the throw events, every
+// listener counts the call. With a histogram the time spent in the listeners is also
+// recorded, which is how the client publishes.
+
+#include <AutodartsEvents.h>
+#include <AutodartsBoard.h>
+#include <Bench.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+
+  typedef Topic<AUTODARTS_MAX_LISTENERS, const Board&, uint8_t, const Throw&> ThrowTopic;
+
+  template <typename TPublish>
+  double measure(uint32_t rounds, TPublish publish) {
+    uint64_t start = bench::nowNanos();
+    for (uint32_t round = 0; round < rounds; round++) {
+      publish(static_cast<uint8_t>(round % 3));
+    }
+    return static_cast<double>(bench::nowNanos() - start) / rounds;
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool quick = bench::isQuick(argc, argv);
+  uint32_t rounds = quick ? 1000 : 5000000;
+  int ret = 0;
+
+  Board board("Board", BOARD_ID, "0.22.0", "10.0.0.1");
+  Throw dart;
+  uint64_t calls = 0;
+  auto listener = [&calls](const Board&, uint8_t idx, const Throw&) { calls += idx + 1; };
+
+  // The single slot before the topics
+  std::function<void(const Board&, uint8_t, const Throw&)> slot = listener;
+  double single = measure(rounds, [&](uint8_t idx) {
+    if (slot) {
+      slot(board, idx, dart);
+    }
+  });
+
+  bench::header("Publish of a throw event");
+  printf("%-10s %12s %12s %16s %12s\n", "listeners", "ns/publish", "ns/listener", "with histogram", "allocations");
+  printf("%-10s %12.1f %12.1f %16s %12s\n", "1 (slot)", single, single, "-", "-");
+  for (uint8_t count = 0; count <= AUTODARTS_MAX_LISTENERS; count++) {
+    MetricHistogram histogram;
+    ThrowTopic topic(1);
+    ThrowTopic timed(2, &histogram);
+    for (uint8_t idx = 0; idx < count; idx++) {
+      topic.subscribe(listener);
+      timed.subscribe(listener);
+    }
+
+    uint64_t expected = calls;
+    bench::AllocationCounter counter;
+    double nanos = measure(rounds, [&](uint8_t idx) { topic.publish(board, idx, dart); });
+    double timedNanos = measure(rounds, [&](uint8_t idx) { timed.publish(board, idx, dart); });
+    uint64_t allocations = counter.count();
+    printf("%-10u %12.1f %12.1f %16.1f %12llu\n", count, nanos, count > 0 ? nanos / count : 0.0, timedNanos,
+           static_cast<unsigned long long>(allocations));
+
+    // 1 + 2 + 3 per three publishes and listener, in both topics
+    for (uint32_t round = 0; round < rounds; round++) {
+      expected += 2ull * count * (round % 3 + 1);
+    }
+    if (calls != expected || allocations != 0 || histogram.getCount() != (count > 0 ? rounds : 0)) {
+      fprintf(stderr, "Unexpected calls, allocations or samples with %u listeners\n", count);
+      ret = 1;
+    }
+  }
+  return ret;
+}
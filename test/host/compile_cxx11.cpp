@@ -0,0 +1,2 @@
+// Compiles every header of the library as C++11
+#include <AutodartsClient.h>
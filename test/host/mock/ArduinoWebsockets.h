@@ -0,0 +1,7 @@
+#ifndef ArduinoWebsockets_h_
+#define ArduinoWebsockets_h_
+
+// The host build uses WebSocketsClient, ALTERNATE_WEBSOCKET is defined by AutodartsBoard.h
+namespace websockets {}
+
+#endif // ArduinoWebsockets_h_
@@ -0,0 +1,69 @@
+#ifndef EasyLogger_h_
+#define EasyLogger_h_
+
+// Host stand-in for EasyLogger. The macros take the same streamed content, lines are
+// counted per level and only formatted if they are printed or captured, see MockRuntime.h.
+
+#include <sstream>
+#include <string>
+
+#include "MockRuntime.h"
+#include "WString.h"
+
+#define LOG_LEVEL_ERROR   0
+#define LOG_LEVEL_WARNING 1
+#define LOG_LEVEL_INFO    2
+#define LOG_LEVEL_DEBUG   3
+
+#define LOG_FORMATTING_NOTIME 0
+#define LOG_FORMATTING_MILLIS 1
+
+namespace mock {
+
+  class LogLine {
+  public:
+    LogLine(LogLevel level, const char* tag) : _level(level), _tag(tag) {}
+
+    ~LogLine() {
+      log(_level, _tag, _out.str());
+    }
+
+    LogLine& operator<<(const char* value) { _out << (value != nullptr ? value : "(null)"); return *this; }
+    LogLine& operator<<(const __FlashStringHelper* value) { return *this << reinterpret_cast<const char*>(value); }
+    LogLine& operator<<(const String& value) { _out << value.c_str(); return *this; }
+    LogLine& operator<<(char value) { _out << value; return *this; }
+    LogLine& operator<<(signed char value) { _out << static_cast<int>(value); return *this; }
+    LogLine& operator<<(unsigned char value) { _out << static_cast<unsigned>(value); return *this; }
+    LogLine& operator<<(bool value) { _out << (value ? 1 : 0); return *this; }
+    LogLine& operator<<(float value) { return *this << static_cast<double>(value); }
+    LogLine& operator<<(double value) { _out << String(value).c_str(); return *this; }
+
+    template <typename T>
+    LogLine& operator<<(const T& value) {
+      _out << value;
+      return *this;
+    }
+
+  private:
+    LogLevel _level;
+    const char* _tag;
+    std::ostringstream _out;
+  };
+
+} // mock
+
+#define MOCK_LOG(level, service, content) do { \
+    if (mock::isLogFormatted()) { \
+      mock::LogLine(level, service) << content; \
+    } \
+    else { \
+      mock::log(level, service, std::string()); \
+    } \
+  } while (0)
+
+#define LOG_ERROR(service, content)   MOCK_LOG(mock::LOG_ERROR, service, content)
+#define LOG_WARNING(service, content) MOCK_LOG(mock::LOG_WARNING, service, content)
+#define LOG_INFO(service, content)    MOCK_LOG(mock::LOG_INFO, service, content)
+#define LOG_DEBUG(service, content)   MOCK_LOG(mock::LOG_DEBUG, service, content)
+
+#endif // EasyLogger_h_
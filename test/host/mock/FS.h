@@ -0,0 +1,187 @@
+#ifndef FS_h_
+#define FS_h_
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <Arduino.h>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+// Host stand-in for the Arduino ESP32 file system API, backed by files below a directory
+namespace fs {
+
+  enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2,
+  };
+
+  class FileImpl {
+  public:
+    FileImpl(FILE* file, const std::string& path) : _file(file), _path(path) {}
+
+    ~FileImpl() {
+      close();
+    }
+
+    void close() {
+      if (_file != nullptr) {
+        fclose(_file);
+        _file = nullptr;
+      }
+    }
+
+    FILE* get() const {
+      return _file;
+    }
+
+    const std::string& path() const {
+      return _path;
+    }
+
+  private:
+    FILE* _file;
+    std::string _path;
+  };
+
+  class File : public Stream {
+  public:
+    File() = default;
+    explicit File(std::shared_ptr<FileImpl> impl) : _impl(impl) {}
+
+    operator bool() const {
+      return _impl && _impl->get() != nullptr;
+    }
+
+    size_t write(uint8_t c) override {
+      return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+      return *this ? fwrite(buffer, 1, size, _impl->get()) : 0;
+    }
+
+    using Print::write;
+
+    int available() override {
+      if (!*this) {
+        return 0;
+      }
+      long remaining = static_cast<long>(size()) - static_cast<long>(position());
+      return remaining > 0 ? static_cast<int>(remaining) : 0;
+    }
+
+    int read() override {
+      return *this ? fgetc(_impl->get()) : -1;
+    }
+
+    size_t read(uint8_t* buffer, size_t size) {
+      return *this ? fread(buffer, 1, size, _impl->get()) : 0;
+    }
+
+    int peek() override {
+      if (!*this) {
+        return -1;
+      }
+      int c = fgetc(_impl->get());
+      if (c >= 0) {
+        ungetc(c, _impl->get());
+      }
+      return c;
+    }
+
+    void flush() {
+      if (*this) {
+        fflush(_impl->get());
+      }
+    }
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+      static const int whence[] = { SEEK_SET, SEEK_CUR, SEEK_END };
+      return *this && fseek(_impl->get(), pos, whence[mode]) == 0;
+    }
+
+    size_t position() const {
+      return *this ? ftell(_impl->get()) : 0;
+    }
+
+    size_t size() const {
+      if (!*this) {
+        return 0;
+      }
+      FILE* file = _impl->get();
+      long pos = ftell(file);
+      fseek(file, 0, SEEK_END);
+      long size = ftell(file);
+      fseek(file, pos, SEEK_SET);
+      return size;
+    }
+
+    void close() {
+      if (_impl) {
+        _impl->close();
+      }
+      _impl.reset();
+    }
+
+    const char* path() const {
+      return _impl ? _impl->path().c_str() : nullptr;
+    }
+
+  private:
+    std::shared_ptr<FileImpl> _impl;
+  };
+
+  class FS {
+  public:
+    explicit FS(const std::string& root) : _root(root) {}
+
+    File open(const char* path, const char* mode = FILE_READ, bool = false) {
+      std::string host = _root + path;
+      // Binary modes, reading an appended file like LittleFS does
+      std::string hostMode = std::string(mode) == FILE_APPEND ? "a+b" : std::string(mode) + "b";
+      FILE* file = fopen(host.c_str(), hostMode.c_str());
+      if (file == nullptr) {
+        return File();
+      }
+      return File(std::make_shared<FileImpl>(file, path));
+    }
+
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+      return open(path.c_str(), mode, create);
+    }
+
+    bool exists(const char* path) {
+      FILE* file = fopen((_root + path).c_str(), "rb");
+      if (file != nullptr) {
+        fclose(file);
+      }
+      return file != nullptr;
+    }
+
+    bool remove(const char* path) {
+      return ::remove((_root + path).c_str()) == 0;
+    }
+
+    bool rename(const char* from, const char* to) {
+      return ::rename((_root + from).c_str(), (_root + to).c_str()) == 0;
+    }
+
+    const std::string& root() const {
+      return _root;
+    }
+
+  private:
+    std::string _root;
+  };
+
+} // fs
+
+using fs::FS;
+using fs::File;
+
+#endif // FS_h_
@@ -0,0 +1,76 @@
+#ifndef FakeHttpServer_h_
+#define FakeHttpServer_h_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mock {
+
+  struct HttpRequest {
+    std::string method;
+    std::string url;
+    std::map<std::string, std::string> headers;
+    std::string body;
+  };
+
+  struct HttpResponse {
+    int code = 200;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    bool chunked = false;
+    size_t chunkSize = 512;
+    bool keepAlive = true;
+    uint32_t delay = 0;         // Until the response arrives
+    uint32_t trailerDelay = 0;  // Until the last chunk arrives, after the rest of a chunked body
+  };
+
+  // Set as root certificate of clients that connect to the server. The stand-ins accept any
+  // certificate, only a client that cannot verify the server fails the handshake.
+  const char* const ROOT_CA = "mock root certificate";
+
+  // Stands in for autodarts.io. Routes map the method and url without query to a handler,
+  // every new connection is one TLS handshake that takes the handshake delay.
+  class FakeHttpServer {
+  public:
+    typedef std::function<HttpResponse(const HttpRequest&)> Handler;
+
+    FakeHttpServer();
+    ~FakeHttpServer();
+
+    FakeHttpServer(const FakeHttpServer&) = delete;
+    FakeHttpServer& operator=(const FakeHttpServer&) = delete;
+
+    void on(const std::string& method, const std::string& url, Handler handler);
+
+    void setHandshakeDelay(uint32_t ms);
+
+    // Lets the server close all kept alive connections, like an idle timeout
+    void closeConnections();
+
+    uint32_t getNumHandshakes();
+    uint32_t getNumRequests();
+    std::vector<HttpRequest> getRequests();
+
+    // Called by the client stand-ins
+    static FakeHttpServer* current();
+    bool handshake(uint32_t& generation);
+    bool isOpen(uint32_t generation);
+    HttpResponse handle(const HttpRequest& request);
+
+  private:
+    std::mutex _mutex;
+    std::map<std::string, Handler> _routes;
+    std::vector<HttpRequest> _requests;
+    uint32_t _handshakeDelay = 0;
+    uint32_t _numHandshakes = 0;
+    uint32_t _generation = 1;
+  };
+
+} // mock
+
+#endif // FakeHttpServer_h_
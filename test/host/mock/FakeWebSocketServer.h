@@ -0,0 +1,72 @@
+#ifndef FakeWebSocketServer_h_
+#define FakeWebSocketServer_h_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "WString.h"
+
+namespace mock {
+
+  // One connection between a WebSocketsClient and a FakeWebSocketServer. Frames are kept
+  // until the server is cleared, so delivering them does not allocate.
+  struct WebSocketConnection {
+    std::mutex               mutex;
+    std::vector<std::string> inbox;
+    size_t                   next = 0;
+    std::vector<std::string> sent;
+    bool                     closed = false;
+  };
+
+  // Stands in for a board manager or the cloud at "host:port". Clients that call loop()
+  // connect after the handshake delay and receive one pushed frame per loop().
+  class FakeWebSocketServer {
+  public:
+    FakeWebSocketServer(const String& host, uint16_t port);
+    ~FakeWebSocketServer();
+
+    FakeWebSocketServer(const FakeWebSocketServer&) = delete;
+    FakeWebSocketServer& operator=(const FakeWebSocketServer&) = delete;
+
+    // Refused connections fail without an event, like a board manager that is down
+    void setAccepting(bool accepting);
+    void setHandshakeDelay(uint32_t ms);
+    // connect() blocks the calling thread for ms, like a board manager that is slow to answer
+    void setConnectDelay(uint32_t ms);
+
+    // Queues a frame for every open connection
+    void push(const std::string& frame);
+
+    // Closes the open connections, clients see WStype_DISCONNECTED on their next loop()
+    void dropAll();
+
+    uint32_t getNumConnected();
+    uint32_t getNumHandshakes();
+    uint32_t getNumRefused();
+
+    // Frames sent by all clients so far
+    std::vector<std::string> getReceived();
+
+    // Frames pushed but not yet delivered to a client
+    size_t getPending();
+
+    // Called by WebSocketsClient, nullptr if refused or there is no server at the address
+    static std::shared_ptr<WebSocketConnection> connect(const std::string& address, uint32_t& handshakeDelay);
+
+  private:
+    std::string _address;
+    std::mutex _mutex;
+    std::vector<std::shared_ptr<WebSocketConnection>> _connections;
+    bool _accepting = true;
+    uint32_t _handshakeDelay = 0;
+    uint32_t _connectDelay = 0;
+    uint32_t _numHandshakes = 0;
+    uint32_t _numRefused = 0;
+  };
+
+} // mock
+
+#endif // FakeWebSocketServer_h_
@@ -0,0 +1,115 @@
+#ifndef HTTPClient_h_
+#define HTTPClient_h_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "FakeHttpServer.h"
+#include "WiFiClient.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED       (-4)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+#define HTTPC_ERROR_NO_STREAM           (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER      (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM        (-8)
+#define HTTPC_ERROR_ENCODING            (-9)
+#define HTTPC_ERROR_STREAM_WRITE        (-10)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+typedef enum {
+  HTTP_CODE_CONTINUE = 100,
+  HTTP_CODE_SWITCHING_PROTOCOLS = 101,
+  HTTP_CODE_PROCESSING = 102,
+  HTTP_CODE_OK = 200,
+  HTTP_CODE_CREATED = 201,
+  HTTP_CODE_ACCEPTED = 202,
+  HTTP_CODE_NON_AUTHORITATIVE_INFORMATION = 203,
+  HTTP_CODE_NO_CONTENT = 204,
+  HTTP_CODE_RESET_CONTENT = 205,
+  HTTP_CODE_PARTIAL_CONTENT = 206,
+  HTTP_CODE_MULTI_STATUS = 207,
+  HTTP_CODE_MOVED_PERMANENTLY = 301,
+  HTTP_CODE_FOUND = 302,
+  HTTP_CODE_SEE_OTHER = 303,
+  HTTP_CODE_NOT_MODIFIED = 304,
+  HTTP_CODE_BAD_REQUEST = 400,
+  HTTP_CODE_UNAUTHORIZED = 401,
+  HTTP_CODE_FORBIDDEN = 403,
+  HTTP_CODE_NOT_FOUND = 404,
+  HTTP_CODE_REQUEST_TIMEOUT = 408,
+  HTTP_CODE_CONFLICT = 409,
+  HTTP_CODE_TOO_MANY_REQUESTS = 429,
+  HTTP_CODE_INTERNAL_SERVER_ERROR = 500,
+  HTTP_CODE_BAD_GATEWAY = 502,
+  HTTP_CODE_SERVICE_UNAVAILABLE = 503,
+} t_http_codes;
+
+// Host stand-in for the ESP32 HTTPClient. The request is handed to the mock::FakeHttpServer,
+// its response is written to the WiFiClient as raw bytes and read back like on the device:
+// status line and headers by sendRequest(), the body by getString() or through getStream().
+// Like the real client, a reused connection is only flushed of bytes that already arrived.
+class HTTPClient {
+public:
+  bool begin(WiFiClient& client, const String& url);
+  void end();
+
+  void setReuse(bool reuse) {
+    _reuse = reuse;
+  }
+
+  void setTimeout(uint16_t timeout) {
+    _timeout = timeout;
+  }
+
+  void addHeader(const String& name, const String& value);
+  void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+  String header(const char* name);
+  bool hasHeader(const char* name);
+
+  int GET() { return sendRequest("GET"); }
+  int POST(const String& payload) { return sendRequest("POST", payload); }
+  int sendRequest(const char* type, const String& payload = String());
+
+  int getSize() const {
+    return _size;
+  }
+
+  WiFiClient& getStream() {
+    return *_client;
+  }
+
+  WiFiClient* getStreamPtr() {
+    return _client;
+  }
+
+  // Reads the whole body, decoding chunks
+  String getString();
+
+  bool connected() {
+    return _client != nullptr && _client->connected();
+  }
+
+private:
+  bool connect();
+  bool readLine(std::string& line);
+  int handleHeaderResponse();
+
+  WiFiClient* _client = nullptr;
+  std::string _url;
+  bool _reuse = true;
+  bool _canReuse = false;
+  uint16_t _timeout = 5000;
+  std::vector<std::pair<std::string, std::string>> _requestHeaders;
+  std::vector<std::string> _collect;
+  std::map<std::string, std::string> _collected;
+  int _size = -1;
+  bool _chunked = false;
+};
+
+#endif // HTTPClient_h_
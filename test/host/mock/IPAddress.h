@@ -0,0 +1,86 @@
+#ifndef IPAddress_h_
+#define IPAddress_h_
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "WString.h"
+
+// IPv4 only, the address is kept in network byte order like on the ESP32
+class IPAddress {
+public:
+  IPAddress() = default;
+
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    _bytes[0] = a;
+    _bytes[1] = b;
+    _bytes[2] = c;
+    _bytes[3] = d;
+  }
+
+  IPAddress(uint32_t address) {
+    memcpy(_bytes, &address, sizeof(_bytes));
+  }
+
+  operator uint32_t() const {
+    uint32_t address;
+    memcpy(&address, _bytes, sizeof(address));
+    return address;
+  }
+
+  bool operator==(const IPAddress& other) const {
+    return memcmp(_bytes, other._bytes, sizeof(_bytes)) == 0;
+  }
+
+  bool operator==(uint32_t address) const {
+    return static_cast<uint32_t>(*this) == address;
+  }
+
+  uint8_t operator[](int idx) const {
+    return _bytes[idx];
+  }
+
+  bool fromString(const char* address) {
+    uint8_t bytes[4];
+    const char* c = address;
+    for (uint8_t idx = 0; idx < 4; idx++) {
+      if (*c < '0' || *c > '9') {
+        return false;
+      }
+      char* end;
+      unsigned long value = strtoul(c, &end, 10);
+      if (value > 255 || end - c > 3) {
+        return false;
+      }
+      bytes[idx] = value;
+      c = end;
+      if (idx < 3) {
+        if (*c != '.') {
+          return false;
+        }
+        c++;
+      }
+    }
+    if (*c != '\0') {
+      return false;
+    }
+    memcpy(_bytes, bytes, sizeof(_bytes));
+    return true;
+  }
+
+  bool fromString(const String& address) {
+    return fromString(address.c_str());
+  }
+
+  String toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+    return String(buffer);
+  }
+
+private:
+  uint8_t _bytes[4] = {0, 0, 0, 0};
+};
+
+#endif // IPAddress_h_
@@ -0,0 +1,654 @@
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <set>
+#include <thread>
+
+#include <FakeHttpServer.h>
+#include <FakeWebSocketServer.h>
+#include <HTTPClient.h>
+#include <Preferences.h>
+#include <WiFiClient.h>
+
+namespace mock {
+
+  namespace {
+
+    std::mutex webSocketServersMutex;
+    std::map<std::string, FakeWebSocketServer*> webSocketServers;
+
+    std::mutex httpServerMutex;
+    FakeHttpServer* httpServer = nullptr;
+
+    std::string lower(std::string value) {
+      std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return tolower(c); });
+      return value;
+    }
+
+  } // namespace
+
+  FakeWebSocketServer::FakeWebSocketServer(const String& host, uint16_t port)
+    : _address(std::string(host.c_str()) + ":" + std::to_string(port)) {
+    std::lock_guard<std::mutex> lock(webSocketServersMutex);
+    webSocketServers[_address] = this;
+  }
+
+  FakeWebSocketServer::~FakeWebSocketServer() {
+    {
+      std::lock_guard<std::mutex> lock(webSocketServersMutex);
+      webSocketServers.erase(_address);
+    }
+    dropAll();
+  }
+
+  void FakeWebSocketServer::setAccepting(bool accepting) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _accepting = accepting;
+  }
+
+  void FakeWebSocketServer::setHandshakeDelay(uint32_t ms) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _handshakeDelay = ms;
+  }
+
+  void FakeWebSocketServer::setConnectDelay(uint32_t ms) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _connectDelay = ms;
+  }
+
+  void FakeWebSocketServer::push(const std::string& frame) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const std::shared_ptr<WebSocketConnection>& connection : _connections) {
+      std::lock_guard<std::mutex> connectionLock(connection->mutex);
+      if (!connection->closed) {
+        connection->inbox.push_back(frame);
+      }
+    }
+  }
+
+  void FakeWebSocketServer::dropAll() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const std::shared_ptr<WebSocketConnection>& connection : _connections) {
+      std::lock_guard<std::mutex> connectionLock(connection->mutex);
+      connection->closed = true;
+    }
+    _connections.clear();
+  }
+
+  uint32_t FakeWebSocketServer::getNumConnected() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint32_t count = 0;
+    for (const std::shared_ptr<WebSocketConnection>& connection : _connections) {
+      std::lock_guard<std::mutex> connectionLock(connection->mutex);
+      count += connection->closed ? 0 : 1;
+    }
+    return count;
+  }
+
+  uint32_t FakeWebSocketServer::getNumHandshakes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numHandshakes;
+  }
+
+  uint32_t FakeWebSocketServer::getNumRefused() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numRefused;
+  }
+
+  std::vector<std::string> FakeWebSocketServer::getReceived() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::string> received;
+    for (const std::shared_ptr<WebSocketConnection>& connection : _connections) {
+      std::lock_guard<std::mutex> connectionLock(connection->mutex);
+      received.insert(received.end(), connection->sent.begin(), connection->sent.end());
+    }
+    return received;
+  }
+
+  size_t FakeWebSocketServer::getPending() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t pending = 0;
+    for (const std::shared_ptr<WebSocketConnection>& connection : _connections) {
+      std::lock_guard<std::mutex> connectionLock(connection->mutex);
+      pending += connection->closed ? 0 : connection->inbox.size() - connection->next;
+    }
+    return pending;
+  }
+
+  std::shared_ptr<WebSocketConnection> FakeWebSocketServer::connect(const std::string& address, uint32_t& handshakeDelay) {
+    uint32_t connectDelay = 0;
+    {
+      std::lock_guard<std::mutex> lock(webSocketServersMutex);
+      auto it = webSocketServers.find(address);
+      if (it != webSocketServers.end()) {
+        std::lock_guard<std::mutex> serverLock(it->second->_mutex);
+        connectDelay = it->second->_connectDelay;
+      }
+    }
+    // Blocks in real time like the TCP connect of the library, the server is looked up again after it
+    if (connectDelay > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(connectDelay));
+    }
+
+    std::lock_guard<std::mutex> lock(webSocketServersMutex);
+    auto it = webSocketServers.find(address);
+    if (it == webSocketServers.end()) {
+      return nullptr;
+    }
+    FakeWebSocketServer& server = *it->second;
+    std::lock_guard<std::mutex> serverLock(server._mutex);
+    if (!server._accepting) {
+      server._numRefused++;
+      return nullptr;
+    }
+    // Closed connections are only pruned here, so the frames of open ones never move
+    server._connections.erase(std::remove_if(server._connections.begin(), server._connections.end(),
+      [](const std::shared_ptr<WebSocketConnection>& connection) {
+        std::lock_guard<std::mutex> connectionLock(connection->mutex);
+        return connection->closed;
+      }), server._connections.end());
+    server._numHandshakes++;
+    handshakeDelay = server._handshakeDelay;
+    std::shared_ptr<WebSocketConnection> connection = std::make_shared<WebSocketConnection>();
+    server._connections.push_back(connection);
+    return connection;
+  }
+
+  FakeHttpServer::FakeHttpServer() {
+    std::lock_guard<std::mutex> lock(httpServerMutex);
+    httpServer = this;
+  }
+
+  FakeHttpServer::~FakeHttpServer() {
+    std::lock_guard<std::mutex> lock(httpServerMutex);
+    if (httpServer == this) {
+      httpServer = nullptr;
+    }
+  }
+
+  void FakeHttpServer::on(const std::string& method, const std::string& url, Handler handler) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _routes[method + " " + url] = handler;
+  }
+
+  void FakeHttpServer::setHandshakeDelay(uint32_t ms) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _handshakeDelay = ms;
+  }
+
+  void FakeHttpServer::closeConnections() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _generation++;
+  }
+
+  uint32_t FakeHttpServer::getNumHandshakes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numHandshakes;
+  }
+
+  uint32_t FakeHttpServer::getNumRequests() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _requests.size();
+  }
+
+  std::vector<HttpRequest> FakeHttpServer::getRequests() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _requests;
+  }
+
+  FakeHttpServer* FakeHttpServer::current() {
+    std::lock_guard<std::mutex> lock(httpServerMutex);
+    return httpServer;
+  }
+
+  bool FakeHttpServer::handshake(uint32_t& generation) {
+    uint32_t handshakeDelay;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _numHandshakes++;
+      generation = _generation;
+      handshakeDelay = _handshakeDelay;
+    }
+    delay(handshakeDelay);
+    return true;
+  }
+
+  bool FakeHttpServer::isOpen(uint32_t generation) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return generation == _generation;
+  }
+
+  HttpResponse FakeHttpServer::handle(const HttpRequest& request) {
+    Handler handler;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _requests.push_back(request);
+      std::string url = request.url.substr(0, request.url.find('?'));
+      auto it = _routes.find(request.method + " " + url);
+      if (it != _routes.end()) {
+        handler = it->second;
+      }
+    }
+    if (!handler) {
+      HttpResponse response;
+      response.code = 404;
+      response.body = "Not found";
+      return response;
+    }
+    return handler(request);
+  }
+
+} // mock
+
+int WiFiClient::connect(const char*, uint16_t) {
+  stop();
+  mock::FakeHttpServer* server = mock::FakeHttpServer::current();
+  return server != nullptr && server->handshake(_generation) ? 1 : 0;
+}
+
+void WiFiClient::stop() {
+  _generation = 0;
+  _segments.clear();
+  _offset = 0;
+}
+
+// Like a socket that has not seen the reset of the server yet, see write()
+uint8_t WiFiClient::connected() {
+  return _generation != 0 ? 1 : 0;
+}
+
+int WiFiClient::available() {
+  uint32_t now = millis();
+  size_t count = 0;
+  for (size_t idx = 0; idx < _segments.size() && static_cast<int32_t>(now - _segments[idx].at) >= 0; idx++) {
+    count += _segments[idx].data.size() - (idx == 0 ? _offset : 0);
+  }
+  return count;
+}
+
+int WiFiClient::read() {
+  int c = peek();
+  if (c >= 0 && ++_offset == _segments.front().data.size()) {
+    _segments.erase(_segments.begin());
+    _offset = 0;
+  }
+  return c;
+}
+
+int WiFiClient::peek() {
+  if (_segments.empty() || static_cast<int32_t>(millis() - _segments.front().at) < 0) {
+    return -1;
+  }
+  return static_cast<uint8_t>(_segments.front().data[_offset]);
+}
+
+size_t WiFiClient::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+// Writing to a connection the server has closed fails
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+  mock::FakeHttpServer* server = mock::FakeHttpServer::current();
+  if (_generation == 0 || server == nullptr || !server->isOpen(_generation)) {
+    return 0;
+  }
+  _sent.append(reinterpret_cast<const char*>(buffer), size);
+  return size;
+}
+
+void WiFiClient::mockReceive(const std::string& data, uint32_t at) {
+  if (!data.empty()) {
+    _segments.push_back(Segment{data, at});
+  }
+}
+
+bool HTTPClient::begin(WiFiClient& client, const String& url) {
+  _client = &client;
+  _url = url.c_str();
+  _requestHeaders.clear();
+  _collected.clear();
+  _size = -1;
+  _chunked = false;
+  _canReuse = _reuse;
+  return true;
+}
+
+void HTTPClient::end() {
+  if (_client != nullptr) {
+    if (_client->connected() && _reuse && _canReuse) {
+      while (_client->available() > 0) {
+        _client->read();
+      }
+    }
+    else {
+      _client->stop();
+    }
+  }
+  _requestHeaders.clear();
+  _collected.clear();
+  _size = -1;
+  _chunked = false;
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+  _requestHeaders.emplace_back(name.c_str(), value.c_str());
+}
+
+void HTTPClient::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+  _collect.clear();
+  for (size_t idx = 0; idx < headerKeysCount; idx++) {
+    _collect.push_back(mock::lower(headerKeys[idx]));
+  }
+}
+
+String HTTPClient::header(const char* name) {
+  auto it = _collected.find(mock::lower(name));
+  return it != _collected.end() ? String(it->second.c_str()) : String();
+}
+
+bool HTTPClient::hasHeader(const char* name) {
+  return _collected.count(mock::lower(name)) > 0;
+}
+
+bool HTTPClient::connect() {
+  if (_client->connected()) {
+    // Reused connection, like the ESP32 client only bytes that already arrived are dropped
+    while (_client->available() > 0) {
+      _client->read();
+    }
+    return true;
+  }
+  return _client->connect("autodarts.io", 443) == 1;
+}
+
+int HTTPClient::sendRequest(const char* type, const String& payload) {
+  _collected.clear();
+  _size = -1;
+  _chunked = false;
+  _canReuse = _reuse;
+
+  if (!connect()) {
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+
+  mock::HttpRequest request;
+  request.method = type;
+  request.url = _url;
+  request.body = payload.c_str();
+  std::string raw = request.method + " " + _url + " HTTP/1.1\r\n";
+  for (const std::pair<std::string, std::string>& header : _requestHeaders) {
+    request.headers[mock::lower(header.first)] = header.second;
+    raw += header.first + ": " + header.second + "\r\n";
+  }
+  raw += "\r\n" + request.body;
+  if (_client->write(reinterpret_cast<const uint8_t*>(raw.data()), raw.size()) != raw.size()) {
+    _client->stop();
+    return HTTPC_ERROR_SEND_HEADER_FAILED;
+  }
+
+  mock::FakeHttpServer* server = mock::FakeHttpServer::current();
+  mock::HttpResponse response = server->handle(request);
+
+  std::string head = "HTTP/1.1 " + std::to_string(response.code) + " Mock\r\n";
+  for (const std::pair<std::string, std::string>& header : response.headers) {
+    head += header.first + ": " + header.second + "\r\n";
+  }
+  if (!response.keepAlive) {
+    head += "Connection: close\r\n";
+  }
+  std::string body;
+  std::string trailer;
+  if (response.chunked) {
+    head += "Transfer-Encoding: chunked\r\n";
+    for (size_t pos = 0; pos < response.body.size(); pos += response.chunkSize) {
+      size_t length = std::min(response.chunkSize, response.body.size() - pos);
+      char size[16];
+      snprintf(size, sizeof(size), "%zx\r\n", length);
+      body += size + response.body.substr(pos, length) + "\r\n";
+    }
+    trailer = "0\r\n\r\n";
+  }
+  else if (response.code != HTTP_CODE_NOT_MODIFIED && response.code != HTTP_CODE_NO_CONTENT) {
+    head += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    body = response.body;
+  }
+  head += "\r\n";
+
+  uint32_t at = millis() + response.delay;
+  _client->mockReceive(head + body, at);
+  _client->mockReceive(trailer, at + response.trailerDelay);
+  return handleHeaderResponse();
+}
+
+bool HTTPClient::readLine(std::string& line) {
+  char buffer[512];
+  _client->setTimeout(_timeout);
+  size_t length = _client->readBytesUntil('\n', buffer, sizeof(buffer));
+  line.assign(buffer, length);
+  if (!line.empty() && line.back() == '\r') {
+    line.pop_back();
+  }
+  return length > 0;
+}
+
+int HTTPClient::handleHeaderResponse() {
+  std::string line;
+  if (!readLine(line)) {
+    _client->stop();
+    return HTTPC_ERROR_READ_TIMEOUT;
+  }
+  if (line.compare(0, 7, "HTTP/1.") != 0 || line.size() < 12) {
+    _client->stop();
+    return HTTPC_ERROR_NO_HTTP_SERVER;
+  }
+  int code = atoi(line.c_str() + 9);
+
+  while (readLine(line) && !line.empty()) {
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    std::string name = mock::lower(line.substr(0, colon));
+    std::string value = line.substr(line.find_first_not_of(' ', colon + 1));
+    if (name == "content-length") {
+      _size = atoi(value.c_str());
+    }
+    else if (name == "transfer-encoding") {
+      _chunked = mock::lower(value) == "chunked";
+    }
+    else if (name == "connection" && mock::lower(value) == "close") {
+      _canReuse = false;
+    }
+    if (std::find(_collect.begin(), _collect.end(), name) != _collect.end()) {
+      _collected[name] = value;
+    }
+  }
+  return code;
+}
+
+String HTTPClient::getString() {
+  String body;
+  if (_client == nullptr) {
+    return body;
+  }
+  if (_chunked) {
+    std::string line;
+    while (readLine(line)) {
+      size_t length = strtoul(line.c_str(), nullptr, 16);
+      if (length == 0) {
+        readLine(line);
+        break;
+      }
+      for (size_t idx = 0; idx < length; idx++) {
+        char c;
+        if (_client->readBytes(&c, 1) != 1) {
+          return body;
+        }
+        body += c;
+      }
+      readLine(line);
+    }
+  }
+  else if (_size >= 0) {
+    for (int idx = 0; idx < _size; idx++) {
+      char c;
+      if (_client->readBytes(&c, 1) != 1) {
+        break;
+      }
+      body += c;
+    }
+  }
+  return body;
+}
+
+namespace {
+
+  struct PreferencesEntry {
+    bool              blob;
+    std::vector<char> data;
+  };
+
+  std::mutex preferencesMutex;
+  std::map<std::string, PreferencesEntry> preferencesStore;
+  std::set<std::string> preferencesNamespaces;
+  // Free space of the default 20 KB NVS partition once Wi-Fi has stored its data
+  size_t preferencesCapacity = 16 * 1024;
+  uint32_t preferencesFailedWrites = 0;
+
+  // NVS stores every value in 32 byte entries, one for the key and type and the rest for the data
+  size_t entrySize(size_t length) {
+    return 32 + (length + 31) / 32 * 32;
+  }
+
+  // Whether replacing the value of path with length bytes still fits the partition
+  bool fits(const std::string& path, size_t length) {
+    size_t used = 0;
+    for (auto& entry : preferencesStore) {
+      if (entry.first != path) {
+        used += entrySize(entry.second.data.size());
+      }
+    }
+    return used + entrySize(length) <= preferencesCapacity;
+  }
+
+} // namespace
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  if (readOnly && preferencesNamespaces.count(name) == 0) {
+    return false;
+  }
+  preferencesNamespaces.insert(name);
+  _name = name;
+  _open = true;
+  _readOnly = readOnly;
+  return true;
+}
+
+void Preferences::end() {
+  _open = false;
+}
+
+std::string Preferences::path(const char* key) const {
+  return _name + "/" + key;
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  size_t length = strlen(value);
+  if (!_open || _readOnly || length + 1 > STRING_LIMIT || !fits(path(key), length + 1)) {
+    preferencesFailedWrites++;
+    return 0;
+  }
+  preferencesStore[path(key)] = PreferencesEntry{false, std::vector<char>(value, value + length)};
+  return length;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+  return putString(key, value.c_str());
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  auto it = preferencesStore.find(path(key));
+  if (!_open || it == preferencesStore.end() || it->second.blob) {
+    return defaultValue;
+  }
+  return String(it->second.data.data(), it->second.data.size());
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLen) {
+  String stored = getString(key);
+  if (stored.length() + 1 > maxLen) {
+    return 0;
+  }
+  memcpy(value, stored.c_str(), stored.length() + 1);
+  return stored.length() + 1;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  if (!_open || _readOnly || !fits(path(key), length)) {
+    preferencesFailedWrites++;
+    return 0;
+  }
+  const char* bytes = static_cast<const char*>(value);
+  preferencesStore[path(key)] = PreferencesEntry{true, std::vector<char>(bytes, bytes + length)};
+  return length;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  auto it = preferencesStore.find(path(key));
+  return _open && it != preferencesStore.end() && it->second.blob ? it->second.data.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLen) {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  auto it = preferencesStore.find(path(key));
+  if (!_open || it == preferencesStore.end() || !it->second.blob || it->second.data.size() > maxLen) {
+    return 0;
+  }
+  memcpy(buffer, it->second.data.data(), it->second.data.size());
+  return it->second.data.size();
+}
+
+bool Preferences::isKey(const char* key) {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  return _open && preferencesStore.count(path(key)) > 0;
+}
+
+bool Preferences::remove(const char* key) {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  return _open && !_readOnly && preferencesStore.erase(path(key)) > 0;
+}
+
+bool Preferences::clear() {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  if (!_open || _readOnly) {
+    return false;
+  }
+  std::string prefix = _name + "/";
+  for (auto it = preferencesStore.begin(); it != preferencesStore.end();) {
+    it = it->first.compare(0, prefix.size(), prefix) == 0 ? preferencesStore.erase(it) : std::next(it);
+  }
+  return true;
+}
+
+void Preferences::setCapacity(size_t bytes) {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  preferencesCapacity = bytes;
+}
+
+void Preferences::reset() {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  preferencesStore.clear();
+  preferencesNamespaces.clear();
+  preferencesCapacity = 16 * 1024;
+  preferencesFailedWrites = 0;
+}
+
+uint32_t Preferences::getNumFailedWrites() {
+  std::lock_guard<std::mutex> lock(preferencesMutex);
+  return preferencesFailedWrites;
+}
@@ -0,0 +1,335 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <malloc.h>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+#include <time.h>
+
+#include <Arduino.h>
+#include <EasyLogger.h>
+
+#ifndef AUTODARTS_SANITIZED
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* ptr, size_t size);
+}
+#endif
+
+namespace {
+
+  std::atomic<bool> manualClock{false};
+  std::atomic<uint64_t> manualMicros{0};
+  std::atomic<bool> wallClock{true};
+  const std::chrono::steady_clock::time_point startedAt = std::chrono::steady_clock::now();
+
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> frees{0};
+  std::atomic<int64_t> liveBytes{0};
+  std::atomic<int64_t> peakBytes{0};
+  thread_local uint64_t threadAllocationCount = 0;
+
+  // Measured on an ESP32 with Wi-Fi connected and one TLS session open
+  std::atomic<uint32_t> heapSize{160 * 1024};
+  std::atomic<int64_t> heapBaseline{0};
+
+  std::mutex randomMutex;
+  std::mt19937 randomGenerator(1);
+
+  std::mutex logMutex;
+  std::atomic<bool> logOutput{getenv("AUTODARTS_LOG") != nullptr};
+  std::atomic<bool> logCapture{false};
+  std::atomic<uint32_t> logCounts[4];
+  std::string lastLogs[4];
+
+  void* allocate(size_t size) {
+#ifdef AUTODARTS_SANITIZED
+    void* ptr = malloc(size > 0 ? size : 1);
+#else
+    void* ptr = __libc_malloc(size > 0 ? size : 1);
+#endif
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    threadAllocationCount++;
+    int64_t live = liveBytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed) + malloc_usable_size(ptr);
+    int64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return ptr;
+  }
+
+  void release(void* ptr) {
+    if (ptr == nullptr) {
+      return;
+    }
+    frees.fetch_add(1, std::memory_order_relaxed);
+    liveBytes.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+    free(ptr);
+  }
+
+} // namespace
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size);
+  }
+  catch (...) {
+    return nullptr;
+  }
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* ptr) noexcept { release(ptr); }
+void operator delete[](void* ptr) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { release(ptr); }
+
+// ArduinoJson takes the pool of a DynamicJsonDocument from malloc(), so the allocations of the
+// calling thread count malloc() too. Bytes are only tracked for operator new, which keeps the
+// stdio buffers of the host out of the heap figures. The sanitizers replace malloc() themselves.
+#ifndef AUTODARTS_SANITIZED
+extern "C" {
+  void* malloc(size_t size) noexcept {
+    threadAllocationCount++;
+    return __libc_malloc(size);
+  }
+
+  void* calloc(size_t count, size_t size) noexcept {
+    threadAllocationCount++;
+    return __libc_calloc(count, size);
+  }
+
+  void* realloc(void* ptr, size_t size) noexcept {
+    threadAllocationCount++;
+    return __libc_realloc(ptr, size);
+  }
+}
+#endif
+
+extern "C" time_t time(time_t* out) noexcept {
+  time_t now;
+  if (wallClock) {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    now = ts.tv_sec;
+  } else {
+    now = static_cast<time_t>(mock::clockMicros() / 1000000);
+  }
+  if (out) {
+    *out = now;
+  }
+  return now;
+}
+
+namespace mock {
+
+  void setManualClock(bool manual) {
+    if (manual && !manualClock) {
+      manualMicros = clockMicros();
+    }
+    manualClock = manual;
+  }
+
+  bool isManualClock() {
+    return manualClock;
+  }
+
+  void advanceClock(uint32_t ms) {
+    manualMicros += static_cast<uint64_t>(ms) * 1000;
+  }
+
+  void advanceClockMicros(uint32_t us) {
+    manualMicros += us;
+  }
+
+  uint64_t clockMicros() {
+    if (manualClock) {
+      return manualMicros;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startedAt).count();
+  }
+
+  void setWallClock(bool set) {
+    wallClock = set;
+  }
+
+  HeapStats heapStats() {
+    return HeapStats{allocations, frees, liveBytes, peakBytes};
+  }
+
+  uint64_t threadAllocations() {
+    return threadAllocationCount;
+  }
+
+  void resetHeapPeak() {
+    peakBytes = liveBytes.load();
+  }
+
+  void setHeapSize(uint32_t bytes) {
+    heapSize = bytes;
+    heapBaseline = liveBytes.load();
+    resetHeapPeak();
+  }
+
+  void setLogOutput(bool enabled) {
+    logOutput = enabled;
+  }
+
+  void setLogCapture(bool enabled) {
+    logCapture = enabled;
+  }
+
+  bool isLogFormatted() {
+    return logOutput || logCapture;
+  }
+
+  void log(LogLevel level, const char* tag, const std::string& message) {
+    static const char* names[] = { "E", "W", "I", "D" };
+    logCounts[level]++;
+    if (!isLogFormatted()) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (logCapture) {
+      lastLogs[level] = message;
+    }
+    if (logOutput) {
+      std::cerr << "[" << names[level] << "][" << tag << "] " << message << std::endl;
+    }
+  }
+
+  uint32_t logCount(LogLevel level) {
+    return logCounts[level];
+  }
+
+  std::string lastLog(LogLevel level) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    return lastLogs[level];
+  }
+
+  void resetLog() {
+    std::lock_guard<std::mutex> lock(logMutex);
+    for (uint8_t idx = 0; idx < 4; idx++) {
+      logCounts[idx] = 0;
+      lastLogs[idx].clear();
+    }
+  }
+
+} // mock
+
+unsigned long millis() {
+  return static_cast<unsigned long>(static_cast<uint32_t>(mock::clockMicros() / 1000));
+}
+
+unsigned long micros() {
+  return static_cast<unsigned long>(static_cast<uint32_t>(mock::clockMicros()));
+}
+
+void delay(uint32_t ms) {
+  if (mock::isManualClock()) {
+    mock::advanceClock(ms);
+  }
+  else {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+}
+
+void delayMicroseconds(uint32_t us) {
+  if (mock::isManualClock()) {
+    mock::advanceClockMicros(us);
+  }
+  else {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  }
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+long random(long max) {
+  std::lock_guard<std::mutex> lock(randomMutex);
+  return max > 0 ? static_cast<long>(randomGenerator() % static_cast<unsigned long>(max)) : 0;
+}
+
+long random(long min, long max) {
+  return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+  std::lock_guard<std::mutex> lock(randomMutex);
+  randomGenerator.seed(seed);
+}
+
+// Waits a moment for data, see Stream::timedRead()
+void Stream::wait() {
+  if (mock::isManualClock()) {
+    mock::advanceClock(1);
+  }
+  else {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getHeapSize() {
+  return heapSize;
+}
+
+uint32_t EspClass::getFreeHeap() {
+  int64_t used = liveBytes - heapBaseline;
+  return used < static_cast<int64_t>(heapSize) ? heapSize - std::max<int64_t>(used, 0) : 0;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  int64_t used = peakBytes - heapBaseline;
+  return used < static_cast<int64_t>(heapSize) ? heapSize - std::max<int64_t>(used, 0) : 0;
+}
+
+// The largest block is typically a bit over half of the free heap on a running ESP32
+uint32_t EspClass::getMaxAllocHeap() {
+  return getFreeHeap() / 2;
+}
+
+struct MockTask {
+  uint32_t stackSize;
+};
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char*, uint32_t stackSize, void* parameter,
+                                   UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+  // Handles are only used to query the stack, so they are recycled instead of freed
+  static MockTask tasks[32];
+  static std::atomic<uint32_t> next{0};
+  MockTask* task = &tasks[next++ % 32];
+  task->stackSize = stackSize;
+  if (handle != nullptr) {
+    *handle = task;
+  }
+  std::thread(function, parameter).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackSize, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(function, name, stackSize, parameter, priority, handle, 0);
+}
+
+void vTaskDelete(TaskHandle_t) {
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+// The stack of a host thread is not measured
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  return task != nullptr ? task->stackSize : 0;
+}
@@ -0,0 +1,65 @@
+#ifndef MockRuntime_h_
+#define MockRuntime_h_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Controls of the host stand-ins that have no counterpart on the ESP32: the clock,
+// the heap counters behind operator new and the captured log output.
+namespace mock {
+
+  // By default millis() and micros() follow the steady clock. A manual clock only moves
+  // with advanceClock() and delay(), which makes simulations deterministic. Only use it
+  // while a single thread calls into the library.
+  void setManualClock(bool manual);
+  bool isManualClock();
+  void advanceClock(uint32_t ms);
+  void advanceClockMicros(uint32_t us);
+  uint64_t clockMicros();
+
+  // By default time() is the wall clock of the host. Without it time() counts the seconds
+  // of the clock above, like an ESP32 before SNTP has set its clock.
+  void setWallClock(bool set);
+
+  // Counted by the global operator new and delete of the host build
+  struct HeapStats {
+    uint64_t allocations;
+    uint64_t frees;
+    int64_t  liveBytes;
+    int64_t  peakBytes;
+  };
+
+  HeapStats heapStats();
+
+  // Allocations made by the calling thread only, by operator new or malloc().
+  // Builds with AUTODARTS_SANITIZE only count operator new.
+  uint64_t threadAllocations();
+
+  // Lets the next peak start at the current live bytes
+  void resetHeapPeak();
+
+  // Size of the simulated heap behind ESP.getFreeHeap(), the default matches the DRAM
+  // that is left to an Arduino sketch on an ESP32 with Wi-Fi and TLS running
+  void setHeapSize(uint32_t bytes);
+
+  enum LogLevel : uint8_t {
+    LOG_ERROR   = 0,
+    LOG_WARNING = 1,
+    LOG_INFO    = 2,
+    LOG_DEBUG   = 3,
+  };
+
+  // Log lines are counted per level, printed to stderr if enabled by setLogOutput()
+  // or the AUTODARTS_LOG environment variable and kept if capturing
+  void setLogOutput(bool enabled);
+  void setLogCapture(bool enabled);
+  bool isLogFormatted();
+  void log(LogLevel level, const char* tag, const std::string& message);
+  uint32_t logCount(LogLevel level);
+  std::string lastLog(LogLevel level);
+  void resetLog();
+
+} // mock
+
+#endif // MockRuntime_h_
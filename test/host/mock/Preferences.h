@@ -0,0 +1,51 @@
+#ifndef Preferences_h_
+#define Preferences_h_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+// Host stand-in for the ESP32 NVS preferences. All instances share one store, so values
+// survive a new instance like they survive a reboot. The size limits are the ones of NVS:
+// strings up to 4000 bytes, and all values together up to the free space, see setCapacity().
+class Preferences {
+public:
+  static const size_t STRING_LIMIT = 4000;
+
+  bool begin(const char* name, bool readOnly = false);
+  void end();
+
+  size_t putString(const char* key, const char* value);
+  size_t putString(const char* key, const String& value);
+  String getString(const char* key, const String& defaultValue = String());
+  size_t getString(const char* key, char* value, size_t maxLen);
+
+  size_t putBytes(const char* key, const void* value, size_t length);
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buffer, size_t maxLen);
+
+  bool isKey(const char* key);
+  bool remove(const char* key);
+  bool clear();
+
+  // Free space of the partition in bytes, 16 KB by default
+  static void setCapacity(size_t bytes);
+
+  // Drops all namespaces
+  static void reset();
+
+  // Number of failed writes since the last reset()
+  static uint32_t getNumFailedWrites();
+
+private:
+  std::string path(const char* key) const;
+
+  std::string _name;
+  bool _open = false;
+  bool _readOnly = true;
+};
+
+#endif // Preferences_h_
@@ -0,0 +1,67 @@
+#ifndef Print_h_
+#define Print_h_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print {
+public:
+  virtual ~Print() = default;
+
+  virtual size_t write(uint8_t c) = 0;
+
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t count = 0;
+    while (size-- > 0 && write(*buffer++) == 1) {
+      count++;
+    }
+    return count;
+  }
+
+  size_t write(const char* value) {
+    return value != nullptr ? write(reinterpret_cast<const uint8_t*>(value), strlen(value)) : 0;
+  }
+
+  size_t write(const char* buffer, size_t size) {
+    return write(reinterpret_cast<const uint8_t*>(buffer), size);
+  }
+
+  size_t print(const __FlashStringHelper* value) { return write(reinterpret_cast<const char*>(value)); }
+  size_t print(const String& value) { return write(value.c_str(), value.length()); }
+  size_t print(const char* value) { return write(value); }
+  size_t print(char value) { return write(static_cast<uint8_t>(value)); }
+  size_t print(unsigned char value, int base = DEC) { return print(static_cast<unsigned long long>(value), base); }
+  size_t print(int value, int base = DEC) { return print(static_cast<long long>(value), base); }
+  size_t print(unsigned int value, int base = DEC) { return print(static_cast<unsigned long long>(value), base); }
+  size_t print(long value, int base = DEC) { return print(static_cast<long long>(value), base); }
+  size_t print(unsigned long value, int base = DEC) { return print(static_cast<unsigned long long>(value), base); }
+  size_t print(long long value, int base = DEC) { return print(String(value, base)); }
+  size_t print(unsigned long long value, int base = DEC) { return print(String(value, base)); }
+  size_t print(double value, int digits = 2) { return print(String(value, digits)); }
+
+  size_t println() { return write("\r\n"); }
+
+  template <typename T>
+  size_t println(const T& value) {
+    size_t count = print(value);
+    return count + println();
+  }
+
+  template <typename T>
+  size_t println(const T& value, int format) {
+    size_t count = print(value, format);
+    return count + println();
+  }
+
+  virtual void flush() {}
+};
+
+#endif // Print_h_
@@ -0,0 +1,133 @@
+#ifndef Stream_h_
+#define Stream_h_
+
+#include "MockRuntime.h"
+#include "Print.h"
+
+unsigned long millis();
+
+// Arduino Stream with the timed reads of the ESP32 core. While waiting for data the
+// manual clock of the host build moves on, so timeouts also expire in simulations.
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  unsigned long getTimeout() const { return _timeout; }
+
+  bool find(const char* target) { return findUntil(target, nullptr); }
+  bool find(const char* target, size_t length) { return findUntil(target, length, nullptr, 0); }
+  bool find(char target) { return find(&target, 1); }
+
+  bool findUntil(const char* target, const char* terminator) {
+    return findUntil(target, strlen(target), terminator, terminator != nullptr ? strlen(terminator) : 0);
+  }
+
+  // Returns true if target is found, false if terminator is found first or the stream times out
+  bool findUntil(const char* target, size_t targetLength, const char* terminator, size_t terminatorLength) {
+    size_t matched = 0;
+    size_t terminated = 0;
+    if (targetLength == 0) {
+      return true;
+    }
+    while (true) {
+      int c = timedRead();
+      if (c < 0) {
+        return false;
+      }
+      matched = advance(target, targetLength, matched, c);
+      if (matched == targetLength) {
+        return true;
+      }
+      if (terminatorLength > 0) {
+        terminated = advance(terminator, terminatorLength, terminated, c);
+        if (terminated == terminatorLength) {
+          return false;
+        }
+      }
+    }
+  }
+
+  size_t readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0) {
+        break;
+      }
+      buffer[count++] = static_cast<char>(c);
+    }
+    return count;
+  }
+
+  size_t readBytes(uint8_t* buffer, size_t length) {
+    return readBytes(reinterpret_cast<char*>(buffer), length);
+  }
+
+  size_t readBytesUntil(char terminator, char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0 || c == terminator) {
+        break;
+      }
+      buffer[count++] = static_cast<char>(c);
+    }
+    return count;
+  }
+
+  String readString() {
+    String value;
+    for (int c = timedRead(); c >= 0; c = timedRead()) {
+      value += static_cast<char>(c);
+    }
+    return value;
+  }
+
+protected:
+  int timedRead() {
+    unsigned long start = millis();
+    do {
+      int c = read();
+      if (c >= 0) {
+        return c;
+      }
+      wait();
+    } while (millis() - start < _timeout);
+    return -1;
+  }
+
+  int timedPeek() {
+    unsigned long start = millis();
+    do {
+      int c = peek();
+      if (c >= 0) {
+        return c;
+      }
+      wait();
+    } while (millis() - start < _timeout);
+    return -1;
+  }
+
+  unsigned long _timeout = 1000;
+
+private:
+  static void wait();
+
+  // Naive matcher like the Arduino core, good enough for the short separators used here
+  static size_t advance(const char* pattern, size_t length, size_t matched, int c) {
+    if (pattern[matched] == c) {
+      return matched + 1;
+    }
+    for (size_t retry = matched; retry > 0; retry--) {
+      if (memcmp(pattern, pattern + matched - retry + 1, retry - 1) == 0 && pattern[retry - 1] == c) {
+        return retry;
+      }
+    }
+    return 0;
+  }
+};
+
+#endif // Stream_h_
@@ -0,0 +1,4 @@
+#ifndef StreamUtils_h_
+#define StreamUtils_h_
+
+#endif // StreamUtils_h_
@@ -0,0 +1,201 @@
+#ifndef WString_h_
+#define WString_h_
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#define PSTR(string_literal) (string_literal)
+#define FPSTR(pstr_pointer) (reinterpret_cast<const __FlashStringHelper*>(pstr_pointer))
+
+// Arduino String on top of std::string, so allocations go through the counted operator new
+class String {
+public:
+  String() = default;
+  String(const String&) = default;
+  String(String&&) = default;
+  String& operator=(const String&) = default;
+  String& operator=(String&&) = default;
+
+  String(const char* value) : _value(value != nullptr ? value : "") {}
+  String(const char* value, size_t length) : _value(value, length) {}
+  String(const __FlashStringHelper* value) : String(reinterpret_cast<const char*>(value)) {}
+  explicit String(char value) : _value(1, value) {}
+  explicit String(unsigned char value, unsigned char base = 10) : String(static_cast<unsigned long long>(value), base) {}
+  explicit String(int value, unsigned char base = 10) : String(static_cast<long long>(value), base) {}
+  explicit String(unsigned int value, unsigned char base = 10) : String(static_cast<unsigned long long>(value), base) {}
+  explicit String(long value, unsigned char base = 10) : String(static_cast<long long>(value), base) {}
+  explicit String(unsigned long value, unsigned char base = 10) : String(static_cast<unsigned long long>(value), base) {}
+  explicit String(long long value, unsigned char base = 10) {
+    if (value < 0 && base == 10) {
+      _value = "-" + format(static_cast<unsigned long long>(-(value + 1)) + 1, base);
+    }
+    else {
+      _value = format(static_cast<unsigned long long>(value), base);
+    }
+  }
+  explicit String(unsigned long long value, unsigned char base = 10) : _value(format(value, base)) {}
+  explicit String(float value, unsigned int decimals = 2) : String(static_cast<double>(value), decimals) {}
+  explicit String(double value, unsigned int decimals = 2) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    _value = buffer;
+  }
+
+  String& operator=(const char* value) {
+    _value = value != nullptr ? value : "";
+    return *this;
+  }
+
+  String& operator=(const __FlashStringHelper* value) {
+    return *this = reinterpret_cast<const char*>(value);
+  }
+
+  const char* c_str() const { return _value.c_str(); }
+  // unsigned int on the ESP32, which is size_t there. ArduinoJson adapts strings by that type.
+  size_t length() const { return _value.length(); }
+  bool isEmpty() const { return _value.empty(); }
+  void clear() { _value.clear(); }
+  bool reserve(unsigned int size) { _value.reserve(size); return true; }
+
+  char* begin() { return &_value[0]; }
+  char* end() { return &_value[0] + _value.length(); }
+  const char* begin() const { return _value.c_str(); }
+  const char* end() const { return _value.c_str() + _value.length(); }
+
+  char operator[](unsigned int idx) const { return idx < _value.length() ? _value[idx] : '\0'; }
+  char& operator[](unsigned int idx) { return _value[idx]; }
+  char charAt(unsigned int idx) const { return (*this)[idx]; }
+  void setCharAt(unsigned int idx, char c) { if (idx < _value.length()) _value[idx] = c; }
+
+  bool concat(const String& value) { _value += value._value; return true; }
+  bool concat(const char* value) { if (value != nullptr) _value += value; return value != nullptr; }
+  bool concat(const char* value, unsigned int length) { _value.append(value, length); return true; }
+  bool concat(const __FlashStringHelper* value) { return concat(reinterpret_cast<const char*>(value)); }
+  bool concat(char value) { _value += value; return true; }
+  bool concat(unsigned char value) { return concat(String(value)); }
+  bool concat(int value) { return concat(String(value)); }
+  bool concat(unsigned int value) { return concat(String(value)); }
+  bool concat(long value) { return concat(String(value)); }
+  bool concat(unsigned long value) { return concat(String(value)); }
+  bool concat(long long value) { return concat(String(value)); }
+  bool concat(unsigned long long value) { return concat(String(value)); }
+  bool concat(float value) { return concat(String(value)); }
+  bool concat(double value) { return concat(String(value)); }
+
+  template <typename T>
+  String& operator+=(const T& value) {
+    concat(value);
+    return *this;
+  }
+
+  int compareTo(const String& other) const { return _value.compare(other._value); }
+  bool equals(const String& other) const { return _value == other._value; }
+  bool equals(const char* other) const { return _value == (other != nullptr ? other : ""); }
+  bool equalsIgnoreCase(const String& other) const {
+    if (_value.length() != other._value.length()) {
+      return false;
+    }
+    for (size_t idx = 0; idx < _value.length(); idx++) {
+      if (tolower(static_cast<unsigned char>(_value[idx])) != tolower(static_cast<unsigned char>(other._value[idx]))) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool startsWith(const String& prefix) const { return _value.compare(0, prefix._value.length(), prefix._value) == 0; }
+  bool endsWith(const String& suffix) const {
+    return _value.length() >= suffix._value.length() &&
+           _value.compare(_value.length() - suffix._value.length(), suffix._value.length(), suffix._value) == 0;
+  }
+
+  int indexOf(char c, unsigned int from = 0) const { return position(_value.find(c, from)); }
+  int indexOf(const String& value, unsigned int from = 0) const { return position(_value.find(value._value, from)); }
+  int lastIndexOf(char c) const { return position(_value.rfind(c)); }
+  int lastIndexOf(const String& value) const { return position(_value.rfind(value._value)); }
+
+  String substring(unsigned int from) const { return from < _value.length() ? String(_value.substr(from).c_str()) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+      std::swap(from, to);
+    }
+    return from < _value.length() ? String(_value.substr(from, to - from).c_str()) : String();
+  }
+
+  void replace(const String& find, const String& replacement) {
+    if (find._value.empty()) {
+      return;
+    }
+    for (size_t pos = _value.find(find._value); pos != std::string::npos; pos = _value.find(find._value, pos + replacement._value.length())) {
+      _value.replace(pos, find._value.length(), replacement._value);
+    }
+  }
+  void remove(unsigned int idx) { if (idx < _value.length()) _value.erase(idx); }
+  void remove(unsigned int idx, unsigned int count) { if (idx < _value.length()) _value.erase(idx, count); }
+  void toLowerCase() { for (char& c : _value) c = tolower(static_cast<unsigned char>(c)); }
+  void toUpperCase() { for (char& c : _value) c = toupper(static_cast<unsigned char>(c)); }
+  void trim() {
+    size_t begin = _value.find_first_not_of(" \t\r\n");
+    size_t end = _value.find_last_not_of(" \t\r\n");
+    _value = begin == std::string::npos ? std::string() : _value.substr(begin, end - begin + 1);
+  }
+
+  long toInt() const { return strtol(_value.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(_value.c_str(), nullptr); }
+  double toDouble() const { return strtod(_value.c_str(), nullptr); }
+
+  bool operator==(const String& other) const { return equals(other); }
+  bool operator==(const char* other) const { return equals(other); }
+  bool operator!=(const String& other) const { return !equals(other); }
+  bool operator!=(const char* other) const { return !equals(other); }
+  bool operator<(const String& other) const { return _value < other._value; }
+
+private:
+  static std::string format(unsigned long long value, unsigned char base) {
+    if (base < 2 || base > 36) {
+      base = 10;
+    }
+    char buffer[72];
+    char* out = buffer + sizeof(buffer) - 1;
+    *out = '\0';
+    do {
+      uint8_t digit = value % base;
+      *--out = digit < 10 ? '0' + digit : 'a' + digit - 10;
+      value /= base;
+    } while (value > 0);
+    return out;
+  }
+
+  static int position(size_t pos) {
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+  }
+
+  std::string _value;
+};
+
+inline bool operator==(const char* lhs, const String& rhs) { return rhs.equals(lhs); }
+inline bool operator!=(const char* lhs, const String& rhs) { return !rhs.equals(lhs); }
+
+template <typename T>
+inline String operator+(const String& lhs, const T& rhs) {
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+inline String operator+(const char* lhs, const String& rhs) {
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+inline String operator+(const __FlashStringHelper* lhs, const String& rhs) {
+  return reinterpret_cast<const char*>(lhs) + rhs;
+}
+
+#endif // WString_h_
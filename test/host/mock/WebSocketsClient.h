@@ -0,0 +1,179 @@
+#ifndef WebSocketsClient_h_
+#define WebSocketsClient_h_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "FakeWebSocketServer.h"
+#include "WebSockets.h"
+
+// Host stand-in for the links2004 WebSocketsClient, connected to a mock::FakeWebSocketServer.
+// Like the real client it connects from loop(), retries after the reconnect interval,
+// raises WStype_DISCONNECTED synchronously from disconnect() and disconnects when destroyed.
+class WebSocketsClient {
+public:
+  typedef std::function<void(WStype_t type, uint8_t* payload, size_t length)> WebSocketClientEvent;
+
+  WebSocketsClient() = default;
+
+  ~WebSocketsClient() {
+    disconnect();
+  }
+
+  WebSocketsClient(const WebSocketsClient&) = delete;
+  WebSocketsClient& operator=(const WebSocketsClient&) = delete;
+
+  void begin(const String& host, uint16_t port, const char* url = "/", const char* = "arduino") {
+    _address = std::string(host.c_str()) + ":" + std::to_string(port);
+    _url = url;
+    _begun = true;
+    _attempted = false;
+  }
+
+  void beginSSL(const char* host, uint16_t port, const char* url = "/", const char* = "", const char* protocol = "arduino") {
+    begin(String(host), port, url, protocol);
+  }
+
+  void beginSslWithCA(const char* host, uint16_t port, const char* url = "/", const char* = nullptr, const char* protocol = "arduino") {
+    begin(String(host), port, url, protocol);
+  }
+
+  void beginSslWithBundle(const char* host, uint16_t port, const char* url = "/", const uint8_t* = nullptr, const char* protocol = "arduino") {
+    begin(String(host), port, url, protocol);
+  }
+
+  void onEvent(WebSocketClientEvent callback) {
+    _callback = callback;
+  }
+
+  void setReconnectInterval(unsigned long time) {
+    _reconnectInterval = time;
+  }
+
+  void loop() {
+    if (!_begun) {
+      return;
+    }
+    switch (_state) {
+      case State::IDLE:
+        if (_attempted && millis() - _lastAttempt < _reconnectInterval) {
+          return;
+        }
+        _attempted = true;
+        _lastAttempt = millis();
+        _connection = mock::FakeWebSocketServer::connect(_address, _handshakeDelay);
+        if (_connection) {
+          // The real client allocates a buffer per frame, here one buffer is reserved per
+          // connection so that allocation counts only show the allocations of the library.
+          // Like the real client nothing is allocated before a connection is made.
+          _buffer.reserve(4096);
+          _state = State::HANDSHAKE;
+          _handshakeAt = millis();
+        }
+        break;
+      case State::HANDSHAKE:
+        if (millis() - _handshakeAt >= _handshakeDelay) {
+          _state = State::CONNECTED;
+          raise(WStype_CONNECTED, _url);
+        }
+        break;
+      case State::CONNECTED:
+        deliver();
+        break;
+    }
+  }
+
+  void disconnect() {
+    State state = _state;
+    _state = State::IDLE;
+    if (_connection) {
+      std::lock_guard<std::mutex> lock(_connection->mutex);
+      _connection->closed = true;
+    }
+    _connection.reset();
+    if (state == State::CONNECTED) {
+      raise(WStype_DISCONNECTED, std::string());
+    }
+  }
+
+  bool isConnected() const {
+    return _state == State::CONNECTED;
+  }
+
+  bool sendTXT(const char* payload, size_t length = 0) {
+    if (_state != State::CONNECTED) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(_connection->mutex);
+    if (_connection->closed) {
+      return false;
+    }
+    _connection->sent.emplace_back(payload, length > 0 ? length : strlen(payload));
+    return true;
+  }
+
+  bool sendTXT(const String& payload) {
+    return sendTXT(payload.c_str(), payload.length());
+  }
+
+private:
+  enum class State {
+    IDLE,
+    HANDSHAKE,
+    CONNECTED,
+  };
+
+  // Copies one frame to the receive buffer
+  void deliver() {
+    bool closed;
+    {
+      std::lock_guard<std::mutex> lock(_connection->mutex);
+      closed = _connection->closed;
+      if (!closed && _connection->next < _connection->inbox.size()) {
+        const std::string& frame = _connection->inbox[_connection->next++];
+        _buffer.assign(frame.begin(), frame.end());
+        _buffer.push_back('\0');
+      }
+      else {
+        _buffer.clear();
+      }
+    }
+    if (closed) {
+      _state = State::IDLE;
+      _connection.reset();
+      raise(WStype_DISCONNECTED, std::string());
+    }
+    else if (!_buffer.empty()) {
+      if (_callback) {
+        _callback(WStype_TEXT, reinterpret_cast<uint8_t*>(_buffer.data()), _buffer.size() - 1);
+      }
+    }
+  }
+
+  void raise(WStype_t type, const std::string& payload) {
+    if (_callback) {
+      std::vector<char> copy(payload.begin(), payload.end());
+      copy.push_back('\0');
+      _callback(type, reinterpret_cast<uint8_t*>(copy.data()), payload.length());
+    }
+  }
+
+  std::string _address;
+  std::string _url;
+  WebSocketClientEvent _callback;
+  std::shared_ptr<mock::WebSocketConnection> _connection;
+  std::vector<char> _buffer;
+  State _state = State::IDLE;
+  bool _begun = false;
+  bool _attempted = false;
+  unsigned long _reconnectInterval = 500;
+  unsigned long _lastAttempt = 0;
+  unsigned long _handshakeAt = 0;
+  uint32_t _handshakeDelay = 0;
+};
+
+#endif // WebSocketsClient_h_
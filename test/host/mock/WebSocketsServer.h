@@ -0,0 +1,150 @@
+#ifndef WebSocketsServer_h_
+#define WebSocketsServer_h_
+
+#include <array>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "WebSockets.h"
+
+#define WEBSOCKETS_SERVER_CLIENT_MAX 5
+
+// Host stand-in for the links2004 WebSocketsServer. Subscribers are simulated with
+// mockConnect() and mockDisconnect(), whose events are raised by the next loop(), and
+// everything sent is captured per client. A client accepts a limited number of frames
+// per loop() to simulate a full TCP send buffer.
+class WebSocketsServer {
+public:
+  typedef std::function<void(uint8_t num, WStype_t type, uint8_t* payload, size_t length)> WebSocketServerEvent;
+
+  explicit WebSocketsServer(uint16_t port) : _port(port) {
+    servers()[port] = this;
+  }
+
+  ~WebSocketsServer() {
+    if (servers()[_port] == this) {
+      servers().erase(_port);
+    }
+  }
+
+  WebSocketsServer(const WebSocketsServer&) = delete;
+  WebSocketsServer& operator=(const WebSocketsServer&) = delete;
+
+  // Server listening on the port, for tests that cannot reach the instance
+  static WebSocketsServer* mockAt(uint16_t port) {
+    auto it = servers().find(port);
+    return it != servers().end() ? it->second : nullptr;
+  }
+
+  void begin() {
+    _running = true;
+  }
+
+  void close() {
+    _running = false;
+    for (Client& client : _clients) {
+      client.connected = false;
+      client.pending = Pending::NONE;
+    }
+  }
+
+  void onEvent(WebSocketServerEvent callback) {
+    _callback = callback;
+  }
+
+  void loop() {
+    if (!_running) {
+      return;
+    }
+    for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++) {
+      Client& client = _clients[num];
+      client.sentThisLoop = 0;
+      Pending pending = client.pending;
+      client.pending = Pending::NONE;
+      if (pending == Pending::CONNECT && !client.connected) {
+        client.connected = true;
+        raise(num, WStype_CONNECTED);
+      }
+      else if (pending == Pending::DISCONNECT && client.connected) {
+        client.connected = false;
+        raise(num, WStype_DISCONNECTED);
+      }
+    }
+  }
+
+  bool sendTXT(uint8_t num, const char* payload, size_t length = 0) {
+    if (num >= WEBSOCKETS_SERVER_CLIENT_MAX || !_clients[num].connected) {
+      return false;
+    }
+    Client& client = _clients[num];
+    if (client.capacity > 0 && client.sentThisLoop >= client.capacity) {
+      return false;
+    }
+    client.sentThisLoop++;
+    client.sent.emplace_back(payload, length > 0 ? length : strlen(payload));
+    return true;
+  }
+
+  bool sendTXT(uint8_t num, const String& payload) {
+    return sendTXT(num, payload.c_str(), payload.length());
+  }
+
+  uint16_t getPort() const {
+    return _port;
+  }
+
+  void mockConnect(uint8_t num) {
+    _clients[num].pending = Pending::CONNECT;
+  }
+
+  void mockDisconnect(uint8_t num) {
+    _clients[num].pending = Pending::DISCONNECT;
+  }
+
+  // Frames accepted per loop(), 0 for no limit
+  void mockSetCapacity(uint8_t num, uint32_t frames) {
+    _clients[num].capacity = frames;
+  }
+
+  std::vector<std::string>& mockSent(uint8_t num) {
+    return _clients[num].sent;
+  }
+
+private:
+  enum class Pending {
+    NONE,
+    CONNECT,
+    DISCONNECT,
+  };
+
+  struct Client {
+    bool                     connected = false;
+    Pending                  pending = Pending::NONE;
+    uint32_t                 capacity = 0;
+    uint32_t                 sentThisLoop = 0;
+    std::vector<std::string> sent;
+  };
+
+  static std::map<uint16_t, WebSocketsServer*>& servers() {
+    static std::map<uint16_t, WebSocketsServer*> servers;
+    return servers;
+  }
+
+  void raise(uint8_t num, WStype_t type) {
+    if (_callback) {
+      uint8_t payload[1] = { 0 };
+      _callback(num, type, payload, 0);
+    }
+  }
+
+  uint16_t _port;
+  bool _running = false;
+  WebSocketServerEvent _callback;
+  std::array<Client, WEBSOCKETS_SERVER_CLIENT_MAX> _clients;
+};
+
+#endif // WebSocketsServer_h_
@@ -0,0 +1,50 @@
+#ifndef WiFiClient_h_
+#define WiFiClient_h_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+// TCP connection to the mock::FakeHttpServer. Received bytes carry their arrival time
+// and only become available once millis() reaches it.
+class WiFiClient : public Stream {
+public:
+  WiFiClient() = default;
+  virtual ~WiFiClient() = default;
+
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+
+  virtual int connect(const char* host, uint16_t port);
+  virtual void stop();
+  virtual uint8_t connected();
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+  // Called by HTTPClient to deliver the response of the server
+  void mockReceive(const std::string& data, uint32_t at);
+
+  const std::string& mockSent() const {
+    return _sent;
+  }
+
+private:
+  struct Segment {
+    std::string data;
+    uint32_t    at;
+  };
+
+  std::vector<Segment> _segments;
+  size_t _offset = 0;
+  std::string _sent;
+  uint32_t _generation = 0;
+};
+
+#endif // WiFiClient_h_
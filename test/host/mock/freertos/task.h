@@ -0,0 +1,20 @@
+#ifndef task_h_
+#define task_h_
+
+#include "FreeRTOS.h"
+
+// Tasks run on detached std::threads. A task ends by returning after vTaskDelete(nullptr),
+// deleting other tasks is not supported.
+struct MockTask;
+typedef MockTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackSize, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackSize, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* handle);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#endif // task_h_
@@ -0,0 +1,93 @@
+#ifndef Bench_h_
+#define Bench_h_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <MockRuntime.h>
+
+// Helpers of the host benchmarks. Every benchmark accepts --quick, which is what ctest
+// runs to keep them working; the figures of a quick run are not meaningful.
+namespace bench {
+
+  inline bool isQuick(int argc, char** argv) {
+    for (int idx = 1; idx < argc; idx++) {
+      if (strcmp(argv[idx], "--quick") == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  inline uint64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Collects one duration per operation
+  class Samples {
+  public:
+    void reserve(size_t count) {
+      _values.reserve(count);
+    }
+
+    void add(uint64_t nanos) {
+      _values.push_back(nanos);
+    }
+
+    size_t size() const {
+      return _values.size();
+    }
+
+    uint64_t total() const {
+      uint64_t sum = 0;
+      for (uint64_t value : _values) {
+        sum += value;
+      }
+      return sum;
+    }
+
+    double mean() const {
+      return _values.empty() ? 0 : static_cast<double>(total()) / _values.size();
+    }
+
+    uint64_t percentile(double p) {
+      if (_values.empty()) {
+        return 0;
+      }
+      std::sort(_values.begin(), _values.end());
+      size_t idx = std::min(_values.size() - 1, static_cast<size_t>(p / 100 * _values.size()));
+      return _values[idx];
+    }
+
+  private:
+    std::vector<uint64_t> _values;
+  };
+
+  // Allocations made by the calling thread while it is in scope
+  class AllocationCounter {
+  public:
+    AllocationCounter() : _start(mock::threadAllocations()) {}
+
+    uint64_t count() const {
+      return mock::threadAllocations() - _start;
+    }
+
+  private:
+    uint64_t _start;
+  };
+
+  inline void header(const char* title) {
+    printf("\n%s\n", title);
+    for (size_t idx = 0; idx < strlen(title); idx++) {
+      putchar('-');
+    }
+    putchar('\n');
+  }
+
+} // bench
+
+#endif // Bench_h_
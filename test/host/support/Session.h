@@ -0,0 +1,150 @@
+#ifndef Session_h_
+#define Session_h_
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Synthetic board manager sessions for the host tests and benchmarks. The frames have the
+// shape of the /api/events messages of the board manager (state, cam_state, cam_stats), the
+// timing follows a player throwing three darts per turn: one state per dart ~2.5 s apart,
+// takeout started and finished, and cam_stats of every camera once per second. Sessions are
+// generated from a seed and are not recordings of a real board.
+namespace session {
+
+  struct Frame {
+    uint32_t    at;   // ms since the start of the session
+    std::string json;
+  };
+
+  struct Dart {
+    int   number;
+    int   multiplier;
+    float x;
+    float y;
+  };
+
+  inline std::string segmentName(const Dart& dart) {
+    if (dart.number == 0) {
+      return "Outside";
+    }
+    if (dart.number == 25) {
+      return dart.multiplier == 2 ? "Bull" : "25";
+    }
+    const char* prefix = dart.multiplier == 3 ? "T" : dart.multiplier == 2 ? "D" : "S";
+    return prefix + std::to_string(dart.number);
+  }
+
+  inline std::string bed(const Dart& dart) {
+    switch (dart.multiplier) {
+      case 3:  return "Triple";
+      case 2:  return "Double";
+      case 0:  return "Outside";
+      default: return dart.x > 0 ? "SingleOuter" : "SingleInner";
+    }
+  }
+
+  inline std::string state(const char* status, const char* event, const std::vector<Dart>& darts, bool running = true) {
+    char coords[64];
+    std::string json = "{\"type\":\"state\",\"data\":{\"connected\":true,\"running\":";
+    json += running ? "true" : "false";
+    json += ",\"status\":\"" + std::string(status) + "\",\"event\":\"" + event + "\",\"numThrows\":" + std::to_string(darts.size());
+    json += ",\"throws\":[";
+    for (size_t idx = 0; idx < darts.size(); idx++) {
+      const Dart& dart = darts[idx];
+      snprintf(coords, sizeof(coords), "{\"x\":%.6f,\"y\":%.6f}", dart.x, dart.y);
+      json += idx > 0 ? "," : "";
+      json += "{\"segment\":{\"name\":\"" + segmentName(dart) + "\",\"number\":" + std::to_string(dart.number) +
+              ",\"bed\":\"" + bed(dart) + "\",\"multiplier\":" + std::to_string(dart.multiplier) + "},\"coords\":" + coords + "}";
+    }
+    json += "]}}";
+    return json;
+  }
+
+  inline std::string camState(bool isOpened, bool isRunning) {
+    return std::string("{\"type\":\"cam_state\",\"data\":{\"isOpened\":") + (isOpened ? "true" : "false") +
+           ",\"isRunning\":" + (isRunning ? "true" : "false") + "}}";
+  }
+
+  inline std::string camStats(int id, int fps, int width = 1280, int height = 720) {
+    return "{\"type\":\"cam_stats\",\"data\":{\"id\":" + std::to_string(id) + ",\"fps\":" + std::to_string(fps) +
+           ",\"resolution\":{\"width\":" + std::to_string(width) + ",\"height\":" + std::to_string(height) + "}}}";
+  }
+
+  class Generator {
+  public:
+    explicit Generator(uint32_t seed, int numCameras = 3) : _random(seed), _numCameras(numCameras) {}
+
+    Dart dart() {
+      Dart dart;
+      int roll = uniform(0, 99);
+      dart.number = roll < 3 ? 0 : roll < 8 ? 25 : uniform(1, 20);
+      dart.multiplier = dart.number == 0 ? 0 : dart.number == 25 ? uniform(1, 2) : weighted();
+      dart.x = uniform(-1000, 1000) / 1000.0f;
+      dart.y = uniform(-1000, 1000) / 1000.0f;
+      return dart;
+    }
+
+    // Frames of a session with the given number of turns, sorted by time
+    std::vector<Frame> generate(uint32_t turns) {
+      std::vector<Frame> frames;
+      uint32_t now = 0;
+      frames.push_back(Frame{now, camState(true, true)});
+      frames.push_back(Frame{now, state("Throw", "Started", {})});
+
+      uint32_t nextStats = 1000;
+      auto advance = [&](uint32_t ms) {
+        now += ms;
+        while (nextStats <= now) {
+          for (int id = 0; id < _numCameras; id++) {
+            frames.push_back(Frame{nextStats, camStats(id, fps())});
+          }
+          nextStats += 1000;
+        }
+      };
+
+      for (uint32_t turn = 0; turn < turns; turn++) {
+        std::vector<Dart> darts;
+        for (int idx = 0; idx < 3; idx++) {
+          advance(uniform(1800, 3200));
+          darts.push_back(dart());
+          frames.push_back(Frame{now, state("Throw", "Throw detected", darts)});
+        }
+        advance(uniform(1500, 2500));
+        frames.push_back(Frame{now, state("Takeout in progress", "Takeout started", darts)});
+        advance(uniform(2500, 4000));
+        frames.push_back(Frame{now, state("Throw", "Takeout finished", {})});
+      }
+
+      std::stable_sort(frames.begin(), frames.end(), [](const Frame& lhs, const Frame& rhs) {
+        return lhs.at < rhs.at;
+      });
+      return frames;
+    }
+
+  private:
+    int uniform(int min, int max) {
+      return std::uniform_int_distribution<int>(min, max)(_random);
+    }
+
+    // Singles are the most frequent, trebles are more likely than doubles
+    int weighted() {
+      int roll = uniform(0, 99);
+      return roll < 70 ? 1 : roll < 85 ? 3 : 2;
+    }
+
+    // Mostly stable around 30, with an occasional drop
+    int fps() {
+      int roll = uniform(0, 99);
+      return roll < 80 ? 30 : roll < 95 ? 29 : uniform(20, 28);
+    }
+
+    std::mt19937 _random;
+    int _numCameras;
+  };
+
+} // session
+
+#endif // Session_h_
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <AutodartsClient.h>
+#include <Bench.h>
+#include <FakeWebSocketServer.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+
+  // Mutable copies of the frames, receive() parses in place
+  std::vector<std::vector<char>> payloads(const std::vector<session::Frame>& frames) {
+    std::vector<std::vector<char>> payloads;
+    for (const session::Frame& frame : frames) {
+      payloads.emplace_back(frame.json.begin(), frame.json.end());
+      payloads.back().push_back('\0');
+    }
+    return payloads;
+  }
+
+  uint64_t receiveAll(Board& board, const std::vector<session::Frame>& frames) {
+    // Copies are made up front so that only the allocations of receive() are counted
+    std::vector<std::vector<char>> copies = payloads(frames);
+    bench::AllocationCounter counter;
+    for (std::vector<char>& payload : copies) {
+      board.receive(payload.data(), payload.size() - 1);
+    }
+    return counter.count();
+  }
+
+} // namespace
+
+// ArduinoJson takes its pools from malloc(), the counter has to see them for the tests below
+TEST(Allocations, CounterSeesJsonDocuments) {
+#ifdef AUTODARTS_SANITIZED
+  GTEST_SKIP() << "Sanitizer builds only count operator new";
+#endif
+  bench::AllocationCounter counter;
+  DynamicJsonDocument document(256);
+  ASSERT_FALSE(deserializeJson(document, "{\"type\":\"state\"}"));
+  EXPECT_EQ(1u, counter.count());
+}
+
+TEST(Allocations, ReceiveDoesNotAllocateInSteadyState) {
+  Board board("Board", BOARD_ID, "0.22.0", "10.0.0.1");
+  session::Generator generator(7);
+  std::vector<session::Frame> frames = generator.generate(50);
+
+  // The first frames create the camera slots and fill the histograms
+  receiveAll(board, generator.generate(2));
+  EXPECT_EQ(0u, receiveAll(board, frames));
+  EXPECT_EQ(0u, board.getMetrics().parseErrors.get());
+}
+
+TEST(Allocations, CallbacksDoNotAllocate) {
+  Client client;
+  uint32_t numThrows = 0;
+  uint32_t numData = 0;
+  uint32_t numStats = 0;
+  const Board* thrownAt = nullptr;
+  client.onThrow([&numThrows, &thrownAt](const Board& board, uint8_t, const Throw&) {
+    numThrows++;
+    thrownAt = &board;
+  });
+  client.onData([&numData](const Board&) { numData++; });
+  client.onCameraStats([&numStats](int8_t, int8_t, int16_t, int16_t) { numStats++; });
+  client.onDetectionEvent([](Status::Code, Event::Code) {});
+  client.onCameraSystemState([](State, State) {});
+  Client::BoardHandle handle = client.addBoard("Board", BOARD_ID, "0.22.0", "10.0.0.1");
+  Board& board = *client.getBoard(handle);
+
+  session::Generator generator(11);
+  receiveAll(board, generator.generate(2));
+  std::vector<session::Frame> frames = generator.generate(50);
+  numThrows = 0;
+  EXPECT_EQ(0u, receiveAll(board, frames));
+  EXPECT_EQ(150u, numThrows);
+  EXPECT_EQ(&board, thrownAt);
+  EXPECT_GT(numData, 0u);
+}
+
+TEST(Allocations, WebSocketTextPathDoesNotAllocate) {
+  mock::FakeWebSocketServer server("10.0.0.2", AUTODARTS_BOARD_PORT);
+  Client client;
+  uint32_t numThrows = 0;
+  client.onThrow([&numThrows](const Board&, uint8_t, const Throw&) { numThrows++; });
+  Client::BoardHandle handle = client.addBoard("Board", BOARD_ID, "0.22.0", "10.0.0.2");
+  client.openBoard(handle, true);
+  for (uint8_t idx = 0; idx < 10 && !client.getBoard(handle)->isOpen(); idx++) {
+    client.updateBoards();
+  }
+  ASSERT_TRUE(client.getBoard(handle)->isOpen());
+
+  session::Generator generator(13);
+  for (const session::Frame& frame : generator.generate(2)) {
+    server.push(frame.json);
+  }
+  while (server.getPending() > 0) {
+    client.updateBoard(handle);
+  }
+
+  std::vector<session::Frame> frames = generator.generate(50);
+  for (const session::Frame& frame : frames) {
+    server.push(frame.json);
+  }
+  numThrows = 0;
+  bench::AllocationCounter counter;
+  for (size_t idx = 0; idx < frames.size(); idx++) {
+    client.updateBoard(handle);
+  }
+  EXPECT_EQ(0u, counter.count());
+  EXPECT_EQ(0u, server.getPending());
+  EXPECT_EQ(150u, numThrows);
+}
+
+// Frames that do not fit the document are rejected without touching the heap
+TEST(Allocations, OversizedFrameFailsWithoutAllocating) {
+  Board board("Board", BOARD_ID, "0.22.0", "10.0.0.1");
+  // The first message allocates the document of the board
+  session::Generator generator(17);
+  receiveAll(board, generator.generate(1));
+  std::vector<session::Dart> darts(200, session::Dart{20, 3, 0.5f, 0.5f});
+  std::string json = session::state("Throw", "Throw detected", darts);
+  std::vector<char> payload(json.begin(), json.end());
+  payload.push_back('\0');
+
+  bench::AllocationCounter counter;
+  board.receive(payload.data(), payload.size() - 1);
+  EXPECT_EQ(0u, counter.count());
+  EXPECT_EQ(1u, board.getMetrics().parseErrors.get());
+}
+
+// Every board parses into its own document, a board that is closed gives it back
+TEST(Allocations, DocumentIsHeldPerBoardUntilClosed) {
+  Board first("First", BOARD_ID, "0.22.0", "10.0.0.1");
+  Board second("Second", "7d4e2b63-1e9f-4c8b-a032-4f6e8dac2b15", "0.22.0", "10.0.0.2");
+  session::Generator generator(19);
+  std::vector<session::Frame> frames = generator.generate(1);
+
+  int64_t before = mock::heapStats().liveBytes;
+  receiveAll(first, frames);
+  receiveAll(second, frames);
+  EXPECT_GE(mock::heapStats().liveBytes - before, static_cast<int64_t>(2 * sizeof(Board::MessageDocument)));
+
+  first.close();
+  second.close();
+  EXPECT_LT(mock::heapStats().liveBytes - before, static_cast<int64_t>(sizeof(Board::MessageDocument)));
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <AutodartsClient.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+  const char* OTHER_ID = "0b9e2d47-5c1a-4f63-8e7d-2a4c6f8b0d15";
+
+  void receive(Board& board, const std::string& json) {
+    std::vector<char> payload(json.begin(), json.end());
+    payload.push_back('\0');
+    board.receive(payload.data(), json.length());
+  }
+
+  // The board manager messages of the current state, the JSON form of the board
+  std::string toJson(const Board& board) {
+    const Detector& detector = board.getDetector();
+    const CameraSystem& cameras = detector.getCameraSystem();
+    std::string out;
+    auto append = [&out](const std::function<void(JsonObject&)>& write) {
+      DynamicJsonDocument json(1024);
+      JsonObject root = json.to<JsonObject>();
+      write(root);
+      String message;
+      serializeJson(json, message);
+      out += message.c_str();
+      out += "\n";
+    };
+    append([&detector](JsonObject& root) { detector.toJson(root); });
+    append([&cameras](JsonObject& root) { cameras.toJson(root); });
+    for (uint8_t idx = 0; idx < cameras.getNumCameras(); idx++) {
+      if (cameras.hasCamera(idx)) {
+        append([&cameras, idx](JsonObject& root) { cameras[idx].toJson(root); });
+      }
+    }
+    return out;
+  }
+
+  class Binary : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      _client.onThrow([this](const Board& board, uint8_t, const Throw&) { _throws[&board == _copy ? 1 : 0]++; });
+      _board = _client.getBoard(_client.addBoard("Board", BOARD_ID, "0.22.0", "10.0.7.1"));
+      _copy = _client.getBoard(_client.addBoard("Copy", OTHER_ID, "0.22.0", "10.0.7.2"));
+    }
+
+    // A board with the id of _board that is only updated from binary snapshots
+    Board _remote{"Remote", BOARD_ID, "0.22.0", "10.0.7.3"};
+    Client _client;
+    Board* _board = nullptr;
+    Board* _copy = nullptr;
+    uint32_t _throws[2] = {0, 0};
+    uint8_t _buffer[AUTODARTS_BINARY_MAX_SIZE];
+  };
+
+} // namespace
+
+// Every delta of a session applied to another board leaves it in the same JSON state
+TEST_F(Binary, DeltasRoundTripLikeJson) {
+  for (const session::Frame& frame : session::Generator(37).generate(20)) {
+    receive(*_board, frame.json);
+    ChangeMask changes = _board->getChanges();
+    if (changes == Change::NONE) {
+      continue;
+    }
+    size_t length = _board->toBinary(_buffer, sizeof(_buffer), changes);
+    ASSERT_GT(length, 0u);
+    _remote.fromBinary(_buffer, length);
+    ASSERT_EQ(toJson(*_board), toJson(_remote)) << frame.json;
+  }
+  EXPECT_EQ(60u, _throws[0]);
+}
+
+// A full snapshot brings a new board to the same state, and holds what the JSON form holds
+TEST_F(Binary, FullSnapshotRoundTripsLikeJson) {
+  for (const session::Frame& frame : session::Generator(41).generate(3)) {
+    receive(*_board, frame.json);
+  }
+  receive(*_board, session::state("Throw", "Throw detected", {{20, 3, 0.25f, -0.5f}, {19, 1, 0.1f, 0.2f}}));
+
+  size_t length = _board->toBinary(_buffer, sizeof(_buffer));
+  ASSERT_GT(length, 0u);
+  Board fresh("Fresh", BOARD_ID, "0.22.0", "10.0.7.4");
+  EXPECT_NE(Change::NONE, fresh.fromBinary(_buffer, length));
+  EXPECT_EQ(toJson(*_board), toJson(fresh));
+
+  // Decoded from JSON again, the snapshot is the same
+  DynamicJsonDocument json(4096);
+  ASSERT_FALSE(deserializeJson(json, toJson(*_board).substr(0, toJson(*_board).find('\n'))));
+  Detector detector;
+  detector.fromJson(json.as<JsonObjectConst>());
+  BoardSnapshot fromJson;
+  fromJson.fromDetector(_board->getUuid(), detector, Change::DETECTION_STATE | Change::THROWS);
+  BoardSnapshot decoded;
+  ASSERT_TRUE(decoded.decode(_buffer, length));
+  EXPECT_EQ(fromJson.numThrows, decoded.numThrows);
+  EXPECT_EQ(fromJson.status, decoded.status);
+  EXPECT_EQ(fromJson.event, decoded.event);
+  ASSERT_EQ(fromJson.numStoredThrows, decoded.numStoredThrows);
+  for (uint8_t idx = 0; idx < decoded.numStoredThrows; idx++) {
+    EXPECT_EQ(fromJson.throws[idx].getNumber(), decoded.throws[idx].getNumber());
+    EXPECT_EQ(fromJson.throws[idx].getMultiplier(), decoded.throws[idx].getMultiplier());
+    EXPECT_FLOAT_EQ(fromJson.throws[idx].getX(), decoded.throws[idx].getX());
+    EXPECT_FLOAT_EQ(fromJson.throws[idx].getY(), decoded.throws[idx].getY());
+  }
+}
+
+// 20 bytes header, 5 detection, 1 + 3 * 10 throws, 1 camera state, 1 + 3 * 6 camera stats
+TEST_F(Binary, Sizes) {
+  for (int id = 0; id < 3; id++) {
+    receive(*_board, session::camStats(id, 30));
+  }
+  receive(*_board, session::camState(true, true));
+  receive(*_board, session::state("Throw", "Throw detected", {{20, 3, 0, 0}, {19, 1, 0, 0}, {25, 2, 0, 0}}));
+
+  EXPECT_EQ(76u, _board->toBinary(_buffer, sizeof(_buffer)));
+  EXPECT_EQ(56u, _board->toBinary(_buffer, sizeof(_buffer), Change::DETECTION_STATE | Change::DETECTION_EVENT | Change::THROWS));
+  EXPECT_EQ(20u + 1 + 3 * 6, _board->toBinary(_buffer, sizeof(_buffer), Change::CAMERA_STATS));
+  EXPECT_LE(76u, AUTODARTS_BINARY_MAX_SIZE);
+  EXPECT_EQ(0u, _board->toBinary(_buffer, 75));
+}
+
+TEST_F(Binary, EncodeAndDecodeDoNotAllocate) {
+  receive(*_board, session::camStats(0, 30));
+  receive(*_board, session::state("Throw", "Throw detected", {{20, 3, 0, 0}}));
+  _remote.setListener(nullptr);
+  uint64_t before = mock::threadAllocations();
+  size_t length = _board->toBinary(_buffer, sizeof(_buffer));
+  ChangeMask changes = _remote.fromBinary(_buffer, length);
+  EXPECT_EQ(before, mock::threadAllocations());
+  EXPECT_NE(Change::NONE, changes);
+}
+
+// Broken input is rejected without touching the board
+TEST_F(Binary, RejectsInvalidInput) {
+  receive(*_board, session::state("Throw", "Throw detected", {{20, 3, 0, 0}}));
+  size_t length = _board->toBinary(_buffer, sizeof(_buffer));
+  std::string before = toJson(_remote);
+
+  mock::setLogCapture(true);
+  for (size_t truncated = 0; truncated < length; truncated++) {
+    EXPECT_EQ(Change::NONE, _remote.fromBinary(_buffer, truncated)) << truncated;
+  }
+  _buffer[1] = AUTODARTS_BINARY_VERSION + 1;
+  EXPECT_EQ(Change::NONE, _remote.fromBinary(_buffer, length));
+  _buffer[1] = AUTODARTS_BINARY_VERSION;
+  EXPECT_EQ(Change::NONE, _copy->fromBinary(_buffer, length));
+  mock::setLogCapture(false);
+
+  EXPECT_EQ(before, toJson(_remote));
+  EXPECT_EQ(0u, _throws[1]);
+  Uuid id;
+  ASSERT_TRUE(Uuid::fromString(BOARD_ID, id));
+  EXPECT_TRUE(id == BoardSnapshot::peekBoard(_buffer, length));
+}
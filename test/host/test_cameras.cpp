@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <AutodartsBinary.h>
+#include <AutodartsBoard.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+
+  void receive(Board& board, const std::string& json) {
+    std::vector<char> payload(json.begin(), json.end());
+    payload.push_back('\0');
+    board.receive(payload.data(), json.length());
+  }
+
+  // Cameras 0 and 2 report, camera 1 is unplugged
+  class Cameras : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      receive(_board, session::camStats(2, 30, 1920, 1080));
+      receive(_board, session::camStats(0, 29));
+    }
+
+    Board _board{"Board", BOARD_ID, "0.22.0", "10.0.0.1"};
+  };
+
+} // namespace
+
+TEST_F(Cameras, UnseenIdIsNotFound) {
+  const CameraSystem& cameras = _board.getDetector().getCameraSystem();
+  EXPECT_EQ(3, cameras.getNumCameras());
+  EXPECT_TRUE(cameras.hasCamera(0));
+  EXPECT_FALSE(cameras.hasCamera(1));
+  EXPECT_TRUE(cameras.hasCamera(2));
+  EXPECT_FALSE(cameras.hasCamera(-1));
+  EXPECT_FALSE(cameras.hasCamera(AUTODARTS_MAX_CAMERAS));
+
+  ASSERT_NE(nullptr, cameras.getCameraById(0));
+  EXPECT_EQ(29, cameras.getCameraById(0)->getFPS());
+  EXPECT_EQ(nullptr, cameras.getCameraById(1));
+  ASSERT_NE(nullptr, cameras.getCameraById(2));
+  EXPECT_EQ(1920, cameras.getCameraById(2)->getWidth());
+
+  receive(_board, session::camStats(1, 30));
+  EXPECT_NE(nullptr, cameras.getCameraById(1));
+}
+
+// The stats of a camera beyond AUTODARTS_MAX_CAMERAS are dropped, only the first one warns
+TEST_F(Cameras, UnsupportedIdWarnsOnce) {
+  mock::resetLog();
+  mock::setLogCapture(true);
+  const int ids[] = {AUTODARTS_MAX_CAMERAS, AUTODARTS_MAX_CAMERAS + 1, 15, 16, 127, -1, -2, -128};
+  for (uint32_t idx = 0; idx < 10; idx++) {
+    for (int id : ids) {
+      receive(_board, session::camStats(id, 30));
+    }
+  }
+  mock::setLogCapture(false);
+  EXPECT_EQ(1u, mock::logCount(mock::LOG_WARNING));
+  for (int id : ids) {
+    EXPECT_FALSE(_board.getDetector().getCameraSystem().hasCamera(id));
+  }
+}
+
+TEST_F(Cameras, StatsSkipUnseenSlots) {
+  std::array<CameraStats, AUTODARTS_MAX_CAMERAS> stats;
+  ASSERT_EQ(2, _board.getDetector().getCameraSystem().getStats(stats.data(), stats.size()));
+  EXPECT_EQ(0, stats[0].id);
+  EXPECT_EQ(2, stats[1].id);
+  ASSERT_EQ(1, _board.getDetector().getCameraSystem().getStats(stats.data(), 1));
+  EXPECT_EQ(0, stats[0].id);
+}
+
+// A snapshot only carries the cameras that reported and keeps their ids
+TEST_F(Cameras, SnapshotKeepsGaps) {
+  BoardSnapshot snapshot;
+  snapshot.fromDetector(_board.getUuid(), _board.getDetector());
+  EXPECT_EQ(2, snapshot.numCameras);
+
+  Detector detector;
+  snapshot.applyTo(detector);
+  const CameraSystem& cameras = detector.getCameraSystem();
+  EXPECT_EQ(3, cameras.getNumCameras());
+  EXPECT_NE(nullptr, cameras.getCameraById(0));
+  EXPECT_EQ(nullptr, cameras.getCameraById(1));
+  ASSERT_NE(nullptr, cameras.getCameraById(2));
+  EXPECT_EQ(1080, cameras.getCameraById(2)->getHeight());
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <AutodartsClient.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+
+  struct Counts {
+    uint32_t data = 0;
+    uint32_t events = 0;
+    uint32_t detectionState = 0;
+    uint32_t detectionEvent = 0;
+    uint32_t cameraStats = 0;
+    uint32_t cameraSystemState = 0;
+    uint32_t throws = 0;
+  };
+
+  void receive(Board& board, const std::string& json) {
+    std::vector<char> payload(json.begin(), json.end());
+    payload.push_back('\0');
+    board.receive(payload.data(), json.length());
+  }
+
+  class Changes : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      _client.onData([this](const Board&) { _counts.data++; });
+      _client.onData([this](const Board&) { _counts.events++; }, Change::DETECTION_EVENT);
+      _client.onDetectionState([this](State, State, int16_t) { _counts.detectionState++; });
+      _client.onDetectionEvent([this](Status::Code, Event::Code) { _counts.detectionEvent++; });
+      _client.onCameraStats([this](int8_t, int8_t, int16_t, int16_t) { _counts.cameraStats++; });
+      _client.onCameraSystemState([this](State, State) { _counts.cameraSystemState++; });
+      _client.onThrow([this](const Board&, uint8_t, const Throw&) { _counts.throws++; });
+      _board = _client.getBoard(_client.addBoard("Board", BOARD_ID, "0.22.0", "10.0.0.1"));
+    }
+
+    Client _client;
+    Board*  _board = nullptr;
+    Counts  _counts;
+  };
+
+} // namespace
+
+// Before the change masks every frame raised onData, every state frame the detection
+// callbacks and every cam_stats frame the camera stats callback
+TEST_F(Changes, ReplayedSessionRaisesOnlyRealChanges) {
+  const uint32_t turns = 100;
+  session::Generator generator(5);
+  std::vector<session::Frame> frames = generator.generate(turns);
+  uint32_t numState = 0;
+  uint32_t numStats = 0;
+  for (const session::Frame& frame : frames) {
+    numState += frame.json.find("\"type\":\"state\"") != std::string::npos;
+    numStats += frame.json.find("\"type\":\"cam_stats\"") != std::string::npos;
+    receive(*_board, frame.json);
+  }
+  double seconds = frames.back().at / 1000.0;
+
+  printf("%u frames over %.0f s\n", static_cast<uint32_t>(frames.size()), seconds);
+  printf("%-22s %8s %8s %10s\n", "callback", "before", "after", "reduction");
+  auto row = [seconds](const char* name, uint32_t before, uint32_t after) {
+    printf("%-22s %6.2f/s %6.2f/s %9.0f%%\n", name, before / seconds, after / seconds, 100.0 * (before - after) / before);
+  };
+  row("onData", frames.size(), _counts.data);
+  row("onDetectionState", numState, _counts.detectionState);
+  row("onDetectionEvent", numState, _counts.detectionEvent);
+  row("onCameraStats", numStats, _counts.cameraStats);
+
+  // Every turn changes the event three times: throw detected, takeout started and finished
+  EXPECT_EQ(1 + 3 * turns, _counts.detectionEvent);
+  EXPECT_EQ(_counts.detectionEvent, _counts.events);
+  EXPECT_EQ(1u, _counts.cameraSystemState);
+  EXPECT_EQ(3 * turns, _counts.throws);
+  EXPECT_LT(_counts.cameraStats, numStats / 2);
+  EXPECT_LT(_counts.data, frames.size() / 2);
+  EXPECT_LT(_counts.detectionState, numState);
+}
+
+TEST_F(Changes, RepeatedFrameRaisesNothing) {
+  std::string state = session::state("Throw", "Throw detected", {session::Dart{20, 3, 0.1f, 0.2f}});
+  std::string stats = session::camStats(0, 30);
+  receive(*_board, state);
+  receive(*_board, stats);
+  Counts first = _counts;
+  EXPECT_EQ(2u, first.data);
+  EXPECT_EQ(1u, first.throws);
+  EXPECT_EQ(1u, first.cameraStats);
+
+  receive(*_board, state);
+  receive(*_board, stats);
+  EXPECT_EQ(first.data, _counts.data);
+  EXPECT_EQ(first.detectionState, _counts.detectionState);
+  EXPECT_EQ(first.detectionEvent, _counts.detectionEvent);
+  EXPECT_EQ(first.cameraStats, _counts.cameraStats);
+  EXPECT_EQ(first.throws, _counts.throws);
+  EXPECT_EQ(Change::NONE, _board->getChanges());
+}
+
+TEST_F(Changes, MaskFiltersData) {
+  receive(*_board, session::state("Throw", "Throw detected", {}));
+  EXPECT_EQ(1u, _counts.events);
+  // Only the number of throws changes
+  receive(*_board, session::state("Throw", "Throw detected", {session::Dart{5, 1, 0.1f, 0.2f}}));
+  EXPECT_EQ(2u, _counts.data);
+  EXPECT_EQ(1u, _counts.events);
+  EXPECT_TRUE(_board->getChanges() & Change::NUM_THROWS);
+  EXPECT_FALSE(_board->getChanges() & Change::DETECTION_EVENT);
+
+  receive(*_board, session::camStats(1, 25));
+  EXPECT_EQ(3u, _counts.data);
+  EXPECT_EQ(1u, _counts.events);
+  EXPECT_EQ(Change::CAMERA_FPS | Change::CAMERA_RESOLUTION, _board->getChanges());
+}
+
+// The board manager corrects a dart without changing the number of darts
+TEST_F(Changes, CorrectedDartIsReported) {
+  receive(*_board, session::state("Throw", "Throw detected", {session::Dart{20, 3, 0.1f, 0.2f}, session::Dart{5, 1, 0.3f, 0.4f}}));
+  Counts first = _counts;
+  EXPECT_EQ(2u, first.throws);
+
+  receive(*_board, session::state("Throw", "Throw detected", {session::Dart{20, 3, 0.1f, 0.2f}, session::Dart{1, 1, 0.3f, 0.5f}}));
+  EXPECT_EQ(first.data + 1, _counts.data);
+  EXPECT_EQ(first.throws, _counts.throws);
+  EXPECT_EQ(Change::THROWS, _board->getChanges());
+  const Detector& detector = _board->getDetector();
+  ASSERT_EQ(2u, detector.getNumStoredThrows());
+  EXPECT_EQ(1, detector.getThrow(1).getNumber());
+  EXPECT_FLOAT_EQ(0.5f, detector.getThrow(1).getY());
+  EXPECT_EQ(20, detector.getThrow(0).getNumber());
+
+  // Decoded darts are compared the same way
+  Detector decoded;
+  Throw darts[2] = {Throw(20, 3, 0.1f, 0.2f), Throw(5, 1, 0.3f, 0.4f)};
+  EXPECT_EQ(Change::THROWS, decoded.applyThrows(darts, 2));
+  EXPECT_EQ(Change::NONE, decoded.applyThrows(darts, 2));
+  darts[0] = Throw(20, 1, 0.1f, 0.25f);
+  EXPECT_EQ(Change::THROWS, decoded.applyThrows(darts, 2));
+  EXPECT_EQ(1, decoded.getThrow(0).getMultiplier());
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <AutodartsClient.h>
+#include <FakeHttpServer.h>
+#include <FakeWebSocketServer.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+  const char* MATCH_ID = "3f9a1c2e-7b4d-4e8f-a1b2-c3d4e5f60718";
+  const char* OTHER_ID = "9d8c7b6a-5f4e-4d3c-b2a1-0f9e8d7c6b5a";
+
+  std::string tokenBody() {
+    return "{\"access_token\":\"access\",\"expires_in\":300,\"refresh_expires_in\":1800,"
+           "\"refresh_token\":\"refresh\",\"token_type\":\"Bearer\",\"scope\":\"profile email\"}";
+  }
+
+  std::string matchEvent(const char* event, const char* matchId) {
+    std::string data = std::string("{\"event\":\"") + event + "\"";
+    if (matchId != nullptr) {
+      data += std::string(",\"id\":\"") + matchId + "\"";
+    }
+    return std::string("{\"channel\":\"") + AUTODARTS_CLOUD_BOARDS_CHANNEL + "\",\"topic\":\"" + BOARD_ID +
+           ".matches\",\"data\":" + data + "}}";
+  }
+
+  std::string matchState(const char* matchId) {
+    return std::string("{\"channel\":\"") + AUTODARTS_CLOUD_MATCHES_CHANNEL + "\",\"topic\":\"" + matchId +
+           ".state\",\"data\":{\"round\":1}}";
+  }
+
+  // autodarts.io with the ticket endpoint and the subscribe websocket
+  class Cloud : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      _client.setCACert(mock::ROOT_CA);
+      _http.on("POST", AUTODARTS_AUTH_KEYCLOAK_URL, [](const mock::HttpRequest&) {
+        mock::HttpResponse response;
+        response.body = tokenBody();
+        return response;
+      });
+      _http.on("GET", AUTODARTS_API_BOARDS_URL, [](const mock::HttpRequest&) {
+        mock::HttpResponse response;
+        response.body = std::string("[{\"id\":\"") + BOARD_ID + "\",\"name\":\"Board\",\"ip\":\"10.0.5.10\",\"version\":\"0.22.0\"}]";
+        return response;
+      });
+      _http.on("POST", AUTODARTS_API_TICKET_URL, [](const mock::HttpRequest&) {
+        mock::HttpResponse response;
+        response.body = "ticket";
+        return response;
+      });
+      _client.onMatchChange([this](const Board& board) { _matches.push_back(board.getMatchId().toString().c_str()); });
+      _client.onMatchState([this](const Board&, const JsonObjectConst& data) { _states += data["round"].as<int>(); });
+
+      ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+      _board = _client.getBoard(_client.findBoard(BOARD_ID));
+      ASSERT_NE(nullptr, _board);
+      _client.connectCloud();
+      for (uint32_t start = millis(); !_client.isCloudConnected() && millis() - start < 2000;) {
+        _client.updateBoards();
+        delay(1);
+      }
+      ASSERT_TRUE(_client.isCloudConnected());
+    }
+
+    void TearDown() override {
+      _client.disconnectCloud();
+    }
+
+    // Delivers the message and waits until the client has handled it
+    void receive(const std::string& message) {
+      _cloud.push(message);
+      for (uint32_t start = millis(); _cloud.getPending() > 0 && millis() - start < 1000;) {
+        _client.updateBoards();
+      }
+    }
+
+    // Subscribe and unsubscribe messages the client sent for the state of a match
+    uint32_t count(const char* type, const char* matchId) {
+      uint32_t count = 0;
+      for (const std::string& message : _cloud.getReceived()) {
+        count += message.find(std::string("\"type\":\"") + type + "\"") != std::string::npos &&
+                 message.find(std::string(matchId) + ".state") != std::string::npos;
+      }
+      return count;
+    }
+
+    mock::FakeHttpServer _http;
+    mock::FakeWebSocketServer _cloud{AUTODARTS_CLOUD_HOST, 443};
+    Client _client;
+    Board* _board = nullptr;
+    std::vector<std::string> _matches;
+    int _states = 0;
+  };
+
+} // namespace
+
+TEST_F(Cloud, SubscribesEveryBoard) {
+  std::vector<std::string> received = _cloud.getReceived();
+  ASSERT_EQ(1u, received.size());
+  EXPECT_NE(std::string::npos, received[0].find(std::string(BOARD_ID) + ".matches"));
+  EXPECT_NE(std::string::npos, received[0].find("\"subscribe\""));
+}
+
+TEST_F(Cloud, StartAndFinishChangeTheMatch) {
+  receive(matchEvent("start", MATCH_ID));
+  ASSERT_EQ(1u, _matches.size());
+  EXPECT_EQ(MATCH_ID, _matches[0]);
+  EXPECT_EQ(1u, count("subscribe", MATCH_ID));
+
+  receive(matchState(MATCH_ID));
+  receive(matchState(OTHER_ID));
+  EXPECT_EQ(1, _states);
+
+  receive(matchEvent("finish", MATCH_ID));
+  ASSERT_EQ(2u, _matches.size());
+  EXPECT_TRUE(_board->getMatchId().isEmpty());
+  EXPECT_EQ(1u, count("unsubscribe", MATCH_ID));
+}
+
+// Events the client does not know must not end the match
+TEST_F(Cloud, UnknownEventsKeepTheMatch) {
+  receive(matchEvent("start", MATCH_ID));
+  receive(matchEvent("update", MATCH_ID));
+  receive(matchEvent("leg", nullptr));
+  receive(std::string("{\"channel\":\"") + AUTODARTS_CLOUD_BOARDS_CHANNEL + "\",\"topic\":\"" + BOARD_ID + ".matches\",\"data\":{}}");
+
+  EXPECT_EQ(1u, _matches.size());
+  EXPECT_EQ(String(MATCH_ID), _board->getMatchId().toString());
+  EXPECT_EQ(0u, count("unsubscribe", MATCH_ID));
+  receive(matchState(MATCH_ID));
+  EXPECT_EQ(1, _states);
+}
+
+// Only the end of the current match clears it, one without id ends whatever runs
+TEST_F(Cloud, DeleteOfAnotherMatchKeepsTheMatch) {
+  receive(matchEvent("start", MATCH_ID));
+  receive(matchEvent("delete", OTHER_ID));
+  EXPECT_EQ(String(MATCH_ID), _board->getMatchId().toString());
+
+  receive(matchEvent("delete", nullptr));
+  EXPECT_TRUE(_board->getMatchId().isEmpty());
+  ASSERT_EQ(2u, _matches.size());
+
+  receive(matchEvent("start", OTHER_ID));
+  receive(matchEvent("end", OTHER_ID));
+  EXPECT_TRUE(_board->getMatchId().isEmpty());
+  EXPECT_EQ(4u, _matches.size());
+}
+
+// Match states go to the board of the match only while it is in the client
+TEST_F(Cloud, DeletedBoardLeavesTheMatch) {
+  receive(matchEvent("start", MATCH_ID));
+  receive(matchState(MATCH_ID));
+  EXPECT_EQ(1, _states);
+
+  _client.deleteBoard(_client.findBoard(BOARD_ID));
+  receive(matchState(MATCH_ID));
+  EXPECT_EQ(1, _states);
+  EXPECT_EQ(1u, count("unsubscribe", MATCH_ID));
+}
+
+// A close by the server after a while, e.g. when the ticket expired, is no failure and a new
+// ticket is requested without the backoff
+TEST_F(Cloud, ServerCloseReconnectsRightAway) {
+  delay(AUTODARTS_CLOUD_MIN_RETRY + 100);
+  _cloud.dropAll();
+  for (uint32_t start = millis(); _client.isCloudConnected() && millis() - start < 1000;) {
+    _client.updateBoards();
+    delay(1);
+  }
+  ASSERT_FALSE(_client.isCloudConnected());
+  for (uint32_t start = millis(); !_client.isCloudConnected() && millis() - start < AUTODARTS_CLOUD_MIN_RETRY / 2;) {
+    _client.updateBoards();
+    delay(1);
+  }
+  EXPECT_TRUE(_client.isCloudConnected());
+  EXPECT_EQ(2u, _cloud.getNumHandshakes());
+}
+
+// A connection the server drops right away backs off like a failed connect
+TEST_F(Cloud, EarlyCloseBacksOff) {
+  _cloud.dropAll();
+  for (uint32_t start = millis(); millis() - start < AUTODARTS_CLOUD_MIN_RETRY / 2;) {
+    _client.updateBoards();
+    delay(1);
+  }
+  EXPECT_FALSE(_client.isCloudConnected());
+  EXPECT_EQ(1u, _cloud.getNumHandshakes());
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <AutodartsBoard.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  struct StatusCase {
+    const char*  value;
+    Status::Code code;
+  };
+
+  struct EventCase {
+    const char* value;
+    Event::Code code;
+  };
+
+  struct MessageCase {
+    const char*   value;
+    Message::Type type;
+  };
+
+  const StatusCase STATUS_CASES[] = {
+    {"Stopped",              Status::Code::STOPPED},
+    {"Starting",             Status::Code::STARTING},
+    {"Throw",                Status::Code::THROW},
+    {"Takeout",              Status::Code::TAKEOUT},
+    {"Takeout in progress",  Status::Code::TAKEOUT_PROGRESS},
+    // Same length and first character as a known status
+    {"Stopper",              Status::Code::UNKNOWN},
+    {"Tbkeout",              Status::Code::UNKNOWN},
+    {"Throws",               Status::Code::UNKNOWN},
+    {"throw",                Status::Code::UNKNOWN},
+    {"Takeout in progresS",  Status::Code::UNKNOWN},
+    {"Unknown",              Status::Code::UNKNOWN},
+    {"",                     Status::Code::UNKNOWN},
+    {nullptr,                Status::Code::UNKNOWN},
+  };
+
+  const EventCase EVENT_CASES[] = {
+    {"Stopped",              Event::Code::STOPPED},
+    {"Stopping",             Event::Code::STOPPING},
+    {"Starting",             Event::Code::STARTING},
+    {"Started",              Event::Code::STARTED},
+    {"Throw detected",       Event::Code::THROW_DETECTED},
+    {"Takeout started",      Event::Code::TAKEOUT_STARTED},
+    {"Takeout finished",     Event::Code::TAKEOUT_FINISHED},
+    {"Manual reset",         Event::Code::RESET},
+    // Same length and distinguishing character as a known event
+    {"Stapped",              Event::Code::UNKNOWN},
+    {"Startes",              Event::Code::UNKNOWN},
+    {"Stopping ",            Event::Code::UNKNOWN},
+    {"Stoxping",             Event::Code::UNKNOWN},
+    {"Throw Detected",       Event::Code::UNKNOWN},
+    {"Takeout startet",      Event::Code::UNKNOWN},
+    {"Manual reset!",        Event::Code::UNKNOWN},
+    {"",                     Event::Code::UNKNOWN},
+    {nullptr,                Event::Code::UNKNOWN},
+  };
+
+  const MessageCase MESSAGE_CASES[] = {
+    {"state",                Message::Type::STATE},
+    {"cam_state",            Message::Type::CAM_STATE},
+    {"cam_stats",            Message::Type::CAM_STATS},
+    {"stats",                Message::Type::UNKNOWN},
+    {"cam_statx",            Message::Type::UNKNOWN},
+    {"cam_stat",             Message::Type::UNKNOWN},
+    {"cax_state",            Message::Type::UNKNOWN},
+    {"motion_state",         Message::Type::UNKNOWN},
+    {"",                     Message::Type::UNKNOWN},
+    {nullptr,                Message::Type::UNKNOWN},
+  };
+
+  // Parses one state frame with the given status and event
+  void parse(Detector& detector, const char* status, const char* event) {
+    DynamicJsonDocument document(1024);
+    deserializeJson(document, session::state(status, event, {}));
+    detector.fromJson(document.as<JsonObjectConst>());
+  }
+
+} // namespace
+
+TEST(Defines, StatusFromString) {
+  for (const StatusCase& test : STATUS_CASES) {
+    SCOPED_TRACE(test.value != nullptr ? test.value : "nullptr");
+    EXPECT_EQ(test.code, Status::fromString(test.value));
+    if (test.value != nullptr) {
+      EXPECT_EQ(test.code, Status::fromString(String(test.value)));
+    }
+  }
+}
+
+TEST(Defines, StatusRoundTrip) {
+  for (const StatusCase& test : STATUS_CASES) {
+    if (test.code != Status::Code::UNKNOWN) {
+      EXPECT_STREQ(test.value, Status::name(test.code));
+      EXPECT_EQ(test.code, Status::fromString(Status::toString(test.code)));
+    }
+  }
+}
+
+TEST(Defines, EventFromString) {
+  for (const EventCase& test : EVENT_CASES) {
+    SCOPED_TRACE(test.value != nullptr ? test.value : "nullptr");
+    EXPECT_EQ(test.code, Event::fromString(test.value));
+    if (test.value != nullptr) {
+      EXPECT_EQ(test.code, Event::fromString(String(test.value)));
+    }
+  }
+}
+
+TEST(Defines, EventRoundTrip) {
+  for (const EventCase& test : EVENT_CASES) {
+    if (test.code != Event::Code::UNKNOWN) {
+      EXPECT_STREQ(test.value, Event::name(test.code));
+      EXPECT_EQ(test.code, Event::fromString(Event::toString(test.code)));
+    }
+  }
+}
+
+TEST(Defines, MessageFromString) {
+  for (const MessageCase& test : MESSAGE_CASES) {
+    SCOPED_TRACE(test.value != nullptr ? test.value : "nullptr");
+    EXPECT_EQ(test.type, Message::fromString(test.value));
+    if (test.type != Message::Type::UNKNOWN) {
+      EXPECT_STREQ(test.value, Message::toString(test.type));
+    }
+  }
+}
+
+// The parsed codes end up in the detector instead of being discarded
+TEST(Defines, DetectorKeepsStatusAndEvent) {
+  Detector detector;
+  parse(detector, "Takeout in progress", "Takeout started");
+  EXPECT_EQ(Status::Code::TAKEOUT_PROGRESS, detector.getStatus().value());
+  EXPECT_EQ(Event::Code::TAKEOUT_STARTED, detector.getEvent().value());
+
+  parse(detector, "Throws", "Throw detected");
+  EXPECT_EQ(Status::Code::UNKNOWN, detector.getStatus().value());
+  EXPECT_EQ(Event::Code::THROW_DETECTED, detector.getEvent().value());
+}
+
+// Hostnames do not fit the packed IPv4 address, they are reported like any other bad address
+TEST(Defines, UnsupportedBoardAddress) {
+  mock::resetLog();
+  mock::setLogCapture(true);
+  for (const char* url : {"", "ws://", "10.0.0.300", "autodarts-board.local", "my-dartboard:3180"}) {
+    Board board("Board", "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04", "0.22.0", url);
+    EXPECT_TRUE(board.getUrl().isEmpty()) << url;
+    EXPECT_FALSE(board.open()) << url;
+  }
+  mock::setLogCapture(false);
+  EXPECT_EQ(5u, mock::logCount(mock::LOG_WARNING));
+
+  Board board("Board", "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04", "0.22.0", "ws://10.0.0.30:3181/api");
+  EXPECT_EQ(String("10.0.0.30:3181"), board.getUrl());
+}
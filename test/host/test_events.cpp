@@ -0,0 +1,306 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <AutodartsClient.h>
+#include <Bench.h>
+#include <FakeWebSocketServer.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+  const char* BOARD_IP = "10.0.4.10";
+
+  struct Counts {
+    uint32_t data = 0;
+    uint32_t cameraStats = 0;
+    uint32_t cameraSystemState = 0;
+    uint32_t detectionState = 0;
+    uint32_t detectionEvent = 0;
+    uint32_t throws = 0;
+    std::vector<int8_t> cameras;     // Id of every camera stats event
+    std::vector<Event::Code> events; // Every detection event
+  };
+
+  void expectSame(const Counts& expected, const Counts& actual) {
+    EXPECT_EQ(expected.data, actual.data);
+    EXPECT_EQ(expected.cameraStats, actual.cameraStats);
+    EXPECT_EQ(expected.cameraSystemState, actual.cameraSystemState);
+    EXPECT_EQ(expected.detectionState, actual.detectionState);
+    EXPECT_EQ(expected.detectionEvent, actual.detectionEvent);
+    EXPECT_EQ(expected.throws, actual.throws);
+    EXPECT_EQ(expected.cameras, actual.cameras);
+    EXPECT_EQ(expected.events, actual.events);
+  }
+
+  // Counts what the detector and cameras raise on the sink of a board
+  class CountingListener : public BoardListener {
+  public:
+    CountingListener(Counts& counts) : _counts(counts) {}
+
+    void onData(const Board&) override {
+      _counts.data++;
+    }
+
+    void onCameraStats(const Board&, int8_t id, int8_t, int16_t, int16_t) override {
+      _counts.cameraStats++;
+      _counts.cameras.push_back(id);
+    }
+
+    void onCameraSystemState(const Board&, State, State) override {
+      _counts.cameraSystemState++;
+    }
+
+    void onDetectionState(const Board&, State, State, int16_t) override {
+      _counts.detectionState++;
+    }
+
+    void onDetectionEvent(const Board&, Status::Code, Event::Code event) override {
+      _counts.detectionEvent++;
+      _counts.events.push_back(event);
+    }
+
+    void onThrow(const Board&, uint8_t, const Throw&) override {
+      _counts.throws++;
+    }
+
+  private:
+    Counts& _counts;
+  };
+
+  void subscribe(Client& client, Counts& counts) {
+    client.onData([&counts](const Board&) { counts.data++; });
+    client.onCameraStats([&counts](int8_t id, int8_t, int16_t, int16_t) {
+      counts.cameraStats++;
+      counts.cameras.push_back(id);
+    });
+    client.onCameraSystemState([&counts](State, State) { counts.cameraSystemState++; });
+    client.onDetectionState([&counts](State, State, int16_t) { counts.detectionState++; });
+    client.onDetectionEvent([&counts](Status::Code, Event::Code event) {
+      counts.detectionEvent++;
+      counts.events.push_back(event);
+    });
+    client.onThrow([&counts](const Board&, uint8_t, const Throw&) { counts.throws++; });
+  }
+
+  void receive(Board& board, const std::string& json) {
+    std::vector<char> payload(json.begin(), json.end());
+    payload.push_back('\0');
+    board.receive(payload.data(), json.length());
+  }
+
+  // What the sink of a board raises for the frames, the reference for the client
+  Counts replayOnSink(const std::vector<session::Frame>& frames) {
+    Counts counts;
+    CountingListener listener(counts);
+    Board board("Board", BOARD_ID, "0.22.0", BOARD_IP);
+    board.setListener(&listener);
+    for (const session::Frame& frame : frames) {
+      receive(board, frame.json);
+    }
+    board.setListener(nullptr);
+    return counts;
+  }
+
+  class Events : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      _frames = session::Generator(17).generate(TURNS);
+      _expected = replayOnSink(_frames);
+    }
+
+    static const uint32_t TURNS = 20;
+
+    std::vector<session::Frame> _frames;
+    Counts _expected;
+  };
+
+} // namespace
+
+// The sink itself sees every event of the session
+TEST_F(Events, SinkRaisesEveryEvent) {
+  EXPECT_EQ(3 * TURNS, _expected.throws);
+  EXPECT_EQ(1 + 3 * TURNS, _expected.detectionEvent);
+  EXPECT_EQ(1u, _expected.cameraSystemState);
+  EXPECT_GT(_expected.detectionState, 0u);
+  EXPECT_GT(_expected.cameraStats, 3u);
+  EXPECT_GT(_expected.data, 0u);
+  for (int8_t id : {0, 1, 2}) {
+    EXPECT_NE(_expected.cameras.end(), std::find(_expected.cameras.begin(), _expected.cameras.end(), id));
+  }
+}
+
+// Events raised by detector and cameras reach the handlers of the client, registered
+// before or after the board was added
+TEST_F(Events, ReplayReachesClientCallbacks) {
+  Client client;
+  Counts before;
+  Counts after;
+  subscribe(client, before);
+  Board* board = client.getBoard(client.addBoard("Board", BOARD_ID, "0.22.0", BOARD_IP));
+  subscribe(client, after);
+  for (const session::Frame& frame : _frames) {
+    receive(*board, frame.json);
+  }
+  expectSame(_expected, before);
+  expectSame(_expected, after);
+}
+
+// With the network task the frames arrive over the websocket and the events are queued,
+// the same callbacks are called in the same order from updateBoards()
+TEST_F(Events, ReplayOverNetworkTaskReachesClientCallbacks) {
+  mock::FakeWebSocketServer server(BOARD_IP, AUTODARTS_BOARD_PORT);
+  Client client;
+  Counts counts;
+  subscribe(client, counts);
+  std::atomic<bool> open{false};
+  client.onConnectionChange([&open](const Board& board) { open = board.isOpen(); });
+  Client::BoardHandle handle = client.addBoard("Board", BOARD_ID, "0.22.0", BOARD_IP);
+  ASSERT_TRUE(client.startNetworkTask());
+  client.openBoard(handle, true);
+  for (uint32_t start = millis(); !open && millis() - start < 2000;) {
+    client.updateBoards();
+    delay(1);
+  }
+  ASSERT_TRUE(open);
+
+  // Paced, so that the notification queue never overflows
+  for (const session::Frame& frame : _frames) {
+    server.push(frame.json);
+    for (uint32_t start = millis(); server.getPending() > 0 && millis() - start < 1000;) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    client.updateBoards();
+  }
+  for (uint32_t idx = 0; idx < 20; idx++) {
+    client.updateBoards();
+    delay(1);
+  }
+  client.stopNetworkTask();
+  client.updateBoards();
+
+  EXPECT_EQ(0u, server.getPending());
+  expectSame(_expected, counts);
+}
+
+namespace {
+
+  const char* OTHER_ID = "0b9e2d47-5c1a-4f63-8e7d-2a4c6f8b0d15";
+
+  struct Degraded {
+    const Board* board;
+    int8_t       camera;
+    bool         degraded;
+  };
+
+  // Camera 1 drops to 20 FPS for a while and recovers, the others keep 30
+  std::vector<std::string> degradingFrames() {
+    std::vector<std::string> frames;
+    for (uint32_t idx = 0; idx < 3 * AUTODARTS_CAMERA_HISTORY; idx++) {
+      bool low = idx >= AUTODARTS_CAMERA_HISTORY / 2 && idx < 3 * AUTODARTS_CAMERA_HISTORY / 2;
+      for (int id = 0; id < 3; id++) {
+        frames.push_back(session::camStats(id, id == 1 && low ? 20 : 30));
+      }
+    }
+    return frames;
+  }
+
+} // namespace
+
+// The degraded camera is reported with the board it belongs to
+TEST(Degraded, CallbackNamesTheBoard) {
+  Client client;
+  std::vector<Degraded> reports;
+  client.onCameraDegraded([&reports](const Board& board, const CameraStats& stats, bool degraded) {
+    reports.push_back(Degraded{&board, stats.id, degraded});
+  });
+  client.setCameraDegradedThreshold(25);
+  Board* healthy = client.getBoard(client.addBoard("Healthy", OTHER_ID, "0.22.0", "10.0.4.11"));
+  Board* board = client.getBoard(client.addBoard("Board", BOARD_ID, "0.22.0", BOARD_IP));
+  for (const std::string& frame : degradingFrames()) {
+    receive(*healthy, session::camStats(1, 30));
+    receive(*board, frame);
+  }
+
+  ASSERT_EQ(2u, reports.size());
+  EXPECT_EQ(board, reports[0].board);
+  EXPECT_EQ(1, reports[0].camera);
+  EXPECT_TRUE(reports[0].degraded);
+  EXPECT_EQ(board, reports[1].board);
+  EXPECT_EQ(1, reports[1].camera);
+  EXPECT_FALSE(reports[1].degraded);
+}
+
+TEST(Degraded, QueuedCallbackNamesTheBoard) {
+  mock::FakeWebSocketServer server(BOARD_IP, AUTODARTS_BOARD_PORT);
+  Client client;
+  std::vector<Degraded> reports;
+  client.onCameraDegraded([&reports](const Board& board, const CameraStats& stats, bool degraded) {
+    reports.push_back(Degraded{&board, stats.id, degraded});
+  });
+  client.setCameraDegradedThreshold(25);
+  std::atomic<bool> open{false};
+  client.onConnectionChange([&open](const Board& board) { open = board.isOpen(); });
+  Client::BoardHandle handle = client.addBoard("Board", BOARD_ID, "0.22.0", BOARD_IP);
+  ASSERT_TRUE(client.startNetworkTask());
+  client.openBoard(handle, true);
+  for (uint32_t start = millis(); !open && millis() - start < 2000;) {
+    client.updateBoards();
+    delay(1);
+  }
+  ASSERT_TRUE(open);
+  for (const std::string& frame : degradingFrames()) {
+    server.push(frame);
+  }
+  for (uint32_t start = millis(); reports.size() < 2 && millis() - start < 5000;) {
+    client.updateBoards();
+    delay(1);
+  }
+  client.stopNetworkTask();
+
+  ASSERT_EQ(2u, reports.size());
+  EXPECT_EQ(client.getBoard(handle), reports[0].board);
+  EXPECT_TRUE(reports[0].degraded);
+  EXPECT_EQ(client.getBoard(handle), reports[1].board);
+  EXPECT_FALSE(reports[1].degraded);
+}
+
+// A listener too large for the inline storage of std::function is allocated once, when it
+// is created, and moved from there into the slot of the topic
+TEST(Topics, SubscribeMovesTheListener) {
+  Client client;
+  std::array<uint32_t, 16> counts{};
+  ThrowCallback callback = [counts](const Board&, uint8_t, const Throw&) mutable { counts[0]++; };
+  bench::AllocationCounter counter;
+  EXPECT_NE(AUTODARTS_NO_SUBSCRIPTION, client.onThrow(std::move(callback)));
+  EXPECT_EQ(0u, counter.count());
+}
+
+// Listeners of up to two pointers are stored inline in their slot, larger ones are allocated
+// once when they are converted. Publishing allocates for neither.
+TEST(Topics, OnlyLargeListenersAllocate) {
+  Topic<2, uint8_t> topic(1);
+  uint32_t first = 0;
+  uint32_t second = 0;
+  uint32_t third = 0;
+
+  bench::AllocationCounter small;
+  EXPECT_NE(AUTODARTS_NO_SUBSCRIPTION, topic.subscribe([&first, &second](uint8_t idx) { first += idx; second++; }));
+  EXPECT_EQ(0u, small.count());
+
+  bench::AllocationCounter large;
+  EXPECT_NE(AUTODARTS_NO_SUBSCRIPTION, topic.subscribe([&first, &second, &third](uint8_t idx) { first += idx; second++; third++; }));
+  EXPECT_EQ(1u, large.count());
+
+  bench::AllocationCounter publish;
+  for (uint8_t idx = 0; idx < 10; idx++) {
+    topic.publish(idx);
+  }
+  EXPECT_EQ(0u, publish.count());
+  EXPECT_EQ(90u, first);
+  EXPECT_EQ(20u, second);
+  EXPECT_EQ(10u, third);
+}
@@ -0,0 +1,643 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <thread>
+
+#include <AutodartsClient.h>
+#include <FakeHttpServer.h>
+#include <FakeWebSocketServer.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+  const char* BOARD_IP = "10.0.2.10";
+
+  std::string tokenBody() {
+    return "{\"access_token\":\"access\",\"expires_in\":300,\"refresh_expires_in\":1800,"
+           "\"refresh_token\":\"refresh\",\"token_type\":\"Bearer\",\"scope\":\"profile email\"}";
+  }
+
+  std::string boardsBody() {
+    return std::string("[{\"id\":\"") + BOARD_ID + "\",\"name\":\"Board\",\"ip\":\"" + BOARD_IP +
+           "\",\"version\":\"0.22.0\",\"permissions\":[\"owner\"]}]";
+  }
+
+  // autodarts.io with a slow login: a TLS handshake and a response that take a while each
+  class Http : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      _client.setCACert(mock::ROOT_CA);
+      _http.setHandshakeDelay(300);
+      _http.on("POST", AUTODARTS_AUTH_KEYCLOAK_URL, [](const mock::HttpRequest&) {
+        mock::HttpResponse response;
+        response.body = tokenBody();
+        response.delay = 1200;
+        return response;
+      });
+      _http.on("GET", AUTODARTS_API_BOARDS_URL, [](const mock::HttpRequest&) {
+        mock::HttpResponse response;
+        response.body = boardsBody();
+        response.headers.push_back({"ETag", "\"1\""});
+        return response;
+      });
+      _handle = _client.addBoard("Board", BOARD_ID, "0.22.0", BOARD_IP);
+      _client.onThrow([this](const Board&, uint8_t, const Throw&) { _numThrows++; });
+    }
+
+    bool waitOpen() {
+      _client.openBoards(true);
+      for (uint32_t start = millis(); millis() - start < 1000;) {
+        _client.updateBoards();
+        if (_client.getBoard(_handle)->isOpen()) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Keeps frames coming, one is delivered per update
+    void feed() {
+      if (_board.getPending() == 0) {
+        for (const session::Frame& frame : _generator.generate(2)) {
+          _board.push(frame.json);
+        }
+      }
+    }
+
+    mock::FakeHttpServer _http;
+    mock::FakeWebSocketServer _board{BOARD_IP, AUTODARTS_BOARD_PORT};
+    session::Generator _generator{3};
+    Client _client;
+    Client::BoardHandle _handle;
+    uint32_t _numThrows = 0;
+  };
+
+} // namespace
+
+TEST_F(Http, BoardsAreServedWhileRequestIsInFlight) {
+  ASSERT_TRUE(waitOpen());
+  int code = 0;
+  ASSERT_TRUE(_client.autoDetectBoardsAsync("user", "secret", [&code](int ret) { code = ret; }));
+
+  uint32_t start = millis();
+  uint32_t longest = 0;
+  uint32_t updates = 0;
+  while (code == 0 && millis() - start < 5000) {
+    feed();
+    uint32_t begin = millis();
+    _client.updateBoards();
+    longest = std::max<uint32_t>(longest, millis() - begin);
+    updates++;
+    delay(1);
+  }
+  uint32_t elapsed = millis() - start;
+  printf("request took %u ms, %u updates, %u throws, longest update %u ms\n", elapsed, updates, _numThrows, longest);
+
+  EXPECT_EQ(HTTP_CODE_OK, code);
+  EXPECT_FALSE(_client.isRequestPending());
+  EXPECT_GE(elapsed, 1500u);
+  EXPECT_LT(longest, 100u);
+  EXPECT_GT(_numThrows, 0u);
+  EXPECT_TRUE(_client.getBoard(_handle)->isOpen());
+  EXPECT_EQ(1u, _client.getNumBoards());
+  EXPECT_EQ(2u, _http.getNumRequests());
+}
+
+// Credentials saved while the restore request runs wait behind it and use its token
+TEST_F(Http, RequestWaitsBehindPendingOne) {
+  int first = 0;
+  int second = 0;
+  ASSERT_TRUE(_client.autoDetectBoardsAsync("user", "secret", [&first](int ret) { first = ret; }));
+  ASSERT_TRUE(_client.autoDetectBoardsAsync("user", "secret", [&first, &second](int ret) {
+    EXPECT_NE(0, first);
+    second = ret;
+  }));
+  for (uint32_t start = millis(); second == 0 && millis() - start < 5000;) {
+    _client.updateBoards();
+    delay(1);
+  }
+  EXPECT_EQ(HTTP_CODE_OK, first);
+  EXPECT_EQ(HTTP_CODE_OK, second);
+  EXPECT_FALSE(_client.isRequestPending());
+  uint32_t logins = 0;
+  for (const mock::HttpRequest& sent : _http.getRequests()) {
+    logins += sent.url == AUTODARTS_AUTH_KEYCLOAK_URL ? 1 : 0;
+  }
+  EXPECT_EQ(1u, logins);
+}
+
+// The request task uses the sessions of the client, destroying the client waits for it
+TEST_F(Http, DestructionWaitsForRequest) {
+  {
+    Client client;
+    client.setCACert(mock::ROOT_CA);
+    ASSERT_TRUE(client.autoDetectBoardsAsync("user", "secret", [](int) { ADD_FAILURE(); }));
+    ASSERT_TRUE(client.autoDetectBoardsAsync("user", "secret", [](int) { ADD_FAILURE(); }));
+    for (uint32_t start = millis(); _http.getNumRequests() == 0 && millis() - start < 1000;) {
+      delay(1);
+    }
+  }
+  // The login was completed, the board list is not requested anymore
+  uint32_t requests = _http.getNumRequests();
+  delay(500);
+  EXPECT_EQ(1u, requests);
+  EXPECT_EQ(requests, _http.getNumRequests());
+}
+
+// Of two queued requests the last one is kept
+TEST_F(Http, QueuedRequestIsReplaced) {
+  std::vector<int> codes(3, 0);
+  for (int idx = 0; idx < 3; idx++) {
+    ASSERT_TRUE(_client.autoDetectBoardsAsync("user", "secret", [&codes, idx](int ret) { codes[idx] = ret; }));
+  }
+  EXPECT_EQ(HTTP_CODE_CONFLICT, codes[1]);
+  for (uint32_t start = millis(); codes[2] == 0 && millis() - start < 5000;) {
+    _client.updateBoards();
+    delay(1);
+  }
+  EXPECT_EQ(HTTP_CODE_OK, codes[0]);
+  EXPECT_EQ(HTTP_CODE_OK, codes[2]);
+}
+
+// The blocking variant holds the loop for the whole request, no frame is processed meanwhile
+TEST_F(Http, BlockingRequestStallsBoards) {
+  ASSERT_TRUE(waitOpen());
+  feed();
+  size_t pending = _board.getPending();
+
+  uint32_t start = millis();
+  EXPECT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  uint32_t elapsed = millis() - start;
+  printf("blocking request took %u ms\n", elapsed);
+
+  EXPECT_GE(elapsed, 1500u);
+  EXPECT_EQ(pending, _board.getPending());
+}
+
+// Without a root certificate the servers are not trusted, turning verification off is explicit
+TEST(Certificates, UnverifiedServerIsRefused) {
+  mock::FakeHttpServer http;
+  http.on("POST", AUTODARTS_AUTH_KEYCLOAK_URL, [](const mock::HttpRequest&) {
+    mock::HttpResponse response;
+    response.body = tokenBody();
+    return response;
+  });
+  http.on("GET", AUTODARTS_API_BOARDS_URL, [](const mock::HttpRequest&) {
+    mock::HttpResponse response;
+    response.body = boardsBody();
+    return response;
+  });
+
+  Client client;
+  mock::setLogCapture(true);
+  EXPECT_NE(HTTP_CODE_OK, client.autoDetectBoards("user", "secret"));
+  mock::setLogCapture(false);
+  EXPECT_EQ(0u, http.getNumRequests());
+
+  client.setInsecure();
+  EXPECT_EQ(HTTP_CODE_OK, client.autoDetectBoards("user", "secret"));
+  EXPECT_EQ(1u, client.getNumBoards());
+}
+
+namespace {
+
+  // Keycloak with the costs of a real server: the password grant hashes the password,
+  // the refresh token grant only checks a signature. Expired or unknown refresh tokens
+  // are rejected with invalid_grant like Keycloak does.
+  class Keycloak : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      _client.setCACert(mock::ROOT_CA);
+      mock::setManualClock(true);
+      _http.setHandshakeDelay(HANDSHAKE);
+      _http.on("POST", AUTODARTS_AUTH_KEYCLOAK_URL, [this](const mock::HttpRequest& request) {
+        mock::HttpResponse response;
+        bool password = request.body.find("grant_type=password") != std::string::npos;
+        bool refresh = request.body.find("grant_type=refresh_token&refresh_token=refresh") != std::string::npos;
+        if (password) {
+          _numLogins++;
+          response.delay = PASSWORD_GRANT;
+        }
+        else {
+          _numRefreshs++;
+          response.delay = REFRESH_GRANT;
+        }
+        if (password ? request.body.find("password=secret") == std::string::npos : !(refresh && _acceptRefresh)) {
+          response.code = 400;
+          response.body = "{\"error\":\"invalid_grant\"}";
+          return encode(response);
+        }
+        response.body = tokenBody();
+        return encode(response);
+      });
+      _http.on("GET", AUTODARTS_API_BOARDS_URL, [this](const mock::HttpRequest&) {
+        mock::HttpResponse response;
+        response.body = boardsBody();
+        return encode(response);
+      });
+    }
+
+    void TearDown() override {
+      mock::setManualClock(false);
+    }
+
+    // Latency of one token request as seen by the client
+    uint32_t request(const String& username, const String& password, int expected = HTTP_CODE_OK) {
+      uint32_t start = millis();
+      EXPECT_EQ(expected, _client.requestAccessToken(username, password, _accessToken, _refreshToken));
+      return millis() - start;
+    }
+
+    // Like behind a proxy that sends the last chunk on its own
+    mock::HttpResponse encode(mock::HttpResponse response) const {
+      if (_chunked) {
+        response.chunked = true;
+        response.chunkSize = 64;
+        response.trailerDelay = 40;
+      }
+      return response;
+    }
+
+    static const uint32_t HANDSHAKE      = 450;
+    static const uint32_t PASSWORD_GRANT = 350;
+    static const uint32_t REFRESH_GRANT  = 25;
+
+    mock::FakeHttpServer _http;
+    Client _client;
+    Client::Token _accessToken;
+    Client::Token _refreshToken;
+    uint32_t _numLogins = 0;
+    uint32_t _numRefreshs = 0;
+    bool _acceptRefresh = true;
+    bool _chunked = false;
+  };
+
+} // namespace
+
+TEST_F(Keycloak, RenewalIsCheaperThanLogin) {
+  uint32_t login = request("user", "secret");
+  EXPECT_EQ(1u, _numLogins);
+  EXPECT_FALSE(_refreshToken.first.isEmpty());
+
+  // Within the renewal margin of the 300 s token
+  mock::advanceClock(250 * 1000);
+  uint32_t renewal = request("user", "secret");
+  EXPECT_EQ(1u, _numRefreshs);
+
+  // Keycloak closes idle connections, the renewal then needs a new handshake
+  mock::advanceClock(250 * 1000);
+  _http.closeConnections();
+  uint32_t coldRenewal = request("user", "secret");
+
+  // Renewal also works without keeping the credentials
+  mock::advanceClock(250 * 1000);
+  uint32_t anonymous = request("", "");
+
+  printf("%-36s %6u ms\n", "password grant, new connection", login);
+  printf("%-36s %6u ms\n", "refresh grant, kept alive connection", renewal);
+  printf("%-36s %6u ms\n", "refresh grant, new connection", coldRenewal);
+  printf("%-36s %6u ms\n", "refresh grant without credentials", anonymous);
+
+  EXPECT_EQ(1u, _numLogins);
+  EXPECT_EQ(3u, _numRefreshs);
+  EXPECT_LT(renewal * 10, login);
+  EXPECT_LT(coldRenewal, login);
+  for (const mock::HttpRequest& sent : _http.getRequests()) {
+    if (sent.body.find("grant_type=refresh_token") != std::string::npos) {
+      EXPECT_EQ(std::string::npos, sent.body.find("password")) << sent.body;
+    }
+  }
+}
+
+TEST_F(Keycloak, FallsBackToLoginWhenRefreshIsRejected) {
+  request("user", "secret");
+  _acceptRefresh = false;
+  mock::advanceClock(250 * 1000);
+  request("user", "secret");
+  EXPECT_EQ(1u, _numRefreshs);
+  EXPECT_EQ(2u, _numLogins);
+  EXPECT_FALSE(_refreshToken.first.isEmpty());
+
+  // Without credentials there is nothing to fall back to
+  mock::advanceClock(250 * 1000);
+  request("", "", 400);
+  EXPECT_EQ(2u, _numLogins);
+}
+
+TEST_F(Keycloak, ValidTokenIsNotRequestedAgain) {
+  request("user", "secret");
+  mock::advanceClock(60 * 1000);
+  EXPECT_EQ(0u, request("user", "secret"));
+  EXPECT_EQ(1u, _numLogins);
+  EXPECT_EQ(0u, _numRefreshs);
+}
+
+// updateBoards() renews the token of the client in the background before it expires
+TEST_F(Keycloak, UpdateBoardsRenewsAheadOfExpiry) {
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  EXPECT_EQ(1u, _numLogins);
+
+  mock::advanceClock(250 * 1000);
+  _client.updateBoards();
+  EXPECT_TRUE(_client.isRequestPending());
+  for (uint32_t idx = 0; idx < 5000 && _client.isRequestPending(); idx++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    _client.updateBoards();
+  }
+  EXPECT_FALSE(_client.isRequestPending());
+  EXPECT_EQ(1u, _numLogins);
+  EXPECT_EQ(1u, _numRefreshs);
+}
+
+// A failed renewal keeps the tokens of the client, the next one uses the refresh token again
+TEST_F(Keycloak, FailedRenewalKeepsTokens) {
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  auto renew = [this]() {
+    _client.updateBoards();
+    EXPECT_TRUE(_client.isRequestPending());
+    for (uint32_t idx = 0; idx < 5000 && _client.isRequestPending(); idx++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      _client.updateBoards();
+    }
+  };
+
+  _acceptRefresh = false;
+  mock::advanceClock(250 * 1000);
+  renew();
+  EXPECT_EQ(1u, _numRefreshs);
+
+  _acceptRefresh = true;
+  mock::advanceClock(AUTODARTS_TOKEN_RENEW_MARGIN / 2);
+  renew();
+  EXPECT_EQ(2u, _numRefreshs);
+  EXPECT_EQ(1u, _numLogins);
+}
+
+// The JSON of token and board list ends before the last chunk, which has to be read
+// before the next request goes out on the same connection
+TEST_F(Keycloak, ChunkedBodyIsReadToItsEnd) {
+  _chunked = true;
+  mock::resetLog();
+  mock::setLogCapture(true);
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  mock::advanceClock(250 * 1000);
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret", true));
+  mock::setLogCapture(false);
+
+  EXPECT_EQ(1u, _numLogins);
+  EXPECT_EQ(2u, _numRefreshs);
+  EXPECT_NE(nullptr, _client.getBoard(_client.findBoard(BOARD_ID)));
+  // One handshake for keycloak and one for the api, no request had to be repeated
+  EXPECT_EQ(2u, _client.getNumHandshakes());
+  EXPECT_EQ(4u, _client.getNumReusedRequests());
+  EXPECT_EQ(6u, _http.getNumRequests());
+  EXPECT_EQ(0u, mock::logCount(mock::LOG_ERROR));
+}
+
+namespace {
+
+  const char* APP_BOARD_ID = "0b9e2d47-5c1a-4f63-8e7d-2a4c6f8b0d15";
+
+  // Counts the values written per key
+  class CountingStorage : public PreferencesStorage {
+  public:
+    bool write(const char* key, const String& value) override {
+      _writes[key]++;
+      return PreferencesStorage::write(key, value);
+    }
+
+    bool writeStream(const char* key, const Writer& writer) override {
+      _writes[key]++;
+      return PreferencesStorage::writeStream(key, writer);
+    }
+
+    uint32_t getWrites(const char* key) {
+      return _writes[key];
+    }
+
+  private:
+    std::map<std::string, uint32_t> _writes;
+  };
+
+  // An account whose board list changes between requests. Every board has its own
+  // board manager, so boards that are removed still have an open connection.
+  class Account : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      _client.setCACert(mock::ROOT_CA);
+      Preferences::reset();
+      _http.on("POST", AUTODARTS_AUTH_KEYCLOAK_URL, [](const mock::HttpRequest&) {
+        mock::HttpResponse response;
+        response.body = tokenBody();
+        return response;
+      });
+      _http.on("GET", AUTODARTS_API_BOARDS_URL, [this](const mock::HttpRequest&) {
+        mock::HttpResponse response;
+        response.body = "[";
+        for (size_t idx = 0; idx < _list.size(); idx++) {
+          response.body += std::string(idx > 0 ? "," : "") + entry(_list[idx]);
+        }
+        response.body += "]";
+        response.headers.push_back({"ETag", "\"" + std::to_string(_list.size()) + "\""});
+        return response;
+      });
+      _client.setStorage(&_storage);
+      _client.onThrow([this](const Board&, uint8_t, const Throw&) { _numThrows++; });
+    }
+
+    void TearDown() override {
+      mock::setWallClock(true);
+      mock::setManualClock(false);
+    }
+
+    static std::string id(uint32_t idx) {
+      char id[40];
+      snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+      return id;
+    }
+
+    static std::string ip(uint32_t idx) {
+      return "10.0.3." + std::to_string(idx + 1);
+    }
+
+    static std::string entry(uint32_t idx) {
+      return "{\"id\":\"" + id(idx) + "\",\"name\":\"Board " + std::to_string(idx) + "\",\"ip\":\"" + ip(idx) +
+             "\",\"version\":\"0.22.0\"}";
+    }
+
+    bool has(const std::string& id) const {
+      return _client.getBoard(_client.findBoard(id.c_str())) != nullptr;
+    }
+
+    // Opens all boards and leaves a few frames pending on every connection
+    void openAll() {
+      _client.openBoards(true);
+      for (uint32_t start = millis(); millis() - start < 1000;) {
+        _client.updateBoards();
+        bool open = true;
+        for (uint32_t idx : {0u, 1u, 2u}) {
+          open = open && (!has(id(idx)) || _client.getBoard(_client.findBoard(id(idx).c_str()))->isOpen());
+        }
+        if (open) {
+          break;
+        }
+      }
+      for (mock::FakeWebSocketServer* server : {&_board0, &_board1, &_board2}) {
+        for (const session::Frame& frame : _generator.generate(1)) {
+          server->push(frame.json);
+        }
+      }
+    }
+
+    mock::FakeHttpServer _http;
+    mock::FakeWebSocketServer _board0{ip(0).c_str(), AUTODARTS_BOARD_PORT};
+    mock::FakeWebSocketServer _board1{ip(1).c_str(), AUTODARTS_BOARD_PORT};
+    mock::FakeWebSocketServer _board2{ip(2).c_str(), AUTODARTS_BOARD_PORT};
+    mock::FakeWebSocketServer _app{"10.0.3.100", AUTODARTS_BOARD_PORT};
+    session::Generator _generator{5};
+    CountingStorage _storage;
+    Client _client;
+    std::vector<uint32_t> _list{0, 1, 2};
+    uint32_t _numThrows = 0;
+  };
+
+} // namespace
+
+TEST_F(Account, RemovesOnlyBoardsThatLeftTheAccount) {
+  _client.addBoard("App", APP_BOARD_ID, "0.22.0", "10.0.3.100");
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  ASSERT_EQ(4u, _client.getNumBoards());
+  openAll();
+
+  _list = {1};
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  EXPECT_FALSE(has(id(0)));
+  EXPECT_TRUE(has(id(1)));
+  EXPECT_FALSE(has(id(2)));
+  EXPECT_TRUE(has(APP_BOARD_ID));
+  for (uint32_t idx = 0; idx < 10; idx++) {
+    _client.updateBoards();
+  }
+
+  // The application board is not taken for an account board after a restart
+  Client restored;
+  restored.setCACert(mock::ROOT_CA);
+  restored.setStorage(&_storage);
+  ASSERT_TRUE(restored.restore(false));
+  EXPECT_EQ(2u, restored.getNumBoards());
+  _list = {};
+  EXPECT_EQ(HTTP_CODE_OK, restored.autoDetectBoards("user", "secret"));
+  EXPECT_EQ(1u, restored.getNumBoards());
+  EXPECT_NE(nullptr, restored.getBoard(restored.findBoard(APP_BOARD_ID)));
+}
+
+// An entry that can not be read keeps all boards, but the list read is still stored
+// and asked for in full next time
+TEST_F(Account, PartialListKeepsBoardsAndIsStored) {
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  _http.on("GET", AUTODARTS_API_BOARDS_URL, [](const mock::HttpRequest&) {
+    mock::HttpResponse response;
+    response.body = "[" + entry(1) + ",{\"id\":\"broken\",\"name\":\"Broken\",\"version\":\"0.22.0\"x}," + entry(3) + "]";
+    response.headers.push_back({"ETag", "\"partial\""});
+    return response;
+  });
+  mock::setLogCapture(true);
+  EXPECT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret", true));
+  mock::setLogCapture(false);
+  EXPECT_EQ(4u, _client.getNumBoards());
+
+  Client restored;
+  restored.setCACert(mock::ROOT_CA);
+  restored.setStorage(&_storage);
+  ASSERT_TRUE(restored.restore(false));
+  EXPECT_EQ(4u, restored.getNumBoards());
+  EXPECT_TRUE(restored.getBoard(restored.findBoard(id(3).c_str())) != nullptr);
+
+  _list = {3};
+  _http.on("GET", AUTODARTS_API_BOARDS_URL, [this](const mock::HttpRequest& request) {
+    EXPECT_EQ(0u, request.headers.count("if-none-match"));
+    mock::HttpResponse response;
+    response.body = "[" + entry(3) + "]";
+    return response;
+  });
+  EXPECT_EQ(HTTP_CODE_OK, restored.autoDetectBoards("user", "secret", true));
+  EXPECT_EQ(1u, restored.getNumBoards());
+}
+
+// Renewing the token only stores the token, the board list is only written again when it changed
+TEST_F(Account, OnlyChangesAreStored) {
+  mock::setManualClock(true);
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  EXPECT_EQ(1u, _storage.getWrites("token"));
+  EXPECT_EQ(1u, _storage.getWrites("boardlist"));
+  EXPECT_EQ(1u, _storage.getWrites("etag"));
+
+  // The same list again
+  mock::advanceClock(1000);
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret", true));
+  EXPECT_EQ(2u, _storage.getWrites("token"));
+  EXPECT_EQ(1u, _storage.getWrites("boardlist"));
+  EXPECT_EQ(1u, _storage.getWrites("etag"));
+
+  mock::advanceClock(1000);
+  ASSERT_TRUE(_client.renewAccessTokenAsync());
+  for (uint32_t idx = 0; idx < 5000 && _client.isRequestPending(); idx++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    _client.updateBoards();
+  }
+  ASSERT_FALSE(_client.isRequestPending());
+  EXPECT_EQ(3u, _storage.getWrites("token"));
+  EXPECT_EQ(1u, _storage.getWrites("boardlist"));
+
+  // A board left the account, the token is still valid
+  _list = {0, 1};
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  EXPECT_EQ(3u, _storage.getWrites("token"));
+  EXPECT_EQ(2u, _storage.getWrites("boardlist"));
+  EXPECT_EQ(2u, _storage.getWrites("etag"));
+
+  Client restored;
+  restored.setCACert(mock::ROOT_CA);
+  restored.setStorage(&_storage);
+  ASSERT_TRUE(restored.restore(false));
+  EXPECT_EQ(2u, restored.getNumBoards());
+}
+
+// The sketch does not wait for SNTP, the refresh token has to be stored before the clock is set
+TEST_F(Account, TokenIsStoredWithoutClock) {
+  mock::setManualClock(true);
+  mock::setWallClock(false);
+  ASSERT_LE(time(nullptr), AUTODARTS_MIN_EPOCH);
+  ASSERT_EQ(HTTP_CODE_OK, _client.autoDetectBoards("user", "secret"));
+  EXPECT_EQ(1u, _storage.getWrites("token"));
+
+  String value;
+  ASSERT_TRUE(_storage.read("token", value));
+  EXPECT_NE(nullptr, strstr(value.c_str(), "\"refresh_token\":\"refresh\""));
+  EXPECT_EQ(nullptr, strstr(value.c_str(), "expires_at"));
+
+  // After a restart the stored refresh token is used instead of a login
+  std::string grant;
+  _http.on("POST", AUTODARTS_AUTH_KEYCLOAK_URL, [&grant](const mock::HttpRequest& request) {
+    grant = request.body;
+    mock::HttpResponse response;
+    response.body = tokenBody();
+    return response;
+  });
+  Client restored;
+  restored.setCACert(mock::ROOT_CA);
+  restored.setStorage(&_storage);
+  ASSERT_TRUE(restored.restore(false));
+  ASSERT_TRUE(restored.renewAccessTokenAsync());
+  for (uint32_t idx = 0; idx < 5000 && restored.isRequestPending(); idx++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    restored.updateBoards();
+  }
+  ASSERT_FALSE(restored.isRequestPending());
+  EXPECT_NE(std::string::npos, grant.find("grant_type=refresh_token&refresh_token=refresh"));
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <AutodartsClient.h>
+#include <AutodartsMetrics.h>
+
+using namespace autodarts;
+
+namespace {
+
+  // Collects what is printed
+  class StringPrint : public Print {
+  public:
+    size_t write(uint8_t c) override {
+      text += static_cast<char>(c);
+      return 1;
+    }
+
+    std::string text;
+  };
+
+  // Keeps every write of more than one byte on its own
+  class ChunkPrint : public StringPrint {
+  public:
+    size_t write(uint8_t c) override {
+      return StringPrint::write(c);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+      chunks.emplace_back(reinterpret_cast<const char*>(buffer), size);
+      text.append(chunks.back());
+      return size;
+    }
+
+    std::vector<std::string> chunks;
+  };
+
+  size_t count(const std::string& text, const std::string& part) {
+    size_t count = 0;
+    for (size_t pos = text.find(part); pos != std::string::npos; pos = text.find(part, pos + 1)) {
+      count++;
+    }
+    return count;
+  }
+
+} // namespace
+
+// Two hours of one second callbacks, more than the 71 minutes 32 bits of microseconds hold.
+// The sum wraps like a counter that was reset, the count goes on.
+TEST(Metrics, HistogramSumWraps) {
+  MetricHistogram histogram;
+  for (uint32_t idx = 0; idx < 7200; idx++) {
+    histogram.record(1000000);
+  }
+  EXPECT_EQ(7200u, histogram.getCount());
+  EXPECT_EQ(static_cast<uint32_t>(7200000000ull), histogram.getSum());
+
+  StringPrint out;
+  PrometheusWriter writer(out);
+  writer.histogram("autodarts_callback_seconds", "", histogram);
+  EXPECT_NE(std::string::npos, out.text.find("autodarts_callback_seconds_sum 2905.032704\r\n")) << out.text;
+  EXPECT_NE(std::string::npos, out.text.find("autodarts_callback_seconds_count 7200\r\n")) << out.text;
+}
+
+TEST(Metrics, HistogramBuckets) {
+  MetricHistogram histogram;
+  histogram.record(0);
+  histogram.record(1);
+  histogram.record(1000);
+  histogram.record(UINT32_MAX);
+  EXPECT_EQ(1u, histogram.getBucket(0));
+  EXPECT_EQ(1u, histogram.getBucket(1));
+  EXPECT_EQ(1u, histogram.getBucket(10));
+  EXPECT_EQ(1u, histogram.getBucket(MetricHistogram::NUM_BUCKETS - 1));
+  EXPECT_EQ(0u, histogram.getBucket(MetricHistogram::NUM_BUCKETS));
+  EXPECT_EQ(1000u, histogram.getSum());
+}
+
+// The samples of the boards are written one board at a time, every metric stays one group
+TEST(Metrics, BoardsAreWrittenOneAtATime) {
+  const uint32_t BOARDS = 3;
+  Client client;
+  for (uint32_t idx = 0; idx < BOARDS; idx++) {
+    char id[40];
+    snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+    client.addBoard("Board " + String(idx), id, "0.22.0", "10.0.8." + String(idx + 1));
+  }
+  ChunkPrint out;
+  client.writeMetrics(out);
+
+  for (const char* name : {"autodarts_frames_total", "autodarts_parse_errors_total", "autodarts_connects_total", "autodarts_timeouts_total"}) {
+    EXPECT_EQ(1u, count(out.text, std::string("# TYPE ") + name + " ")) << name;
+    size_t first = out.text.find(std::string(name) + "{");
+    size_t last = out.text.rfind(std::string(name) + "{");
+    ASSERT_NE(std::string::npos, first);
+    // No other metric between the samples of the first and the last board
+    EXPECT_EQ(std::string::npos, out.text.substr(first, last - first).find("# TYPE")) << name;
+  }
+  size_t boards = 0;
+  for (const std::string& chunk : out.chunks) {
+    size_t ids = 0;
+    for (uint32_t idx = 0; idx < BOARDS; idx++) {
+      ids += chunk.find("-8000-00000000000" + std::to_string(idx + 1)) != std::string::npos ? 1 : 0;
+    }
+    EXPECT_LE(ids, 1u);
+    boards += ids;
+  }
+  EXPECT_EQ(4 * BOARDS, boards);
+}
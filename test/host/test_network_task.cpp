@@ -0,0 +1,321 @@
+// Stress tests of the network task: the boards are polled by a std::thread, the frames are
+// pushed by another and the callbacks run on the test thread in updateBoards(). Build with
+// -DAUTODARTS_SANITIZE=thread or address to check the locking and the board lifetimes.
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+
+#include <AutodartsClient.h>
+#include <FakeWebSocketServer.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  struct BoardSession {
+    std::unique_ptr<mock::FakeWebSocketServer> server;
+    Client::BoardHandle handle;
+    const Board* board;
+    std::vector<session::Frame> frames;
+  };
+
+  class NetworkTask : public ::testing::Test {
+  protected:
+    // The board is only read in callbacks, the network task may change it at any other time
+    void SetUp() override {
+      _client.onConnectionChange([this](const Board& board) {
+        if (board.isOpen()) {
+          _open.insert(&board);
+        }
+        else {
+          _open.erase(&board);
+        }
+      });
+    }
+
+    void TearDown() override {
+      _client.stopNetworkTask();
+    }
+
+    void addBoards(uint32_t numBoards, uint32_t turns) {
+      for (uint32_t idx = 0; idx < numBoards; idx++) {
+        BoardSession session;
+        String address = "10.0.1." + String(idx + 10);
+        char id[40];
+        snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+        session.server.reset(new mock::FakeWebSocketServer(address, AUTODARTS_BOARD_PORT));
+        session.handle = _client.addBoard("Board " + String(idx), id, "0.22.0", address);
+        session.board = _client.getBoard(session.handle);
+        session::Generator generator(idx + 1);
+        session.frames = generator.generate(turns);
+        _sessions.push_back(std::move(session));
+      }
+    }
+
+    // Polls until every board is open, the network task opens them
+    bool waitOpen() {
+      _client.openBoards(true);
+      uint32_t start = millis();
+      while (millis() - start < 5000) {
+        _client.updateBoards();
+        if (_open.size() == _sessions.size()) {
+          return true;
+        }
+        delay(1);
+      }
+      return false;
+    }
+
+    // Pushes the frames of all boards, a few at a time so the network task keeps up
+    std::thread produce() {
+      return std::thread([this]() {
+        for (size_t idx = 0;; idx++) {
+          bool pending = false;
+          for (BoardSession& session : _sessions) {
+            if (idx < session.frames.size()) {
+              session.server->push(session.frames[idx].json);
+              pending = true;
+            }
+          }
+          if (!pending) {
+            return;
+          }
+          if (idx % 8 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+          }
+        }
+      });
+    }
+
+    bool delivered() {
+      for (BoardSession& session : _sessions) {
+        if (session.server->getPending() > 0) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    Client _client;
+    std::vector<BoardSession> _sessions;
+    std::set<const Board*> _open;
+  };
+
+} // namespace
+
+TEST_F(NetworkTask, DeliversEveryThrowOnTheCallingThread) {
+  const uint32_t turns = 30;
+  addBoards(4, turns);
+  std::map<const Board*, uint32_t> throws;
+  std::thread::id caller = std::this_thread::get_id();
+  bool otherThread = false;
+  uint32_t inconsistent = 0;
+  _client.onThrow([&](const Board& board, uint8_t, const Throw&) {
+    throws[&board]++;
+    otherThread |= std::this_thread::get_id() != caller;
+  });
+  // Reads the board while the network task keeps parsing frames of it
+  _client.onData([&](const Board& board) {
+    const Detector& detector = board.getDetector();
+    // Between the dart pre-scan and the full parse of a frame the darts are ahead of numThrows
+    int16_t numThrows = detector.getNumThrows();
+    if (detector.getNumStoredThrows() > 3 || (numThrows >= 0 && numThrows < detector.getNumStoredThrows())) {
+      inconsistent++;
+    }
+    const CameraSystem& cameras = detector.getCameraSystem();
+    for (uint8_t idx = 0; idx < cameras.getNumCameras(); idx++) {
+      inconsistent += cameras[idx].getFPS() > AUTODARTS_CAMERA_MAX_FPS;
+    }
+  });
+  ASSERT_TRUE(_client.startNetworkTask());
+  ASSERT_TRUE(waitOpen());
+
+  std::thread producer = produce();
+  uint32_t start = millis();
+  while (millis() - start < 20000) {
+    _client.updateBoards();
+    if (!producer.joinable() || (delivered() && throws.size() == _sessions.size())) {
+      bool done = true;
+      for (BoardSession& session : _sessions) {
+        done &= throws[session.board] >= 3 * turns;
+      }
+      if (done) {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  producer.join();
+  _client.stopNetworkTask();
+
+  EXPECT_EQ(0u, _client.getDroppedNotifications());
+  EXPECT_FALSE(otherThread);
+  EXPECT_EQ(0u, inconsistent);
+  for (BoardSession& session : _sessions) {
+    EXPECT_EQ(3 * turns, throws[session.board]) << session.board->getName().c_str();
+  }
+}
+
+// No callback may reach a board after deleteBoard() returned, including the
+// connection change raised while the open websocket is torn down
+TEST_F(NetworkTask, DeleteBoardWhileFramesArrive) {
+  addBoards(4, 20);
+  std::set<const Board*> deleted;
+  uint32_t late = 0;
+  uint32_t closed = 0;
+  _client.onData([&](const Board& board) {
+    late += deleted.count(&board);
+  });
+  _client.onConnectionChange([&](const Board& board) {
+    late += deleted.count(&board);
+    closed += !board.isOpen();
+  });
+  _client.onThrow([&](const Board& board, uint8_t, const Throw&) {
+    late += deleted.count(&board);
+  });
+  ASSERT_TRUE(_client.startNetworkTask());
+  ASSERT_TRUE(waitOpen());
+
+  std::thread producer = produce();
+  for (BoardSession& session : _sessions) {
+    for (uint32_t idx = 0; idx < 50; idx++) {
+      _client.updateBoards();
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    _client.deleteBoard(session.handle);
+    deleted.insert(session.board);
+  }
+  for (uint32_t idx = 0; idx < 50; idx++) {
+    _client.updateBoards();
+    delay(1);
+  }
+  producer.join();
+
+  EXPECT_EQ(0u, _client.getNumBoards());
+  EXPECT_EQ(0u, late);
+  EXPECT_EQ(_sessions.size(), closed);
+}
+
+TEST_F(NetworkTask, DeleteOpenBoardWithoutTask) {
+  addBoards(1, 1);
+  const Board* board = _sessions[0].board;
+  ASSERT_TRUE(waitOpen());
+  uint32_t calls = 0;
+  _client.onConnectionChange([&](const Board& changed) {
+    EXPECT_EQ(board, &changed);
+    EXPECT_FALSE(changed.isOpen());
+    calls++;
+  });
+
+  _client.deleteBoard(_sessions[0].handle);
+  EXPECT_EQ(1u, calls);
+  _client.updateBoards();
+  EXPECT_EQ(1u, calls);
+}
+
+// While the network task blocks in the connect of one board, the registry stays free for the
+// calling task and the other boards
+TEST_F(NetworkTask, BlockedConnectDoesNotHoldTheRegistry) {
+  addBoards(2, 0);
+  _sessions[1].server->setConnectDelay(1000);
+  ASSERT_TRUE(_client.startNetworkTask());
+  _client.openBoards(true);
+  delay(100);
+
+  uint32_t start = millis();
+  Client::BoardHandle handle = _client.addBoard("Board 2", "00000000-0000-4000-8000-000000000003", "0.22.0", "10.0.1.30");
+  _client.openBoard(_sessions[0].handle, true);
+  _client.updateBoards();
+  _client.deleteBoard(handle);
+  EXPECT_LT(millis() - start, 500u);
+
+  ASSERT_TRUE(waitOpen());
+}
+
+// Force reopening and erasing boards closes them on the calling thread while the network task
+// keeps queueing the frames of the others, the queue must still see a single producer
+TEST_F(NetworkTask, ReopenAndDeleteBoardsWhileFramesArrive) {
+  addBoards(4, 60);
+  std::set<const Board*> deleted;
+  uint32_t late = 0;
+  uint32_t reopened = 0;
+  uint32_t closed = 0;
+  _client.onData([&](const Board& board) {
+    late += deleted.count(&board);
+  });
+  _client.onConnectionChange([&](const Board& board) {
+    late += deleted.count(&board);
+    if (board.isOpen()) {
+      _open.insert(&board);
+    }
+    else {
+      _open.erase(&board);
+      closed++;
+    }
+  });
+  ASSERT_TRUE(_client.startNetworkTask());
+  ASSERT_TRUE(waitOpen());
+
+  std::thread producer = produce();
+  for (BoardSession& session : _sessions) {
+    for (uint32_t idx = 0; idx < 10; idx++) {
+      // Only open boards raise a connection change when they are closed
+      for (BoardSession& other : _sessions) {
+        if (_open.count(other.board) > 0) {
+          _client.openBoard(other.handle, true);
+          reopened++;
+        }
+      }
+      uint32_t start = millis();
+      while (_open.size() + deleted.size() < _sessions.size() && millis() - start < 1000) {
+        _client.updateBoards();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+    }
+    _client.deleteBoard(session.handle);
+    deleted.insert(session.board);
+  }
+  producer.join();
+  _client.updateBoards();
+
+  EXPECT_GT(reopened, 40u);
+  EXPECT_EQ(reopened + _sessions.size(), closed);
+  EXPECT_EQ(0u, _client.getNumBoards());
+  EXPECT_EQ(0u, late);
+  EXPECT_EQ(0u, _client.getDroppedNotifications());
+}
+
+// The scheduler reopens dropped boards on the network task while the calling task reads their
+// connection under the board lock
+TEST_F(NetworkTask, ReconnectWhileBoardsAreRead) {
+  addBoards(4, 0);
+  ReconnectScheduler::Policy policy;
+  policy.minDelay = 10;
+  policy.maxDelay = 50;
+  _client.setReconnectPolicy(policy);
+  ASSERT_TRUE(_client.startNetworkTask());
+  ASSERT_TRUE(waitOpen());
+
+  uint32_t seen = 0;
+  for (uint32_t round = 0; round < 20; round++) {
+    for (BoardSession& session : _sessions) {
+      session.server->dropAll();
+    }
+    uint32_t start = millis();
+    while (millis() - start < 100 || (_open.size() < _sessions.size() && millis() - start < 5000)) {
+      for (BoardSession& session : _sessions) {
+        std::lock_guard<std::recursive_mutex> lock(session.board->getMutex());
+        seen += session.board->isOpen() || session.board->isConnecting() ? 1 : 0;
+      }
+      _client.updateBoards();
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+
+  EXPECT_GT(seen, 0u);
+  EXPECT_EQ(_sessions.size(), _open.size());
+  EXPECT_GE(_client.getNumConnectAttempts(), 4 * 20u);
+}
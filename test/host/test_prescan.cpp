@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <AutodartsClient.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+
+  struct Raised {
+    uint8_t idx;
+    int8_t  number;
+    int8_t  multiplier;
+    bool    fast; // Raised by preScan() rather than the full parse
+  };
+
+  class Recorder : public BoardListener {
+  public:
+    void onThrow(const Board&, uint8_t idx, const Throw& dart) override {
+      raised.push_back(Raised{idx, dart.getNumber(), dart.getMultiplier(), fast});
+    }
+
+    bool fast = false;
+    std::vector<Raised> raised;
+  };
+
+  // Darts of a state message, in the order the board lists them
+  std::vector<session::Dart> dartsOf(const std::string& json) {
+    std::vector<session::Dart> darts;
+    DynamicJsonDocument doc(4096);
+    deserializeJson(doc, json);
+    for (JsonObjectConst item : doc["data"]["throws"].as<JsonArrayConst>()) {
+      darts.push_back(session::Dart{item["segment"]["number"], item["segment"]["multiplier"], 0, 0});
+    }
+    return darts;
+  }
+
+  class PreScan : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      _sink.board = &_board;
+      _sink.listener = &_recorder;
+      _detector.setSink(&_sink);
+    }
+
+    // Same steps as Board::receive(): the fast path on the raw payload, then the full parse
+    ChangeMask receive(const std::string& json) {
+      std::vector<char> payload(json.begin(), json.end());
+      payload.push_back('\0');
+      _recorder.fast = true;
+      ChangeMask changes = _detector.preScan(payload.data(), json.length());
+      _recorder.fast = false;
+      DynamicJsonDocument doc(4096);
+      EXPECT_FALSE(deserializeJson(doc, payload.data(), json.length()));
+      return changes | _detector.fromJson(doc.as<JsonObjectConst>());
+    }
+
+    Board     _board{"Board", BOARD_ID, "0.22.0", "10.0.0.1"};
+    Recorder  _recorder;
+    EventSink _sink;
+    Detector  _detector;
+  };
+
+} // namespace
+
+// Every dart of a session is raised once, from the fast path, with the values of the message
+TEST_F(PreScan, SessionRaisesEveryDartOnce) {
+  const uint32_t turns = 50;
+  std::vector<session::Frame> frames = session::Generator(23).generate(turns);
+  std::vector<Raised> expected;
+  for (const session::Frame& frame : frames) {
+    if (frame.json.find("\"Throw detected\"") != std::string::npos) {
+      std::vector<session::Dart> darts = dartsOf(frame.json);
+      const session::Dart& dart = darts.back();
+      expected.push_back(Raised{static_cast<uint8_t>(darts.size() - 1), static_cast<int8_t>(dart.number),
+                                static_cast<int8_t>(dart.multiplier), true});
+    }
+    receive(frame.json);
+  }
+
+  ASSERT_EQ(3 * turns, expected.size());
+  ASSERT_EQ(expected.size(), _recorder.raised.size());
+  for (size_t idx = 0; idx < expected.size(); idx++) {
+    EXPECT_EQ(expected[idx].idx, _recorder.raised[idx].idx) << idx;
+    EXPECT_EQ(expected[idx].number, _recorder.raised[idx].number) << idx;
+    EXPECT_EQ(expected[idx].multiplier, _recorder.raised[idx].multiplier) << idx;
+    EXPECT_TRUE(_recorder.raised[idx].fast) << idx;
+  }
+}
+
+// The full parse finds the dart stored by the fast path, a repeated message raises nothing
+TEST_F(PreScan, DuplicatesAreSuppressed) {
+  std::vector<session::Dart> darts = {{20, 3, 0.1f, 0.2f}};
+  std::string first = session::state("Throw", "Throw detected", darts);
+  EXPECT_TRUE(receive(first) & Change::THROWS);
+  ASSERT_EQ(1u, _recorder.raised.size());
+
+  EXPECT_FALSE(receive(first) & Change::THROWS);
+  std::vector<char> payload(first.begin(), first.end());
+  EXPECT_EQ(Change::NONE, _detector.preScan(payload.data(), payload.size()));
+
+  // The takeout lists the same darts without a throw detected event
+  EXPECT_FALSE(receive(session::state("Takeout in progress", "Takeout started", darts)) & Change::THROWS);
+  EXPECT_EQ(1u, _recorder.raised.size());
+  EXPECT_EQ(1u, _detector.getNumStoredThrows());
+}
+
+// After the takeout the first dart of the next visit is raised at index 0
+TEST_F(PreScan, TakeoutStartsNewVisit) {
+  std::vector<session::Dart> darts = {{20, 1, 0, 0}, {5, 1, 0, 0}, {1, 2, 0, 0}};
+  for (size_t count = 1; count <= darts.size(); count++) {
+    receive(session::state("Throw", "Throw detected", std::vector<session::Dart>(darts.begin(), darts.begin() + count)));
+  }
+  receive(session::state("Takeout in progress", "Takeout started", darts));
+  receive(session::state("Throw", "Takeout finished", {}));
+  EXPECT_EQ(0u, _detector.getNumStoredThrows());
+
+  receive(session::state("Throw", "Throw detected", {{19, 3, 0, 0}}));
+  ASSERT_EQ(4u, _recorder.raised.size());
+  EXPECT_EQ(0, _recorder.raised[3].idx);
+  EXPECT_EQ(19, _recorder.raised[3].number);
+  EXPECT_TRUE(_recorder.raised[3].fast);
+}
+
+// Without the takeout, the shorter list still starts a new visit on the fast path
+TEST_F(PreScan, MissedTakeoutStartsNewVisit) {
+  std::vector<session::Dart> darts = {{20, 1, 0, 0}, {5, 1, 0, 0}, {1, 2, 0, 0}};
+  for (size_t count = 1; count <= darts.size(); count++) {
+    receive(session::state("Throw", "Throw detected", std::vector<session::Dart>(darts.begin(), darts.begin() + count)));
+  }
+  receive(session::state("Throw", "Throw detected", {{19, 3, 0, 0}}));
+
+  ASSERT_EQ(4u, _recorder.raised.size());
+  EXPECT_EQ(0, _recorder.raised[3].idx);
+  EXPECT_EQ(19, _recorder.raised[3].number);
+  EXPECT_TRUE(_recorder.raised[3].fast);
+  EXPECT_EQ(1u, _detector.getNumStoredThrows());
+}
+
+// Brackets in strings do not end the array, a truncated array leaves the dart to the full parse
+TEST_F(PreScan, OnlyCompleteArraysAreScanned) {
+  std::string json = session::state("Throw", "Throw detected", {{20, 1, 0, 0}});
+  std::string tricky = json;
+  tricky.replace(tricky.find("\"S20\""), 5, "\"S]20[\"");
+  receive(tricky);
+  ASSERT_EQ(1u, _recorder.raised.size());
+  EXPECT_TRUE(_recorder.raised[0].fast);
+
+  std::string truncated = session::state("Throw", "Throw detected", {{20, 1, 0, 0}, {5, 1, 0, 0}});
+  truncated.resize(truncated.find("]}}"));
+  std::vector<char> payload(truncated.begin(), truncated.end());
+  EXPECT_EQ(Change::NONE, _detector.preScan(payload.data(), payload.size()));
+  EXPECT_EQ(1u, _recorder.raised.size());
+}
+
+// A board times every dart of the session from receive to parse
+TEST(PreScanLatency, BoardTimesEveryDart) {
+  Client client;
+  uint32_t throws = 0;
+  client.onThrow([&throws](const Board&, uint8_t, const Throw&) { throws++; });
+  Board* board = client.getBoard(client.addBoard("Board", BOARD_ID, "0.22.0", "10.0.0.1"));
+  for (const session::Frame& frame : session::Generator(29).generate(10)) {
+    std::vector<char> payload(frame.json.begin(), frame.json.end());
+    payload.push_back('\0');
+    board->receive(payload.data(), frame.json.length());
+    EXPECT_LE(board->getReceivedAt(), micros());
+  }
+
+  EXPECT_EQ(30u, throws);
+  EXPECT_EQ(throws, client.getThrowLatency(LatencyStage::PARSE).getCount());
+  EXPECT_EQ(throws, client.getThrowLatency(LatencyStage::TOTAL).getCount());
+}
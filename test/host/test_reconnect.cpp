@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include <AutodartsClient.h>
+#include <FakeWebSocketServer.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const uint32_t BOARDS = 4;
+
+  String boardId(uint32_t idx) {
+    char id[40];
+    snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+    return id;
+  }
+
+  String boardIp(uint32_t idx) {
+    return "10.2.0." + String(idx + 1);
+  }
+
+  class Reconnect : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      Preferences::reset();
+      mock::setManualClock(true);
+      for (uint32_t idx = 0; idx < BOARDS; idx++) {
+        _servers.emplace_back(new mock::FakeWebSocketServer(boardIp(idx), AUTODARTS_BOARD_PORT));
+      }
+      _policy.maxConnecting = 1;
+    }
+
+    void TearDown() override {
+      mock::setManualClock(false);
+    }
+
+    void addBoards(Client& client) {
+      for (uint32_t idx = 0; idx < BOARDS; idx++) {
+        client.addBoard("Board " + String(idx), boardId(idx), "0.22.0", boardIp(idx));
+      }
+    }
+
+    // Runs the client for ms, the board managers send cam_stats every second like real ones
+    void run(Client& client, uint32_t ms) {
+      for (uint32_t elapsed = 0; elapsed < ms; elapsed += 10) {
+        client.updateBoards();
+        mock::advanceClock(10);
+        if (elapsed % 1000 == 0) {
+          for (auto& server : _servers) {
+            server->push(session::camStats(0, 30));
+          }
+        }
+      }
+    }
+
+    uint32_t numOpen(const Client& client) const {
+      uint32_t open = 0;
+      for (uint32_t idx = 0; idx < BOARDS; idx++) {
+        open += client.getBoard(client.findBoard(boardId(idx).c_str()))->isOpen() ? 1 : 0;
+      }
+      return open;
+    }
+
+    uint32_t numConnecting(const Client& client) const {
+      uint32_t connecting = 0;
+      for (uint32_t idx = 0; idx < BOARDS; idx++) {
+        connecting += client.getBoard(client.findBoard(boardId(idx).c_str()))->isConnecting() ? 1 : 0;
+      }
+      return connecting;
+    }
+
+    std::vector<std::unique_ptr<mock::FakeWebSocketServer>> _servers;
+    ReconnectScheduler::Policy _policy;
+    PreferencesStorage _storage;
+  };
+
+} // namespace
+
+// Added boards are spread over minDelay and wait for the handshake cap
+TEST_F(Reconnect, AddedBoardsAreCapped) {
+  Client client;
+  client.setReconnectPolicy(_policy);
+  addBoards(client);
+  client.openBoards();
+  client.updateBoards();
+  EXPECT_EQ(0u, client.getNumConnectAttempts());
+
+  mock::advanceClock(_policy.minDelay);
+  client.updateBoards();
+  EXPECT_EQ(1u, numConnecting(client));
+  EXPECT_EQ(1u, client.getNumConnectAttempts());
+}
+
+// Every controller of a venue restores its list at the same boot, so restored boards are
+// spread and capped like added ones
+TEST_F(Reconnect, RestoredBoardsAreCapped) {
+  Client stored;
+  stored.setStorage(&_storage);
+  addBoards(stored);
+  ASSERT_TRUE(stored.persist());
+
+  Client client;
+  client.setReconnectPolicy(_policy);
+  client.setStorage(&_storage);
+  ASSERT_TRUE(client.restore(true));
+  client.updateBoards();
+  EXPECT_EQ(0u, client.getNumConnectAttempts());
+
+  mock::advanceClock(_policy.minDelay);
+  client.updateBoards();
+  EXPECT_EQ(1u, numConnecting(client));
+  EXPECT_EQ(1u, client.getNumConnectAttempts());
+}
+
+// Boards that have been healthy since boot reopen without waiting for the others
+TEST_F(Reconnect, HealthyBoardsSkipSpreadAndCap) {
+  Client client;
+  client.setReconnectPolicy(_policy);
+  addBoards(client);
+  client.openBoards();
+  run(client, _policy.minDelay + _policy.healthyAfter + 1000);
+  ASSERT_EQ(BOARDS, numOpen(client));
+
+  client.openBoards(true);
+  client.updateBoards();
+  EXPECT_EQ(BOARDS, numConnecting(client));
+  EXPECT_EQ(2 * BOARDS, client.getNumConnectAttempts());
+}
+
+// A board that failed is no longer healthy, the next request waits again
+TEST_F(Reconnect, FailedBoardLosesFastPath) {
+  Client client;
+  client.setReconnectPolicy(_policy);
+  addBoards(client);
+  client.openBoards();
+  run(client, _policy.minDelay + _policy.healthyAfter + 1000);
+  ASSERT_EQ(BOARDS, numOpen(client));
+
+  // Every board retries after the drop and is refused, the cap lets all of them try
+  ReconnectScheduler::Policy outage = _policy;
+  outage.maxConnecting = BOARDS;
+  client.setReconnectPolicy(outage);
+  for (auto& server : _servers) {
+    server->setAccepting(false);
+    server->dropAll();
+  }
+  run(client, AUTODARTS_CONNECT_TIMEOUT + _policy.minDelay);
+  EXPECT_GE(client.getNumConnectAttempts(), 2 * BOARDS);
+
+  client.setReconnectPolicy(_policy);
+  client.openBoards(true);
+  client.updateBoards();
+  EXPECT_EQ(1u, numConnecting(client));
+}
+
+// A board that moved reconnects through the scheduler, one that was never opened stays closed
+TEST_F(Reconnect, MovedBoardReconnects) {
+  Client moved;
+  moved.setStorage(&_storage);
+  moved.addBoard("Board 0", boardId(0), "0.22.0", boardIp(1));
+  moved.addBoard("Board 2", boardId(2), "0.22.0", boardIp(3));
+  ASSERT_TRUE(moved.persist());
+
+  Client client;
+  client.setReconnectPolicy(_policy);
+  client.setStorage(&_storage);
+  addBoards(client);
+  Client::BoardHandle handle = client.findBoard(boardId(0).c_str());
+  client.openBoard(handle, true);
+  for (uint32_t idx = 0; idx < 10 && !client.getBoard(handle)->isOpen(); idx++) {
+    client.updateBoards();
+    mock::advanceClock(10);
+  }
+  ASSERT_TRUE(client.getBoard(handle)->isOpen());
+  EXPECT_EQ(1u, _servers[0]->getNumHandshakes());
+
+  ASSERT_TRUE(client.restore(false));
+  EXPECT_FALSE(client.getBoard(handle)->isOpen());
+  for (uint32_t idx = 0; idx < 10 && !client.getBoard(handle)->isOpen(); idx++) {
+    client.updateBoards();
+    mock::advanceClock(10);
+  }
+  EXPECT_TRUE(client.getBoard(handle)->isOpen());
+  EXPECT_EQ(1u, _servers[1]->getNumHandshakes());
+  EXPECT_EQ(2u, client.getNumConnectAttempts());
+  EXPECT_FALSE(client.getBoard(client.findBoard(boardId(2).c_str()))->isConnecting());
+  EXPECT_EQ(0u, _servers[3]->getNumHandshakes());
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <AutodartsRegistry.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* FIRST_ID  = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+  const char* SECOND_ID = "9d8c7b6a-5f4e-4d3c-b2a1-0f9e8d7c6b5a";
+
+  // A copy, gtest takes its arguments by reference
+  const BoardRegistry::Handle INVALID = BoardRegistry::INVALID;
+
+  BoardRegistry::BoardPtr board(const char* id) {
+    return BoardRegistry::BoardPtr(new Board("Board", id, "0.22.0", "10.0.7.1"));
+  }
+
+} // namespace
+
+// The handle of an erased board does not reach the board that reuses its slot
+TEST(Registry, ErasedHandleStaysInvalid) {
+  BoardRegistry registry;
+  BoardRegistry::Handle first = registry.insert(board(FIRST_ID));
+  ASSERT_NE(INVALID, first);
+  ASSERT_TRUE(registry.erase(first));
+
+  BoardRegistry::Handle second = registry.insert(board(SECOND_ID));
+  ASSERT_NE(INVALID, second);
+  EXPECT_EQ(BoardRegistry::slot(first), BoardRegistry::slot(second));
+  EXPECT_NE(first, second);
+  EXPECT_EQ(nullptr, registry.get(first));
+  EXPECT_FALSE(registry.erase(first));
+  EXPECT_EQ(String(SECOND_ID), registry.get(second)->getId());
+  EXPECT_EQ(second, registry.find(SECOND_ID));
+  EXPECT_EQ(second, registry.begin().handle());
+  EXPECT_EQ(second, registry.handleAt(BoardRegistry::slot(second)));
+}
+
+TEST(Registry, DuplicateIdIsRefused) {
+  BoardRegistry registry;
+  BoardRegistry::Handle first = registry.insert(board(FIRST_ID));
+  ASSERT_NE(INVALID, first);
+  EXPECT_EQ(INVALID, registry.insert(board(FIRST_ID)));
+  EXPECT_EQ(1u, registry.size());
+  EXPECT_EQ(first, registry.find(FIRST_ID));
+}
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include <AutodartsClient.h>
+#include <FakeWebSocketServer.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const uint32_t BOARDS = 8;
+
+  String boardId(uint32_t idx) {
+    char id[40];
+    snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+    return id;
+  }
+
+  void receive(Board& board, const std::string& json) {
+    std::vector<char> payload(json.begin(), json.end());
+    payload.push_back('\0');
+    board.receive(payload.data(), json.length());
+  }
+
+  // Messages of one board as a display sees them
+  struct Seen {
+    uint32_t states = 0;
+    uint32_t camStates = 0;
+    uint32_t camStats = 0;
+    int      numThrows = -1; // Of the last state
+  };
+
+  std::map<std::string, Seen> seenBy(const std::vector<std::string>& sent) {
+    std::map<std::string, Seen> seen;
+    for (const std::string& message : sent) {
+      DynamicJsonDocument json(4096);
+      EXPECT_FALSE(deserializeJson(json, message));
+      Seen& board = seen[json["board"].as<const char*>()];
+      Message::Type type = Message::fromString(json["type"].as<const char*>());
+      if (type == Message::Type::STATE) {
+        board.states++;
+        board.numThrows = json["data"]["numThrows"];
+      }
+      board.camStates += type == Message::Type::CAM_STATE ? 1 : 0;
+      board.camStats += type == Message::Type::CAM_STATS ? 1 : 0;
+    }
+    return seen;
+  }
+
+  class Relay : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      for (uint32_t idx = 0; idx < BOARDS; idx++) {
+        Board* board = _client.getBoard(_client.addBoard("Board " + String(idx), boardId(idx), "0.22.0", "10.0.6." + String(idx + 1)));
+        receive(*board, session::camState(true, true));
+        receive(*board, session::state("Throw", "Throw detected", {{20, 1, 0, 0}}));
+        for (int id = 0; id < 3; id++) {
+          receive(*board, session::camStats(id, 30));
+        }
+      }
+      _client.startRelay();
+      _server = WebSocketsServer::mockAt(AUTODARTS_RELAY_PORT);
+      ASSERT_NE(nullptr, _server);
+    }
+
+    void TearDown() override {
+      _client.stopRelay();
+    }
+
+    void update(uint32_t times) {
+      for (uint32_t idx = 0; idx < times; idx++) {
+        _client.updateBoards();
+      }
+    }
+
+    Client _client;
+    WebSocketsServer* _server = nullptr;
+  };
+
+} // namespace
+
+// The snapshot of 8 boards with 3 cameras is 40 messages, more than the queue holds
+TEST_F(Relay, SnapshotOfManyBoardsIsComplete) {
+  ASSERT_GT(BOARDS * 5, static_cast<uint32_t>(AUTODARTS_RELAY_QUEUE));
+  _server->mockSetCapacity(0, 2);
+  _server->mockConnect(0);
+  update(BOARDS * 5);
+
+  std::map<std::string, Seen> seen = seenBy(_server->mockSent(0));
+  ASSERT_EQ(BOARDS, seen.size());
+  for (uint32_t idx = 0; idx < BOARDS; idx++) {
+    const Seen& board = seen[boardId(idx).c_str()];
+    EXPECT_EQ(1u, board.states);
+    EXPECT_EQ(1u, board.camStates);
+    EXPECT_EQ(3u, board.camStats);
+  }
+  EXPECT_EQ(BOARDS * 5, _server->mockSent(0).size());
+  EXPECT_EQ(0u, _client.getRelay()->getDroppedMessages());
+}
+
+// Changes during the snapshot reach the subscriber once, and the last state it gets is the current one
+TEST_F(Relay, ChangesDuringSnapshotAreNotLost) {
+  _server->mockSetCapacity(0, 1);
+  _server->mockConnect(0);
+  update(3);
+  for (uint32_t idx = 0; idx < BOARDS; idx++) {
+    Board* board = _client.getBoard(_client.findBoard(boardId(idx).c_str()));
+    receive(*board, session::state("Throw", "Throw detected", {{20, 1, 0, 0}, {5, 1, 0, 0}}));
+  }
+  update(BOARDS * 10);
+
+  std::map<std::string, Seen> seen = seenBy(_server->mockSent(0));
+  ASSERT_EQ(BOARDS, seen.size());
+  for (uint32_t idx = 0; idx < BOARDS; idx++) {
+    const Seen& board = seen[boardId(idx).c_str()];
+    EXPECT_EQ(2, board.numThrows) << idx;
+    EXPECT_LE(board.states, 2u) << idx;
+    EXPECT_EQ(3u, board.camStats) << idx;
+  }
+  EXPECT_EQ(0u, _client.getRelay()->getDroppedMessages());
+}
+
+// With the network task the boards change while subscribers join, which the lock covers
+TEST_F(Relay, JoinWhileNetworkTaskRuns) {
+  mock::FakeWebSocketServer board(String("10.0.6.1"), AUTODARTS_BOARD_PORT);
+  Client::BoardHandle handle = _client.findBoard(boardId(0).c_str());
+  std::atomic<bool> open{false};
+  _client.onConnectionChange([&open](const Board& board) { open = board.isOpen(); });
+  ASSERT_TRUE(_client.startNetworkTask());
+  _client.openBoard(handle, true);
+  for (uint32_t start = millis(); !open && millis() - start < 2000;) {
+    _client.updateBoards();
+    delay(1);
+  }
+  ASSERT_TRUE(open);
+
+  std::vector<session::Frame> frames = session::Generator(31).generate(5);
+  for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++) {
+    _server->mockConnect(num);
+    for (size_t idx = num; idx < frames.size(); idx += WEBSOCKETS_SERVER_CLIENT_MAX) {
+      board.push(frames[idx].json);
+    }
+    update(20);
+  }
+  for (uint32_t start = millis(); board.getPending() > 0 && millis() - start < 2000;) {
+    _client.updateBoards();
+  }
+  update(BOARDS * 10);
+  _client.stopNetworkTask();
+
+  EXPECT_EQ(WEBSOCKETS_SERVER_CLIENT_MAX, _client.getRelay()->getNumSubscribers());
+  for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++) {
+    EXPECT_EQ(BOARDS, seenBy(_server->mockSent(num)).size()) << static_cast<int>(num);
+  }
+}
+
+// A change of one camera relays the stats of that camera only
+TEST_F(Relay, CameraStatsOfOneCamera) {
+  _server->mockConnect(0);
+  update(BOARDS * 5);
+  size_t before = _server->mockSent(0).size();
+
+  Board* board = _client.getBoard(_client.findBoard(boardId(0).c_str()));
+  receive(*board, session::camStats(1, 25));
+  receive(*board, session::camStats(2, 30));
+  update(2);
+
+  std::vector<std::string> sent = _server->mockSent(0);
+  ASSERT_EQ(before + 1, sent.size());
+  DynamicJsonDocument json(1024);
+  ASSERT_FALSE(deserializeJson(json, sent.back()));
+  EXPECT_STREQ("cam_stats", json["type"]);
+  EXPECT_EQ(1, json["data"]["id"].as<int>());
+  EXPECT_EQ(25, json["data"]["fps"].as<int>());
+}
+
+// Queued messages live in the buffers of the relay, a slow subscriber only loses old ones
+TEST_F(Relay, PublishDoesNotAllocate) {
+  _server->mockConnect(0);
+  update(BOARDS * 5);
+
+  // Every frame changes the board, nothing is sent meanwhile
+  std::vector<std::vector<char>> payloads;
+  for (uint32_t idx = 0; idx < AUTODARTS_RELAY_BUFFERS * 2; idx++) {
+    std::string json = idx % 2 == 0
+      ? session::state("Throw", "Throw detected", {{20, 1, 0, 0}, {static_cast<int>(idx % 20 + 1), 1, 0, 0}})
+      : session::camStats(idx / 2 % 3, 20 + idx / 6 % 2);
+    payloads.emplace_back(json.begin(), json.end());
+    payloads.back().push_back('\0');
+  }
+  Board* board = _client.getBoard(_client.findBoard(boardId(0).c_str()));
+  uint64_t before = mock::threadAllocations();
+  for (std::vector<char>& payload : payloads) {
+    board->receive(payload.data(), payload.size() - 1);
+  }
+  EXPECT_EQ(before, mock::threadAllocations());
+  EXPECT_GT(_client.getRelay()->getDroppedMessages(), 0u);
+
+  size_t sent = _server->mockSent(0).size();
+  update(AUTODARTS_RELAY_QUEUE);
+  EXPECT_EQ(sent + AUTODARTS_RELAY_QUEUE, _server->mockSent(0).size());
+  std::map<std::string, Seen> seen = seenBy(std::vector<std::string>(_server->mockSent(0).begin() + sent, _server->mockSent(0).end()));
+  EXPECT_EQ(2, seen[boardId(0).c_str()].numThrows);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <AutodartsClient.h>
+#include <Session.h>
+
+using namespace autodarts;
+
+namespace {
+
+  const char* BOARD_ID = "6c3f1a52-0d8e-4b7a-9f21-3e5d7c9b1a04";
+  const char* JOURNAL = "/journal";
+
+  class Replay : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      char directory[] = "/tmp/autodarts_replay_XXXXXX";
+      ASSERT_NE(nullptr, mkdtemp(directory));
+      _root = directory;
+      _fs.reset(new fs::FS(_root));
+      mock::setManualClock(true);
+      _handle = _client.addBoard("Board", BOARD_ID, "0.22.0", "10.0.8.1");
+      _client.onConnectionChange([this](const Board& board) { _changes += board.isOpen() ? 1 : 0; });
+    }
+
+    void TearDown() override {
+      mock::setManualClock(false);
+      _fs->remove(JOURNAL);
+      rmdir(_root.c_str());
+    }
+
+    // A connect followed by one frame of a session every interval ms
+    void recordSession(uint32_t frames, uint32_t interval) {
+      Journal journal;
+      ASSERT_TRUE(journal.begin(*_fs, JOURNAL));
+      const Uuid& id = board().getUuid();
+      journal.record(id, JournalRecord::CONNECTED);
+      std::vector<session::Frame> session = session::Generator(43).generate(frames);
+      for (uint32_t idx = 0; idx < frames && idx < session.size(); idx++) {
+        mock::advanceClock(interval);
+        const std::string& json = session[idx].json;
+        journal.record(id, JournalRecord::TEXT, reinterpret_cast<const uint8_t*>(json.data()), json.length());
+      }
+      journal.end();
+    }
+
+    Board& board() {
+      return *_client.getBoard(_handle);
+    }
+
+    std::string _root;
+    std::unique_ptr<fs::FS> _fs;
+    Client _client;
+    Client::BoardHandle _handle;
+    uint32_t _changes = 0;
+  };
+
+} // namespace
+
+// A replayed connect opens the board as alive, so the next update does not time it out
+TEST_F(Replay, ConnectedRecordResetsAlive) {
+  recordSession(0, 0);
+  mock::advanceClock(60000);
+  ASSERT_TRUE(_client.startReplay(*_fs, JOURNAL, false));
+  for (uint32_t idx = 0; idx < 3; idx++) {
+    _client.updateBoards();
+  }
+  EXPECT_TRUE(board().isOpen());
+  EXPECT_TRUE(board().isAlive());
+  EXPECT_EQ(1u, _changes);
+  EXPECT_EQ(0u, board().getMetrics().aliveTimeouts.get());
+
+  // Without further records the board times out like a live one
+  mock::advanceClock(10000);
+  _client.updateBoards();
+  EXPECT_FALSE(board().isOpen());
+  EXPECT_EQ(1u, board().getMetrics().aliveTimeouts.get());
+}
+
+// With the recorded timing the frames keep the board alive for longer than the timeout
+TEST_F(Replay, FramesKeepBoardAlive) {
+  recordSession(30, 2000);
+  ASSERT_TRUE(_client.startReplay(*_fs, JOURNAL, true));
+  for (uint32_t elapsed = 0; elapsed <= 31 * 2000 && _client.isReplaying(); elapsed += 100) {
+    _client.updateBoards();
+    mock::advanceClock(100);
+  }
+  EXPECT_FALSE(_client.isReplaying());
+  EXPECT_TRUE(board().isOpen());
+  EXPECT_EQ(0u, board().getMetrics().aliveTimeouts.get());
+}
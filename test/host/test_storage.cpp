@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <AutodartsClient.h>
+
+using namespace autodarts;
+
+namespace {
+
+  String boardId(uint32_t idx) {
+    char id[40];
+    snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012u", idx + 1);
+    return id;
+  }
+
+  void addBoards(Client& client, uint32_t count) {
+    for (uint32_t idx = 0; idx < count; idx++) {
+      String address = "10.1." + String(idx / 250) + "." + String(idx % 250 + 1);
+      client.addBoard("Board " + String(idx), boardId(idx), "0.22.0", address);
+    }
+  }
+
+  // Same ids, names and urls
+  void expectSameBoards(const Client& expected, const Client& actual) {
+    ASSERT_EQ(expected.getNumBoards(), actual.getNumBoards());
+    for (uint32_t idx = 0; idx < expected.getNumBoards(); idx++) {
+      String id = boardId(idx);
+      const Board* board = expected.getBoard(expected.findBoard(id.c_str()));
+      const Board* restored = actual.getBoard(actual.findBoard(id.c_str()));
+      ASSERT_NE(nullptr, board);
+      ASSERT_NE(nullptr, restored) << id.c_str();
+      EXPECT_EQ(board->getName(), restored->getName());
+      EXPECT_EQ(board->getUrl(), restored->getUrl());
+      EXPECT_EQ(board->getVersion(), restored->getVersion());
+    }
+  }
+
+  class Storages : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      Preferences::reset();
+      mock::resetLog();
+      mock::setLogCapture(true);
+      char directory[] = "/tmp/autodarts_storage_XXXXXX";
+      ASSERT_NE(nullptr, mkdtemp(directory));
+      _root = directory;
+      _fs.reset(new fs::FS(_root));
+    }
+
+    void TearDown() override {
+      mock::setLogCapture(false);
+      for (const char* name : {"/boardlist", "/etag", "/token"}) {
+        _fs->remove(name);
+      }
+      rmdir(_root.c_str());
+    }
+
+    std::string _root;
+    std::unique_ptr<fs::FS> _fs;
+  };
+
+} // namespace
+
+// The list is streamed, so the heap needed does not grow with the number of boards
+TEST_F(Storages, FileStorageKeeps500Boards) {
+  FileStorage storage(*_fs);
+  Client client;
+  client.setStorage(&storage);
+  addBoards(client, 500);
+
+  mock::resetHeapPeak();
+  int64_t before = mock::heapStats().liveBytes;
+  ASSERT_TRUE(client.persist());
+  int64_t persistPeak = mock::heapStats().peakBytes - before;
+
+  printf("500 boards: file %zu bytes, persist peak %lld bytes of heap\n", _fs->open("/boardlist").size(),
+         static_cast<long long>(persistPeak));
+
+  Client restored;
+  restored.setStorage(&storage);
+  ASSERT_TRUE(restored.restore(false));
+
+  expectSameBoards(client, restored);
+  EXPECT_LT(persistPeak, 4096);
+  EXPECT_EQ(0u, mock::logCount(mock::LOG_ERROR));
+}
+
+// A single NVS string stops at 4000 bytes, about 35 boards
+TEST_F(Storages, PreferencesKeepMoreBoardsThanOneString) {
+  PreferencesStorage storage;
+  Client client;
+  client.setStorage(&storage);
+  addBoards(client, 100);
+  ASSERT_TRUE(client.persist());
+  EXPECT_EQ(0u, Preferences::getNumFailedWrites());
+
+  Client restored;
+  restored.setStorage(&storage);
+  ASSERT_TRUE(restored.restore(false));
+  expectSameBoards(client, restored);
+
+  // A shorter list drops the chunks that are no longer used
+  Client shorter;
+  shorter.setStorage(&storage);
+  addBoards(shorter, 3);
+  ASSERT_TRUE(shorter.persist());
+  Preferences preferences;
+  preferences.begin("autodarts", true);
+  EXPECT_FALSE(preferences.isKey("boardlist.1"));
+  preferences.end();
+
+  Client restoredShorter;
+  restoredShorter.setStorage(&storage);
+  ASSERT_TRUE(restoredShorter.restore(false));
+  expectSameBoards(shorter, restoredShorter);
+}
+
+TEST_F(Storages, PreferencesCapacity) {
+  PreferencesStorage storage;
+  uint32_t fits = 0;
+  for (uint32_t count = 10; count <= 500; count += 10) {
+    Client client;
+    client.setStorage(&storage);
+    addBoards(client, count);
+    if (!client.persist()) {
+      break;
+    }
+    fits = count;
+  }
+  printf("16 KB of free NVS keep up to %u boards\n", fits);
+  EXPECT_GE(fits, 100u);
+}
+
+// A list that does not fit fails loudly and leaves no partial list behind
+TEST_F(Storages, FullPreferencesFailAndLog) {
+  PreferencesStorage storage;
+  Client small;
+  small.setStorage(&storage);
+  addBoards(small, 5);
+  ASSERT_TRUE(small.persist());
+
+  Client client;
+  client.setStorage(&storage);
+  addBoards(client, 500);
+  EXPECT_FALSE(client.persist());
+  EXPECT_GT(Preferences::getNumFailedWrites(), 0u);
+  EXPECT_EQ(1u, mock::logCount(mock::LOG_ERROR));
+  EXPECT_NE(std::string::npos, mock::lastLog(mock::LOG_ERROR).find("Could not store 500 boards"));
+
+  Client restored;
+  restored.setStorage(&storage);
+  EXPECT_FALSE(restored.restore(false));
+  EXPECT_EQ(0u, restored.getNumBoards());
+}
+
+TEST_F(Storages, EmptyListRoundTrip) {
+  FileStorage storage(*_fs);
+  Client client;
+  client.setStorage(&storage);
+  ASSERT_TRUE(client.persist());
+
+  Client restored;
+  restored.setStorage(&storage);
+  EXPECT_TRUE(restored.restore(false));
+  EXPECT_EQ(0u, restored.getNumBoards());
+}